@@ -18,6 +18,8 @@
  *                                                                   USA
  */
 
+#include <pthread.h>
+
 #include "dtc.h"
 
 #ifdef TRACE_CHECKS
@@ -49,11 +51,17 @@ struct check {
 	bool warn, error;
 	enum checkstatus status;
 	bool inprogress;
+	bool selected;
+	bool fixup;		/* modifies the tree, so never run in parallel */
+	int level;
+	int pos;		/* position in its level, for message order */
+	int node_index;		/* preorder index of the node being checked */
+	int num_msgs;
 	int num_prereqs;
 	struct check **prereq;
 };
 
-#define CHECK_ENTRY(_nm, _fn, _d, _w, _e, ...)	       \
+#define CHECK_ENTRY(_nm, _fn, _d, _w, _e, _fx, ...)	       \
 	static struct check *_nm##_prereqs[] = { __VA_ARGS__ }; \
 	static struct check _nm = { \
 		.name = #_nm, \
@@ -61,16 +69,77 @@ struct check {
 		.data = (_d), \
 		.warn = (_w), \
 		.error = (_e), \
+		.fixup = (_fx), \
 		.status = UNCHECKED, \
 		.num_prereqs = ARRAY_SIZE(_nm##_prereqs), \
 		.prereq = _nm##_prereqs, \
 	};
 #define WARNING(_nm, _fn, _d, ...) \
-	CHECK_ENTRY(_nm, _fn, _d, true, false, __VA_ARGS__)
+	CHECK_ENTRY(_nm, _fn, _d, true, false, false, __VA_ARGS__)
 #define ERROR(_nm, _fn, _d, ...) \
-	CHECK_ENTRY(_nm, _fn, _d, false, true, __VA_ARGS__)
+	CHECK_ENTRY(_nm, _fn, _d, false, true, false, __VA_ARGS__)
 #define CHECK(_nm, _fn, _d, ...) \
-	CHECK_ENTRY(_nm, _fn, _d, false, false, __VA_ARGS__)
+	CHECK_ENTRY(_nm, _fn, _d, false, false, false, __VA_ARGS__)
+#define WARNING_FIXUP(_nm, _fn, _d, ...) \
+	CHECK_ENTRY(_nm, _fn, _d, true, false, true, __VA_ARGS__)
+#define ERROR_FIXUP(_nm, _fn, _d, ...) \
+	CHECK_ENTRY(_nm, _fn, _d, false, true, true, __VA_ARGS__)
+
+/*
+ * While checks run in parallel, their messages are held back, then
+ * printed in the order a single thread would have produced them.
+ */
+struct deferred_msg {
+	struct check *c;
+	int node_index, pos, seq;
+	char *msg;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	bool active;
+	struct deferred_msg *msgs;
+	int num, size;
+} deferred = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void PRINTF(2, 0) defer_msg(struct check *c, const char *fmt,
+				   va_list ap)
+{
+	struct deferred_msg *m;
+	va_list aq;
+	char *msg;
+	int len;
+
+	va_copy(aq, ap);
+	len = vsnprintf(NULL, 0, fmt, aq);
+	va_end(aq);
+	msg = xmalloc(len + 1);
+	vsnprintf(msg, len + 1, fmt, ap);
+
+	pthread_mutex_lock(&deferred.lock);
+	if (deferred.num == deferred.size) {
+		deferred.size = deferred.size ? 2 * deferred.size : 64;
+		deferred.msgs = xrealloc(deferred.msgs, deferred.size
+					 * sizeof(*deferred.msgs));
+	}
+	m = &deferred.msgs[deferred.num++];
+	m->c = c;
+	m->node_index = c->node_index;
+	m->pos = c->pos;
+	m->seq = c->num_msgs++;
+	m->msg = msg;
+	pthread_mutex_unlock(&deferred.lock);
+}
+
+static void print_msg(struct check *c, struct dt_info *dti,
+		      const char *msg)
+{
+	fprintf(stderr, "%s: %s (%s): %s\n",
+		strcmp(dti->outname, "-") ? dti->outname : "<stdout>",
+		(c->error) ? "ERROR" : "Warning", c->name, msg);
+}
 
 static inline void  PRINTF(3, 4) check_msg(struct check *c, struct dt_info *dti,
 					   const char *fmt, ...)
@@ -80,15 +149,43 @@ static inline void  PRINTF(3, 4) check_msg(struct check *c, struct dt_info *dti,
 
 	if ((c->warn && (quiet < 1))
 	    || (c->error && (quiet < 2))) {
-		fprintf(stderr, "%s: %s (%s): ",
-			strcmp(dti->outname, "-") ? dti->outname : "<stdout>",
-			(c->error) ? "ERROR" : "Warning", c->name);
-		vfprintf(stderr, fmt, ap);
-		fprintf(stderr, "\n");
+		if (deferred.active) {
+			defer_msg(c, fmt, ap);
+		} else {
+			fprintf(stderr, "%s: %s (%s): ",
+				strcmp(dti->outname, "-") ? dti->outname : "<stdout>",
+				(c->error) ? "ERROR" : "Warning", c->name);
+			vfprintf(stderr, fmt, ap);
+			fprintf(stderr, "\n");
+		}
 	}
 	va_end(ap);
 }
 
+static int cmp_deferred_msg(const void *ax, const void *bx)
+{
+	const struct deferred_msg *a = ax, *b = bx;
+
+	if (a->node_index != b->node_index)
+		return a->node_index - b->node_index;
+	if (a->pos != b->pos)
+		return a->pos - b->pos;
+	return a->seq - b->seq;
+}
+
+static void flush_deferred_msgs(struct dt_info *dti)
+{
+	int i;
+
+	qsort(deferred.msgs, deferred.num, sizeof(*deferred.msgs),
+	      cmp_deferred_msg);
+	for (i = 0; i < deferred.num; i++) {
+		print_msg(deferred.msgs[i].c, dti, deferred.msgs[i].msg);
+		free(deferred.msgs[i].msg);
+	}
+	deferred.num = 0;
+}
+
 #define FAIL(c, dti, ...)						\
 	do {								\
 		TRACE((c), "\t\tFAILED at %s:%d", __FILE__, __LINE__);	\
@@ -96,56 +193,101 @@ static inline void  PRINTF(3, 4) check_msg(struct check *c, struct dt_info *dti,
 		check_msg((c), dti, __VA_ARGS__);			\
 	} while (0)
 
-static void check_nodes_props(struct check *c, struct dt_info *dti, struct node *node)
+/*
+ * Rather than walking the tree once per check, the checks are grouped
+ * into levels: a check's level is one more than that of its deepest
+ * prerequisite.  All the checks in a level are run together in a single
+ * walk of the tree, once every lower level has completed.
+ */
+static int check_level(struct check *c)
 {
-	struct node *child;
+	int i, level;
 
-	TRACE(c, "%s", node->fullpath);
-	if (c->fn)
-		c->fn(c, dti, node);
+	assert(!c->inprogress);
 
-	for_each_child(node, child)
-		check_nodes_props(c, dti, child);
+	if (c->level)
+		return c->level;
+
+	c->inprogress = true;
+	c->level = 1;
+	for (i = 0; i < c->num_prereqs; i++) {
+		level = check_level(c->prereq[i]) + 1;
+		if (level > c->level)
+			c->level = level;
+	}
+	c->inprogress = false;
+
+	return c->level;
 }
 
-static bool run_check(struct check *c, struct dt_info *dti)
+/* Add c and its prerequisites to the run list, prerequisites first */
+static void select_check(struct check *c, struct check **run, int *n)
 {
-	struct node *dt = dti->dt;
-	bool error = false;
 	int i;
 
-	assert(!c->inprogress);
+	if (c->selected)
+		return;
 
-	if (c->status != UNCHECKED)
-		goto out;
+	c->selected = true;
+	for (i = 0; i < c->num_prereqs; i++)
+		select_check(c->prereq[i], run, n);
+	run[(*n)++] = c;
+}
 
-	c->inprogress = true;
+/* Returns the preorder index following node's subtree */
+static int check_nodes_props(struct check **batch, int n,
+			     struct dt_info *dti, struct node *node, int index)
+{
+	struct node *child;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		TRACE(batch[i], "%s", node->fullpath);
+		batch[i]->node_index = index;
+		batch[i]->fn(batch[i], dti, node);
+	}
+	index++;
+
+	for_each_child(node, child)
+		index = check_nodes_props(batch, n, dti, child, index);
+
+	return index;
+}
+
+/* Returns 1 if the check would once have needed its own tree walk */
+static int start_check(struct check *c, struct dt_info *dti,
+		       struct check **batch, int *n)
+{
+	int i;
 
 	for (i = 0; i < c->num_prereqs; i++) {
 		struct check *prq = c->prereq[i];
-		error = error || run_check(prq, dti);
+
 		if (prq->status != PASSED) {
 			c->status = PREREQ;
 			check_msg(c, dti, "Failed prerequisite '%s'",
-				  c->prereq[i]->name);
+				  prq->name);
 		}
 	}
 
 	if (c->status != UNCHECKED)
-		goto out;
+		return 0;
 
-	check_nodes_props(c, dti, dt);
+	if (c->fn) {
+		c->pos = *n;
+		batch[(*n)++] = c;
+	} else
+		c->status = PASSED;
 
+	return 1;
+}
+
+static void finish_check(struct check *c)
+{
 	if (c->status == UNCHECKED)
 		c->status = PASSED;
 
 	TRACE(c, "\tCompleted, status %d", c->status);
-
-out:
-	c->inprogress = false;
-	if ((c->status != PASSED) && (c->error))
-		error = true;
-	return error;
 }
 
 /*
@@ -202,35 +344,75 @@ static void check_is_cell(struct check *c, struct dt_info *dti,
  * Structural check functions
  */
 
+/*
+ * The duplicate name checks count the names in a node first, so that
+ * they are linear in the number of siblings.  Each entry is then
+ * reported once for every later entry of the same name, as a pairwise
+ * comparison would.
+ */
+static void count_name(struct strmap *counts, const char *name)
+{
+	void **slot = strmap_slot(counts, name);
+
+	*slot = (void *)((uintptr_t)*slot + 1);
+}
+
+/* Returns the number of entries named name after this one */
+static uintptr_t uncount_name(struct strmap *counts, const char *name)
+{
+	void **slot = strmap_slot(counts, name);
+
+	*slot = (void *)((uintptr_t)*slot - 1);
+	return (uintptr_t)*slot;
+}
+
 static void check_duplicate_node_names(struct check *c, struct dt_info *dti,
 				       struct node *node)
 {
-	struct node *child, *child2;
+	struct strmap counts = { 0 };
+	struct node *child;
+	uintptr_t later;
 
-	for_each_child(node, child)
-		for (child2 = child->next_sibling;
-		     child2;
-		     child2 = child2->next_sibling)
-			if (streq(child->name, child2->name))
-				FAIL(c, dti, "Duplicate node name %s",
-				     child->fullpath);
+	if (!node->children || !node->children->next_sibling)
+		return;
+
+	for_each_child_withdel(node, child)
+		count_name(&counts, child->name);
+
+	for_each_child_withdel(node, child) {
+		later = uncount_name(&counts, child->name);
+		if (child->deleted)
+			continue;
+		while (later--)
+			FAIL(c, dti, "Duplicate node name %s",
+			     child->fullpath);
+	}
+
+	strmap_free(&counts);
 }
 ERROR(duplicate_node_names, check_duplicate_node_names, NULL);
 
 static void check_duplicate_property_names(struct check *c, struct dt_info *dti,
 					   struct node *node)
 {
-	struct property *prop, *prop2;
+	struct strmap counts = { 0 };
+	struct property *prop;
+	uintptr_t later;
+
+	if (!node->proplist || !node->proplist->next)
+		return;
+
+	for_each_property(node, prop)
+		count_name(&counts, prop->name);
 
 	for_each_property(node, prop) {
-		for (prop2 = prop->next; prop2; prop2 = prop2->next) {
-			if (prop2->deleted)
-				continue;
-			if (streq(prop->name, prop2->name))
-				FAIL(c, dti, "Duplicate property name %s in %s",
-				     prop->name, node->fullpath);
-		}
+		later = uncount_name(&counts, prop->name);
+		while (later--)
+			FAIL(c, dti, "Duplicate property name %s in %s",
+			     prop->name, node->fullpath);
 	}
+
+	strmap_free(&counts);
 }
 ERROR(duplicate_property_names, check_duplicate_property_names, NULL);
 
@@ -353,27 +535,18 @@ static void check_duplicate_label(struct check *c, struct dt_info *dti,
 				  const char *label, struct node *node,
 				  struct property *prop, struct marker *mark)
 {
-	struct node *dt = dti->dt;
-	struct node *othernode = NULL;
-	struct property *otherprop = NULL;
-	struct marker *othermark = NULL;
+	struct label_target *other;
 
-	othernode = get_node_by_label(dt, label);
-
-	if (!othernode)
-		otherprop = get_property_by_label(dt, label, &othernode);
-	if (!othernode)
-		othermark = get_marker_label(dt, label, &othernode,
-					       &otherprop);
-
-	if (!othernode)
+	other = dti_get_label(dti, label);
+	if (!other)
 		return;
 
-	if ((othernode != node) || (otherprop != prop) || (othermark != mark))
+	if ((other->node != node) || (other->prop != prop)
+	    || (other->marker != mark))
 		FAIL(c, dti, "Duplicate label '%s' on " DESCLABEL_FMT
 		     " and " DESCLABEL_FMT,
 		     label, DESCLABEL_ARGS(node, prop, mark),
-		     DESCLABEL_ARGS(othernode, otherprop, othermark));
+		     DESCLABEL_ARGS(other->node, other->prop, other->marker));
 }
 
 static void check_duplicate_label_node(struct check *c, struct dt_info *dti,
@@ -400,7 +573,6 @@ ERROR(duplicate_label, check_duplicate_label_node, NULL);
 static cell_t check_phandle_prop(struct check *c, struct dt_info *dti,
 				 struct node *node, const char *propname)
 {
-	struct node *root = dti->dt;
 	struct property *prop;
 	struct marker *m;
 	cell_t phandle;
@@ -418,7 +590,7 @@ static cell_t check_phandle_prop(struct check *c, struct dt_info *dti,
 	m = prop->val.markers;
 	for_each_marker_of_type(m, REF_PHANDLE) {
 		assert(m->offset == 0);
-		if (node != get_node_by_ref(root, m->ref))
+		if (node != dti_get_node_by_ref(dti, m->ref))
 			/* "Set this node's phandle equal to some
 			 * other node's phandle".  That's nonsensical
 			 * by construction. */ {
@@ -478,7 +650,7 @@ static void check_explicit_phandles(struct check *c, struct dt_info *dti,
 
 	node->phandle = phandle;
 }
-ERROR(explicit_phandles, check_explicit_phandles, NULL);
+ERROR_FIXUP(explicit_phandles, check_explicit_phandles, NULL);
 
 static void check_name_properties(struct check *c, struct dt_info *dti,
 				  struct node *node)
@@ -502,13 +674,12 @@ static void check_name_properties(struct check *c, struct dt_info *dti,
 		/* The name property is correct, and therefore redundant.
 		 * Delete it */
 		*pp = prop->next;
-		free(prop->name);
+		unindex_node(node);
 		data_free(prop->val);
-		free(prop);
 	}
 }
 ERROR_IF_NOT_STRING(name_is_string, "name");
-ERROR(name_properties, check_name_properties, NULL, &name_is_string);
+ERROR_FIXUP(name_properties, check_name_properties, NULL, &name_is_string);
 
 /*
  * Reference fixup functions
@@ -517,7 +688,6 @@ ERROR(name_properties, check_name_properties, NULL, &name_is_string);
 static void fixup_phandle_references(struct check *c, struct dt_info *dti,
 				     struct node *node)
 {
-	struct node *dt = dti->dt;
 	struct property *prop;
 
 	for_each_property(node, prop) {
@@ -528,7 +698,7 @@ static void fixup_phandle_references(struct check *c, struct dt_info *dti,
 		for_each_marker_of_type(m, REF_PHANDLE) {
 			assert(m->offset + sizeof(cell_t) <= prop->val.len);
 
-			refnode = get_node_by_ref(dt, m->ref);
+			refnode = dti_get_node_by_ref(dti, m->ref);
 			if (! refnode) {
 				if (!(dti->dtsflags & DTSF_PLUGIN))
 					FAIL(c, dti, "Reference to non-existent node or "
@@ -539,18 +709,17 @@ static void fixup_phandle_references(struct check *c, struct dt_info *dti,
 				continue;
 			}
 
-			phandle = get_node_phandle(dt, refnode);
+			phandle = get_node_phandle(dti, refnode);
 			*((fdt32_t *)(prop->val.val + m->offset)) = cpu_to_fdt32(phandle);
 		}
 	}
 }
-ERROR(phandle_references, fixup_phandle_references, NULL,
+ERROR_FIXUP(phandle_references, fixup_phandle_references, NULL,
       &duplicate_node_names, &explicit_phandles);
 
 static void fixup_path_references(struct check *c, struct dt_info *dti,
 				  struct node *node)
 {
-	struct node *dt = dti->dt;
 	struct property *prop;
 
 	for_each_property(node, prop) {
@@ -561,7 +730,7 @@ static void fixup_path_references(struct check *c, struct dt_info *dti,
 		for_each_marker_of_type(m, REF_PATH) {
 			assert(m->offset <= prop->val.len);
 
-			refnode = get_node_by_ref(dt, m->ref);
+			refnode = dti_get_node_by_ref(dti, m->ref);
 			if (!refnode) {
 				FAIL(c, dti, "Reference to non-existent node or label \"%s\"\n",
 				     m->ref);
@@ -574,7 +743,7 @@ static void fixup_path_references(struct check *c, struct dt_info *dti,
 		}
 	}
 }
-ERROR(path_references, fixup_path_references, NULL, &duplicate_node_names);
+ERROR_FIXUP(path_references, fixup_path_references, NULL, &duplicate_node_names);
 
 /*
  * Semantic checks
@@ -603,7 +772,7 @@ static void fixup_addr_size_cells(struct check *c, struct dt_info *dti,
 	if (prop)
 		node->size_cells = propval_cell(prop);
 }
-WARNING(addr_size_cells, fixup_addr_size_cells, NULL,
+WARNING_FIXUP(addr_size_cells, fixup_addr_size_cells, NULL,
 	&address_cells_is_cell, &size_cells_is_cell);
 
 #define node_addr_cells(n) \
@@ -732,7 +901,7 @@ static void check_pci_bridge(struct check *c, struct dt_info *dti, struct node *
 		FAIL(c, dti, "Node %s bus-range maximum bus number must be less than 256",
 			     node->fullpath);
 }
-WARNING(pci_bridge, check_pci_bridge, NULL,
+WARNING_FIXUP(pci_bridge, check_pci_bridge, NULL,
 	&device_type_is_string, &addr_size_cells);
 
 static void check_pci_device_bus_num(struct check *c, struct dt_info *dti, struct node *node)
@@ -839,7 +1008,7 @@ static void check_simple_bus_bridge(struct check *c, struct dt_info *dti, struct
 	if (node_is_compatible(node, "simple-bus"))
 		node->bus = &simple_bus;
 }
-WARNING(simple_bus_bridge, check_simple_bus_bridge, NULL, &addr_size_cells);
+WARNING_FIXUP(simple_bus_bridge, check_simple_bus_bridge, NULL, &addr_size_cells);
 
 static void check_simple_bus_reg(struct check *c, struct dt_info *dti, struct node *node)
 {
@@ -1051,18 +1220,141 @@ void parse_checks_option(bool warn, bool error, const char *arg)
 	die("Unrecognized check name \"%s\"\n", name);
 }
 
+struct check_pool {
+	struct dt_info *dti;
+	struct check **checks;
+	int num, next;
+	pthread_mutex_t lock;
+};
+
+static void *check_worker(void *arg)
+{
+	struct check_pool *pool = arg;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->num)
+			break;
+		check_nodes_props(&pool->checks[i], 1, pool->dti,
+				  pool->dti->dt, 0);
+	}
+
+	return NULL;
+}
+
+/*
+ * Run one level of checks on up to jobs threads: first the fixups
+ * together on this thread, then each of the others in its own walk of
+ * the tree.  Returns the number of tree walks made.
+ */
+static int run_checks_parallel(struct check **batch, int n,
+			       struct dt_info *dti)
+{
+	struct check *fixups[ARRAY_SIZE(check_table)];
+	struct check *others[ARRAY_SIZE(check_table)];
+	struct check_pool pool;
+	pthread_t *threads;
+	int num_fixups = 0, num_threads = 0, walks = 0;
+	int i, err;
+
+	for (i = 0; i < n; i++)
+		if (batch[i]->fixup)
+			fixups[num_fixups++] = batch[i];
+		else
+			others[i - num_fixups] = batch[i];
+
+	/* The checks look labels up, so build the tables beforehand */
+	dti_build_symbols(dti);
+	deferred.active = true;
+
+	if (num_fixups) {
+		check_nodes_props(fixups, num_fixups, dti, dti->dt, 0);
+		walks++;
+	}
+
+	pool.dti = dti;
+	pool.checks = others;
+	pool.num = n - num_fixups;
+	pool.next = 0;
+	pthread_mutex_init(&pool.lock, NULL);
+
+	threads = xmalloc(jobs * sizeof(*threads));
+	while ((num_threads < jobs - 1) && (num_threads + 1 < pool.num)) {
+		err = pthread_create(&threads[num_threads], NULL,
+				     check_worker, &pool);
+		if (err)
+			die("Couldn't start check thread: %s\n",
+			    strerror(err));
+		num_threads++;
+	}
+	check_worker(&pool);
+	for (i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_mutex_destroy(&pool.lock);
+	walks += pool.num;
+
+	deferred.active = false;
+	flush_deferred_msgs(dti);
+
+	return walks;
+}
+
 void process_checks(bool force, struct dt_info *dti)
 {
+	struct check *run[ARRAY_SIZE(check_table)];
+	struct check *batch[ARRAY_SIZE(check_table)];
+	int num_run = 0, num_batch;
+	int level, max_level = 0;
+	int walks = 0, unfused = 0;
+	bool error = false;
 	int i;
-	int error = 0;
 
 	for (i = 0; i < ARRAY_SIZE(check_table); i++) {
 		struct check *c = check_table[i];
 
 		if (c->warn || c->error)
-			error = error || run_check(c, dti);
+			select_check(c, run, &num_run);
 	}
 
+	for (i = 0; i < num_run; i++)
+		if (check_level(run[i]) > max_level)
+			max_level = run[i]->level;
+
+	for (level = 1; level <= max_level; level++) {
+		num_batch = 0;
+		for (i = 0; i < num_run; i++)
+			if (run[i]->level == level)
+				unfused += start_check(run[i], dti,
+						       batch, &num_batch);
+
+		if (num_batch && (jobs > 1)) {
+			walks += run_checks_parallel(batch, num_batch, dti);
+		} else if (num_batch) {
+			check_nodes_props(batch, num_batch, dti, dti->dt, 0);
+			walks++;
+		}
+
+		for (i = 0; i < num_batch; i++)
+			finish_check(batch[i]);
+
+		/* As before, don't carry on past the first errors */
+		for (i = 0; i < num_run; i++)
+			if ((run[i]->level == level)
+			    && (run[i]->status != PASSED) && run[i]->error)
+				error = true;
+		if (error)
+			break;
+	}
+
+	if (show_stats)
+		fprintf(stderr, "Checks: %d run in %d tree walks"
+			" (%d unfused)\n", num_run, walks, unfused);
+
 	if (error) {
 		if (!force) {
 			fprintf(stderr, "ERROR: Input tree has errors, aborting "
@@ -0,0 +1,2 @@
+#include <stdio.h>
+int main(void) { fprintf(stderr, "convert-dtsv0 unavailable (no flex)\n"); return 1; }
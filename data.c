@@ -20,40 +20,38 @@
 
 #include "dtc.h"
 
+/* The markers, like the rest of the tree, belong to the tree's arena */
 void data_free(struct data d)
 {
-	struct marker *m, *nm;
-
-	m = d.markers;
-	while (m) {
-		nm = m->next;
-		free(m->ref);
-		free(m);
-		m = nm;
-	}
-
-	if (d.val)
+	/* Borrowed values (see data_borrow_mem()) aren't ours to free */
+	if (d.size)
 		free(d.val);
 }
 
 struct data data_grow_for(struct data d, int xlen)
 {
-	struct data nd;
 	int newsize;
 
-	if (xlen == 0)
+	if ((d.len + xlen) <= d.size)
 		return d;
 
-	nd = d;
+	/* Grow geometrically, so that appending is amortized linear */
+	newsize = 2 * d.size;
+	if (newsize < (d.len + xlen))
+		newsize = d.len + xlen;
 
-	newsize = xlen;
+	if (d.size || !d.val) {
+		d.val = xrealloc(d.val, newsize);
+	} else {
+		/* Copy a borrowed value before it is changed */
+		char *val = xmalloc(newsize);
 
-	while ((d.len + xlen) > newsize)
-		newsize *= 2;
-
-	nd.val = xrealloc(d.val, newsize);
+		memcpy(val, d.val, d.len);
+		d.val = val;
+	}
+	d.size = newsize;
 
-	return nd;
+	return d;
 }
 
 struct data data_copy_mem(const char *mem, int len)
@@ -68,6 +66,20 @@ struct data data_copy_mem(const char *mem, int len)
 	return d;
 }
 
+struct data data_borrow_mem(char *mem, int len)
+{
+	struct data d = empty_data;
+
+	if (len == 0)
+		return d;
+
+	/* size stays 0: mem is copied by the first data_grow_for() */
+	d.val = mem;
+	d.len = len;
+
+	return d;
+}
+
 struct data data_copy_escape_string(const char *s, int len)
 {
 	int i = 0;
@@ -117,6 +129,21 @@ struct data data_copy_file(FILE *f, size_t maxlen)
 	return d;
 }
 
+/*
+ * Like data_copy_file(), but refers to the file's contents in place when
+ * it can be mapped, so that large files aren't read into memory.
+ */
+struct data data_map_file(FILE *f, size_t maxlen)
+{
+	size_t len;
+	char *val = tree_map_file(f, maxlen, &len);
+
+	if (!val)
+		return data_copy_file(f, maxlen);
+
+	return data_borrow_mem(val, len);
+}
+
 struct data data_append_data(struct data d, const void *p, int len)
 {
 	d = data_grow_for(d, len);
@@ -140,14 +167,17 @@ struct data data_insert_at_marker(struct data d, struct marker *m,
 	return d;
 }
 
-static struct data data_append_markers(struct data d, struct marker *m)
+static struct data data_append_markers(struct data d, struct marker *first,
+				       struct marker *last)
 {
-	struct marker **mp = &d.markers;
+	if (!first)
+		return d;
 
-	/* Find the end of the markerlist */
-	while (*mp)
-		mp = &((*mp)->next);
-	*mp = m;
+	if (d.last_marker)
+		d.last_marker->next = first;
+	else
+		d.markers = first;
+	d.last_marker = last;
 	return d;
 }
 
@@ -156,13 +186,24 @@ struct data data_merge(struct data d1, struct data d2)
 	struct data d;
 	struct marker *m2 = d2.markers;
 
-	d = data_append_markers(data_append_data(d1, d2.val, d2.len), m2);
+	if (d1.len == 0) {
+		/* Keep d2's value rather than copying it, it may be
+		 * borrowed.  Any markers of d1 are at offset 0. */
+		d = d2;
+		d.markers = d1.markers;
+		d.last_marker = d1.last_marker;
+		d = data_append_markers(d, m2, d2.last_marker);
+		data_free(d1);
+		return d;
+	}
+
+	d = data_append_markers(data_append_data(d1, d2.val, d2.len),
+				m2, d2.last_marker);
 
 	/* Adjust for the length of d1 */
 	for_each_marker(m2)
 		m2->offset += d1.len;
 
-	d2.markers = NULL; /* So data_free() doesn't clobber them */
 	data_free(d2);
 
 	return d;
@@ -241,13 +282,12 @@ struct data data_add_marker(struct data d, enum markertype type, char *ref)
 {
 	struct marker *m;
 
-	m = xmalloc(sizeof(*m));
+	m = tree_alloc(sizeof(*m));
 	m->offset = d.len;
 	m->type = type;
 	m->ref = ref;
-	m->next = NULL;
 
-	return data_append_markers(d, m);
+	return data_append_markers(d, m, m);
 }
 
 bool data_is_one_string(struct data d)
@@ -0,0 +1,523 @@
+/* Hand-written emulation of dtc-lexer.l for sandboxes without flex.
+ * NOT part of the repo; used only to build dtc for local testing. */
+#include "dtc.h"
+#include "srcpos.h"
+#include "dtc-parser.tab.h"
+
+extern bool treesource_error;
+FILE *yyin;
+
+enum { S_INITIAL, S_BYTESTRING, S_PROPNODENAME, S_V1 };
+static int state = S_INITIAL;
+
+struct buf {
+	char *s;
+	size_t len, pos;
+	struct buf *prev;
+};
+static struct buf *cur;
+static char *yytext;
+static int yyleng;
+
+static struct buf *load(FILE *f)
+{
+	struct buf *b = xmalloc(sizeof(*b));
+	size_t cap = 4096;
+	b->s = xmalloc(cap + 1);
+	b->len = 0;
+	for (;;) {
+		size_t n;
+		if (b->len == cap) {
+			cap *= 2;
+			b->s = xrealloc(b->s, cap + 1);
+		}
+		n = fread(b->s + b->len, 1, cap - b->len, f);
+		if (n == 0)
+			break;
+		b->len += n;
+	}
+	b->s[b->len] = '\0';
+	b->pos = 0;
+	b->prev = NULL;
+	return b;
+}
+
+static void PRINTF(1, 2) lexical_error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	srcpos_verror(&yylloc, "Lexical error", fmt, ap);
+	va_end(ap);
+
+	treesource_error = true;
+}
+
+#define C(i) ((p + (i)) < n ? (unsigned char)s[p + (i)] : -1)
+
+static const char *s;
+static size_t n;
+
+static int ispnc(int c)
+{
+	return c >= 0 && (isalnum(c) || strchr(",._+*#?@-", c));
+}
+static int islab1(int c) { return c >= 0 && (isalpha(c) || c == '_'); }
+static int islab(int c) { return c >= 0 && (isalnum(c) || c == '_'); }
+static int isws(int c) { return c >= 0 && isspace(c); }
+
+static size_t m_string(size_t p)
+{
+	size_t q;
+	if (C(0) != '"')
+		return 0;
+	q = p + 1;
+	while (q < n) {
+		if (s[q] == '"')
+			return q + 1 - p;
+		if (s[q] == '\\') {
+			if (q + 1 >= n || s[q + 1] == '\n')
+				return 0;
+			q += 2;
+		} else
+			q++;
+	}
+	return 0;
+}
+
+static size_t m_lit(size_t p, const char *lit)
+{
+	size_t l = strlen(lit);
+	if (p + l <= n && memcmp(s + p, lit, l) == 0)
+		return l;
+	return 0;
+}
+
+static size_t m_include(size_t p)
+{
+	size_t q, l;
+	if (!m_lit(p, "/include/"))
+		return 0;
+	q = p + 9;
+	while (q < n && isws((unsigned char)s[q]))
+		q++;
+	l = m_string(q);
+	return l ? q + l - p : 0;
+}
+
+static size_t m_linedir(size_t p)
+{
+	size_t q = p, q0, l;
+	if (!(p == 0 || s[p - 1] == '\n'))
+		return 0;
+	if (s[q] != '#')
+		return 0;
+	q++;
+	if (m_lit(q, "line"))
+		q += 4;
+	q0 = q;
+	while (q < n && (s[q] == ' ' || s[q] == '\t'))
+		q++;
+	if (q == q0)
+		return 0;
+	q0 = q;
+	while (q < n && isdigit((unsigned char)s[q]))
+		q++;
+	if (q == q0)
+		return 0;
+	q0 = q;
+	while (q < n && (s[q] == ' ' || s[q] == '\t'))
+		q++;
+	if (q == q0)
+		return 0;
+	l = m_string(q);
+	if (!l)
+		return 0;
+	q += l;
+	{
+		size_t r = q, r0;
+		while (r < n && (s[r] == ' ' || s[r] == '\t'))
+			r++;
+		if (r > q) {
+			r0 = r;
+			while (r < n && isdigit((unsigned char)s[r]))
+				r++;
+			if (r > r0)
+				q = r;
+		}
+	}
+	return q - p;
+}
+
+static size_t m_label(size_t p)
+{
+	size_t q = p;
+	if (!islab1(C(0)))
+		return 0;
+	q++;
+	while (q < n && islab((unsigned char)s[q]))
+		q++;
+	if (q < n && s[q] == ':')
+		return q + 1 - p;
+	return 0;
+}
+
+static size_t m_integer(size_t p)
+{
+	size_t q = p, best = 0, e;
+	/* decimal */
+	while (q < n && isdigit((unsigned char)s[q]))
+		q++;
+	if (q > p)
+		best = q;
+	if (C(0) == '0' && (C(1) == 'x' || C(1) == 'X')) {
+		q = p + 2;
+		while (q < n && isxdigit((unsigned char)s[q]))
+			q++;
+		if (q > p + 2)
+			best = q;
+	}
+	if (!best)
+		return 0;
+	e = best;
+	if (m_lit(e, "ULL"))
+		e += 3;
+	else if (m_lit(e, "UL") || m_lit(e, "LL"))
+		e += 2;
+	else if (m_lit(e, "U") || m_lit(e, "L"))
+		e += 1;
+	return e - p;
+}
+
+static size_t m_charlit(size_t p)
+{
+	size_t i, best = 0;
+	char *reach;
+	if (C(0) != '\'')
+		return 0;
+	reach = xmalloc(n - p + 2);
+	memset(reach, 0, n - p + 2);
+	reach[1] = 1;
+	for (i = p + 1; i < n; i++) {
+		if (!reach[i - p])
+			continue;
+		if (s[i] == '\'') {
+			best = i + 1 - p;
+		} else {
+			reach[i + 1 - p] = 1;
+		}
+		if (s[i] == '\\' && i + 1 < n && s[i + 1] == '\'')
+			reach[i + 2 - p] = 1;
+	}
+	free(reach);
+	return best;
+}
+
+static size_t m_ref(size_t p)
+{
+	size_t q;
+	if (C(0) != '&' || !islab1(C(1)))
+		return 0;
+	q = p + 2;
+	while (q < n && islab((unsigned char)s[q]))
+		q++;
+	return q - p;
+}
+
+static size_t m_pathref(size_t p)
+{
+	size_t q;
+	if (!m_lit(p, "&{/"))
+		return 0;
+	q = p + 3;
+	while (q < n && (ispnc((unsigned char)s[q]) || s[q] == '/'))
+		q++;
+	if (q < n && s[q] == '}')
+		return q + 1 - p;
+	return 0;
+}
+
+static size_t m_propnodename(size_t p)
+{
+	size_t q = p;
+	if (C(0) == '\\')
+		q++;
+	if (!(q < n && ispnc((unsigned char)s[q])))
+		return 0;
+	while (q < n && ispnc((unsigned char)s[q]))
+		q++;
+	return q - p;
+}
+
+static size_t m_ws(size_t p)
+{
+	size_t q = p;
+	while (q < n && isws((unsigned char)s[q]))
+		q++;
+	return q - p;
+}
+
+static size_t m_comment(size_t p)
+{
+	size_t q = p;
+	for (;;) {
+		const char *e;
+		if (!m_lit(q, "/*"))
+			break;
+		e = NULL;
+		{
+			size_t r;
+			for (r = q + 2; r + 1 < n; r++)
+				if (s[r] == '*' && s[r + 1] == '/') {
+					e = s + r;
+					break;
+				}
+		}
+		if (!e)
+			break;
+		q = (e - s) + 2;
+	}
+	return q - p;
+}
+
+static size_t m_linecomment(size_t p)
+{
+	size_t q = p;
+	for (;;) {
+		const char *nl;
+		if (!m_lit(q, "//"))
+			break;
+		nl = memchr(s + q, '\n', n - q);
+		if (!nl)
+			break;
+		q = (nl - s) + 1;
+	}
+	return q - p;
+}
+
+enum {
+	R_INCLUDE = 1, R_LINE, R_STRING, R_DTSV1, R_PLUGIN, R_MEMRES, R_BITS,
+	R_DELPROP, R_DELNODE, R_LABEL, R_INT, R_CHAR, R_REF, R_PATHREF,
+	R_BYTE, R_RBRACK, R_PNN, R_INCBIN, R_WS, R_COMMENT, R_LCOMMENT,
+	R_LSHIFT, R_RSHIFT, R_LE, R_GE, R_EQ, R_NE, R_AND, R_OR, R_ANY,
+};
+
+static bool at_statement_boundary(void);
+int yylex(void);
+static int lex_token(void)
+{
+	static const struct { const char *lit; int rule; } ops[] = {
+		{"<<", R_LSHIFT}, {">>", R_RSHIFT}, {"<=", R_LE}, {">=", R_GE},
+		{"==", R_EQ}, {"!=", R_NE}, {"&&", R_AND}, {"||", R_OR},
+	};
+
+	if (!cur) {
+		cur = load(yyin);
+	}
+
+	for (;;) {
+		size_t p, best = 0, l;
+		int rule = 0;
+		unsigned i;
+
+		if (cur->pos >= cur->len) {
+			struct buf *b = cur;
+			include_cache_end_file(current_srcfile, at_statement_boundary());
+			if (!srcfile_pop()) {
+				return 0;
+			}
+			cur = b->prev;
+			free(b->s);
+			free(b);
+			yyin = current_srcfile->f;
+			continue;
+		}
+		s = cur->s;
+		n = cur->len;
+		p = cur->pos;
+
+#define TRY(expr, r) do { l = (expr); if (l > best) { best = l; rule = (r); } } while (0)
+		TRY(m_include(p), R_INCLUDE);
+		TRY(m_linedir(p), R_LINE);
+		TRY(m_string(p), R_STRING);
+		TRY(m_lit(p, "/dts-v1/"), R_DTSV1);
+		TRY(m_lit(p, "/plugin/"), R_PLUGIN);
+		TRY(m_lit(p, "/memreserve/"), R_MEMRES);
+		TRY(m_lit(p, "/bits/"), R_BITS);
+		TRY(m_lit(p, "/delete-property/"), R_DELPROP);
+		TRY(m_lit(p, "/delete-node/"), R_DELNODE);
+		TRY(m_label(p), R_LABEL);
+		if (state == S_V1)
+			TRY(m_integer(p), R_INT);
+		TRY(m_charlit(p), R_CHAR);
+		TRY(m_ref(p), R_REF);
+		TRY(m_pathref(p), R_PATHREF);
+		if (state == S_BYTESTRING) {
+			TRY((isxdigit(C(0)) && isxdigit(C(1)) && C(0) >= 0 && C(1) >= 0) ? 2 : 0, R_BYTE);
+			TRY(C(0) == ']' ? 1 : 0, R_RBRACK);
+		}
+		if (state == S_PROPNODENAME)
+			TRY(m_propnodename(p), R_PNN);
+		if (state == S_INITIAL || state == S_V1)
+			TRY(m_lit(p, "/incbin/"), R_INCBIN);
+		TRY(m_ws(p), R_WS);
+		TRY(m_comment(p), R_COMMENT);
+		TRY(m_linecomment(p), R_LCOMMENT);
+		for (i = 0; i < ARRAY_SIZE(ops); i++)
+			TRY(m_lit(p, ops[i].lit), ops[i].rule);
+		TRY(C(0) != '\n' ? 1 : 0, R_ANY);
+#undef TRY
+
+		yyleng = best;
+		yytext = xrealloc(yytext, best + 1);
+		memcpy(yytext, s + p, best);
+		yytext[best] = '\0';
+		cur->pos += best;
+		srcpos_update(&yylloc, yytext, yyleng);
+
+		switch (rule) {
+		case R_INCLUDE: {
+			char *name = strchr(yytext, '\"') + 1;
+			struct buf *b;
+			yytext[yyleng-1] = '\0';
+			if (include_cache_dir && at_statement_boundary()) {
+				if (include_cache_push(name, &yylval.stmts))
+					return DT_INCLUDE_CACHED;
+			} else {
+				srcfile_push(name);
+			}
+			yyin = current_srcfile->f;
+			b = load(yyin);
+			b->prev = cur;
+			cur = b;
+			break;
+		}
+		case R_LINE: {
+			char *line, *fnstart, *fnend;
+			struct data fn;
+			line = yytext;
+			while (!isdigit((unsigned char)*line))
+				line++;
+			fnstart = memchr(yytext, '"', yyleng);
+			for (fnend = yytext + yyleng - 1; *fnend != '"'; fnend--)
+				;
+			fn = data_copy_escape_string(fnstart + 1, fnend - fnstart - 1);
+			if (memchr(fn.val, '\0', fn.len - 1))
+				lexical_error("nul in line number directive");
+			srcpos_set_line(xstrdup(fn.val), atoi(line) - 1);
+			data_free(fn);
+			break;
+		}
+		case R_STRING:
+			yylval.data = data_copy_escape_string(yytext+1, yyleng-2);
+			return DT_STRING;
+		case R_DTSV1:
+			state = S_V1;
+			return DT_V1;
+		case R_PLUGIN:
+			return DT_PLUGIN;
+		case R_MEMRES:
+			state = S_V1;
+			return DT_MEMRESERVE;
+		case R_BITS:
+			state = S_V1;
+			return DT_BITS;
+		case R_DELPROP:
+			state = S_PROPNODENAME;
+			return DT_DEL_PROP;
+		case R_DELNODE:
+			state = S_PROPNODENAME;
+			return DT_DEL_NODE;
+		case R_LABEL:
+			yylval.labelref = tree_strdup(yytext);
+			yylval.labelref[yyleng-1] = '\0';
+			return DT_LABEL;
+		case R_INT: {
+			char *e;
+			errno = 0;
+			yylval.integer = strtoull(yytext, &e, 0);
+			if (*e && e[strspn(e, "UL")])
+				lexical_error("Bad integer literal '%s'", yytext);
+			if (errno == ERANGE)
+				lexical_error("Integer literal '%s' out of range", yytext);
+			return DT_LITERAL;
+		}
+		case R_CHAR: {
+			struct data d;
+			d = data_copy_escape_string(yytext+1, yyleng-2);
+			if (d.len == 1) {
+				lexical_error("Empty character literal");
+				yylval.integer = 0;
+			} else {
+				yylval.integer = (unsigned char)d.val[0];
+				if (d.len > 2)
+					lexical_error("Character literal has %d"
+						      " characters instead of 1",
+						      d.len - 1);
+			}
+			data_free(d);
+			return DT_CHAR_LITERAL;
+		}
+		case R_REF:
+			yylval.labelref = tree_strdup(yytext+1);
+			return DT_REF;
+		case R_PATHREF:
+			yytext[yyleng-1] = '\0';
+			yylval.labelref = tree_strdup(yytext+2);
+			return DT_REF;
+		case R_BYTE:
+			yylval.byte = strtol(yytext, NULL, 16);
+			return DT_BYTE;
+		case R_RBRACK:
+			state = S_V1;
+			return ']';
+		case R_PNN:
+			yylval.propnodename = tree_strdup((yytext[0] == '\\') ?
+						      yytext + 1 : yytext);
+			state = S_V1;
+			return DT_PROPNODENAME;
+		case R_INCBIN:
+			return DT_INCBIN;
+		case R_WS: case R_COMMENT: case R_LCOMMENT:
+			break;
+		case R_LSHIFT: return DT_LSHIFT;
+		case R_RSHIFT: return DT_RSHIFT;
+		case R_LE: return DT_LE;
+		case R_GE: return DT_GE;
+		case R_EQ: return DT_EQ;
+		case R_NE: return DT_NE;
+		case R_AND: return DT_AND;
+		case R_OR: return DT_OR;
+		case R_ANY:
+			if (yytext[0] == '[')
+				state = S_BYTESTRING;
+			if (yytext[0] == '{' || yytext[0] == ';')
+				state = S_PROPNODENAME;
+			return yytext[0];
+		default:
+			assert(0);
+		}
+	}
+}
+
+static int brace_depth;
+static int last_token;
+
+int yylex(void)
+{
+	int token = lex_token();
+
+	if (token == '{')
+		brace_depth++;
+	else if (token == '}')
+		brace_depth--;
+	last_token = token;
+
+	return token;
+}
+
+static bool at_statement_boundary(void)
+{
+	return (brace_depth == 0)
+		&& ((last_token == ';') || (last_token == DT_INCLUDE_CACHED));
+}
@@ -34,6 +34,12 @@ extern void yyerror(char const *s);
 
 extern struct dt_info *parser_output;
 extern bool treesource_error;
+
+static struct node *add_statement(struct node *dt, enum stmt_type type,
+				  struct srcpos *pos, char *label, char *ref,
+				  struct node *node);
+static struct node *add_cached_statements(struct node *dt,
+					  struct cached_stmt *stmts);
 %}
 
 %union {
@@ -54,6 +60,7 @@ extern bool treesource_error;
 	struct reserve_info *re;
 	uint64_t integer;
 	unsigned int flags;
+	struct cached_stmt *stmts;
 }
 
 %token DT_V1
@@ -71,6 +78,7 @@ extern bool treesource_error;
 %token <labelref> DT_LABEL
 %token <labelref> DT_REF
 %token DT_INCBIN
+%token <stmts> DT_INCLUDE_CACHED
 
 %type <data> propdata
 %type <data> propdataprefix
@@ -108,6 +116,7 @@ extern bool treesource_error;
 sourcefile:
 	  headers memreserves devicetree
 		{
+			include_cache_finish();
 			parser_output = build_dt_info($1, $2, $3,
 			                              guess_boot_cpuid($3));
 		}
@@ -116,10 +125,12 @@ sourcefile:
 header:
 	  DT_V1 ';'
 		{
+			include_cache_reject(&@1);
 			$$ = DTSF_V1;
 		}
 	| DT_V1 ';' DT_PLUGIN ';'
 		{
+			include_cache_reject(&@1);
 			$$ = DTSF_V1 | DTSF_PLUGIN;
 		}
 	;
@@ -148,6 +159,7 @@ memreserves:
 memreserve:
 	  DT_MEMRESERVE integer_prim integer_prim ';'
 		{
+			include_cache_reject(&@1);
 			$$ = build_reserve_entry($2, $3);
 		}
 	| DT_LABEL memreserve
@@ -160,45 +172,35 @@ memreserve:
 devicetree:
 	  '/' nodedef
 		{
-			$$ = name_node($2, "");
+			$$ = add_statement(NULL, STMT_ROOT, &@1, NULL, NULL, $2);
+		}
+	| DT_INCLUDE_CACHED
+		{
+			if ($1->type != STMT_ROOT) {
+				ERROR(&@1, "syntax error");
+				YYERROR;
+			}
+			$$ = add_cached_statements(NULL, $1);
 		}
 	| devicetree '/' nodedef
 		{
-			$$ = merge_nodes($1, $3);
+			$$ = add_statement($1, STMT_ROOT, &@2, NULL, NULL, $3);
+		}
+	| devicetree DT_INCLUDE_CACHED
+		{
+			$$ = add_cached_statements($1, $2);
 		}
-
 	| devicetree DT_LABEL DT_REF nodedef
 		{
-			struct node *target = get_node_by_ref($1, $3);
-
-			if (target) {
-				add_label(&target->labels, $2);
-				merge_nodes(target, $4);
-			} else
-				ERROR(&@3, "Label or path %s not found", $3);
-			$$ = $1;
+			$$ = add_statement($1, STMT_REF, &@3, $2, $3, $4);
 		}
 	| devicetree DT_REF nodedef
 		{
-			struct node *target = get_node_by_ref($1, $2);
-
-			if (target)
-				merge_nodes(target, $3);
-			else
-				ERROR(&@2, "Label or path %s not found", $2);
-			$$ = $1;
+			$$ = add_statement($1, STMT_REF, &@2, NULL, $2, $3);
 		}
 	| devicetree DT_DEL_NODE DT_REF ';'
 		{
-			struct node *target = get_node_by_ref($1, $3);
-
-			if (target)
-				delete_node(target);
-			else
-				ERROR(&@3, "Label or path %s not found", $3);
-
-
-			$$ = $1;
+			$$ = add_statement($1, STMT_DELETE, &@3, NULL, $3, NULL);
 		}
 	;
 
@@ -268,7 +270,7 @@ propdata:
 					    (unsigned long long)$6, $4.val,
 					    strerror(errno));
 
-			d = data_copy_file(f, $8);
+			d = data_map_file(f, $8);
 
 			$$ = data_merge($1, d);
 			fclose(f);
@@ -278,7 +280,7 @@ propdata:
 			FILE *f = srcfile_relative_open($4.val, NULL);
 			struct data d = empty_data;
 
-			d = data_copy_file(f, -1);
+			d = data_map_file(f, -1);
 
 			$$ = data_merge($1, d);
 			fclose(f);
@@ -517,3 +519,46 @@ void yyerror(char const *s)
 {
 	ERROR(&yylloc, "%s", s);
 }
+
+/*
+ * Applies a top-level statement to the tree dt, which is NULL before the
+ * first one.  Statements replayed from the include cache (see
+ * include_cache_push()) come through here as well as parsed ones.
+ */
+static struct node *add_statement(struct node *dt, enum stmt_type type,
+				  struct srcpos *pos, char *label, char *ref,
+				  struct node *node)
+{
+	struct node *target;
+
+	include_cache_record(type, pos, label, ref, node);
+
+	if (type == STMT_ROOT)
+		return dt ? merge_nodes(dt, node) : name_node(node, "");
+
+	target = get_node_by_ref(dt, ref);
+	if (!target) {
+		ERROR(pos, "Label or path %s not found", ref);
+		return dt;
+	}
+
+	if (type == STMT_DELETE) {
+		delete_node(target);
+	} else {
+		if (label)
+			add_label(&target->labels, label);
+		merge_nodes(target, node);
+	}
+	return dt;
+}
+
+static struct node *add_cached_statements(struct node *dt,
+					  struct cached_stmt *stmts)
+{
+	struct cached_stmt *stmt;
+
+	for (stmt = stmts; stmt; stmt = stmt->next)
+		dt = add_statement(dt, stmt->type, stmt->pos, stmt->label,
+				   stmt->ref, stmt->node);
+	return dt;
+}
@@ -19,6 +19,7 @@
  */
 
 #include <sys/stat.h>
+#include <sys/wait.h>
 
 #include "dtc.h"
 #include "srcpos.h"
@@ -35,6 +36,18 @@ int phandle_format = PHANDLE_EPAPR;	/* Use linux,phandle or phandle properties *
 int generate_symbols;	/* enable symbols & fixup support */
 int generate_fixups;		/* suppress generation of fixups on symbol support */
 int auto_label_aliases;		/* auto generate labels -> aliases */
+int share_string_suffixes;	/* store names which are tails of others once */
+int show_stats;			/* print statistics to stderr */
+int jobs = 1;			/* Number of threads to run checks in */
+const char *include_cache_dir;	/* Directory to cache parsed includes in */
+
+/* Options which apply to each tree compiled */
+static const char *inform;
+static const char *outform;
+static const char *depname;
+static bool force, sort;
+static int outversion = DEFAULT_FDT_VERSION;
+static long long cmdline_boot_cpuid = -1;
 
 static int is_power_of_2(int x)
 {
@@ -62,7 +75,7 @@ static void fill_fullpaths(struct node *tree, const char *prefix)
 #define FDT_VERSION(version)	_FDT_VERSION(version)
 #define _FDT_VERSION(version)	#version
 static const char usage_synopsis[] = "dtc [options] <input file>";
-static const char usage_short_opts[] = "qI:O:o:V:d:R:S:p:a:fb:i:H:sW:E:@Ahv";
+static const char usage_short_opts[] = "qI:O:o:V:d:R:S:p:a:fb:i:C:H:sW:E:@ATPj:B:hv";
 static struct option const usage_long_opts[] = {
 	{"quiet",            no_argument, NULL, 'q'},
 	{"in-format",         a_argument, NULL, 'I'},
@@ -77,12 +90,17 @@ static struct option const usage_long_opts[] = {
 	{"boot-cpu",          a_argument, NULL, 'b'},
 	{"force",            no_argument, NULL, 'f'},
 	{"include",           a_argument, NULL, 'i'},
+	{"include-cache",     a_argument, NULL, 'C'},
 	{"sort",             no_argument, NULL, 's'},
 	{"phandle",           a_argument, NULL, 'H'},
 	{"warning",           a_argument, NULL, 'W'},
 	{"error",             a_argument, NULL, 'E'},
 	{"symbols",	     no_argument, NULL, '@'},
 	{"auto-alias",       no_argument, NULL, 'A'},
+	{"share-strings",    no_argument, NULL, 'T'},
+	{"stats",            no_argument, NULL, 'P'},
+	{"jobs",              a_argument, NULL, 'j'},
+	{"batch",             a_argument, NULL, 'B'},
 	{"help",             no_argument, NULL, 'h'},
 	{"version",          no_argument, NULL, 'v'},
 	{NULL,               no_argument, NULL, 0x0},
@@ -107,6 +125,7 @@ static const char * const usage_opts_help[] = {
 	"\n\tSet the physical boot cpu",
 	"\n\tTry to produce output even if the input tree has errors",
 	"\n\tAdd a path to search for include files",
+	"\n\tCache the parsed contents of included files in <dir>",
 	"\n\tSort nodes and properties before outputting (useful for comparing trees)",
 	"\n\tValid phandle formats are:\n"
 	 "\t\tlegacy - \"linux,phandle\" properties only\n"
@@ -116,6 +135,10 @@ static const char * const usage_opts_help[] = {
 	"\n\tEnable/disable errors (prefix with \"no-\")",
 	"\n\tEnable generation of symbols",
 	"\n\tEnable auto-alias of labels",
+	"\n\tShare the storage of property names which are the tail of another (for dtb and asm output)",
+	"\n\tPrint statistics about the compilation to stderr",
+	"\n\tRun the checks in <number> threads, or with -B compile <number> trees at once",
+	"\n\tCompile each \"<input> <output>\" pair listed in <file>, one per line",
 	"\n\tPrint this help and exit",
 	"\n\tPrint version and exit",
 	NULL,
@@ -165,19 +188,215 @@ static const char *guess_input_format(const char *fname, const char *fallback)
 	return guess_type_by_name(fname, fallback);
 }
 
-int main(int argc, char *argv[])
+static void compile(const char *arg, const char *outname)
 {
 	struct dt_info *dti;
-	const char *inform = NULL;
-	const char *outform = NULL;
+	FILE *outf = NULL;
+
+	if (depname) {
+		depfile = fopen(depname, "w");
+		if (!depfile)
+			die("Couldn't open dependency file %s: %s\n", depname,
+			    strerror(errno));
+		fprintf(depfile, "%s:", outname);
+	}
+
+	if (inform == NULL)
+		inform = guess_input_format(arg, "dts");
+	if (outform == NULL) {
+		outform = guess_type_by_name(outname, NULL);
+		if (outform == NULL) {
+			if (streq(inform, "dts"))
+				outform = "dtb";
+			else
+				outform = "dts";
+		}
+	}
+	if (streq(inform, "dts"))
+		dti = dt_from_source(arg);
+	else if (streq(inform, "fs"))
+		dti = dt_from_fs(arg);
+	else if(streq(inform, "dtb"))
+		dti = dt_from_blob(arg);
+	else
+		die("Unknown input format \"%s\"\n", inform);
+
+	dti->outname = outname;
+
+	if (depfile) {
+		fputc('\n', depfile);
+		fclose(depfile);
+	}
+
+	if (cmdline_boot_cpuid != -1)
+		dti->boot_cpuid_phys = cmdline_boot_cpuid;
+
+	fill_fullpaths(dti->dt, "");
+	process_checks(force, dti);
+
+	/* on a plugin, generate by default */
+	if (dti->dtsflags & DTSF_PLUGIN) {
+		generate_fixups = 1;
+	}
+
+	if (auto_label_aliases)
+		generate_label_tree(dti, "aliases", false);
+
+	if (generate_symbols)
+		generate_label_tree(dti, "__symbols__", true);
+
+	if (generate_fixups) {
+		generate_fixups_tree(dti, "__fixups__");
+		generate_local_fixups_tree(dti, "__local_fixups__");
+	}
+
+	if (sort)
+		sort_tree(dti);
+
+	if (streq(outname, "-")) {
+		outf = stdout;
+	} else {
+		outf = fopen(outname, "wb");
+		if (! outf)
+			die("Couldn't open output file %s: %s\n",
+			    outname, strerror(errno));
+	}
+
+	if (streq(outform, "dts")) {
+		dt_to_source(outf, dti);
+	} else if (streq(outform, "dtb")) {
+		dt_to_blob(outf, dti, outversion);
+	} else if (streq(outform, "asm")) {
+		dt_to_asm(outf, dti, outversion);
+	} else if (streq(outform, "null")) {
+		/* do nothing */
+	} else {
+		die("Unknown output format \"%s\"\n", outform);
+	}
+
+	if (show_stats)
+		fprintf(stderr, "Tree: %zu bytes in arena\n",
+			dti->arena->allocated);
+
+	free_dt_info(dti);
+}
+
+/*
+ * Batch mode: compile each pair of files listed in the manifest, up to
+ * jobs at once.  Each tree is compiled in its own process, so that the
+ * parser, the checks and die() need no changes to run concurrently.
+ */
+struct batch_job {
+	pid_t pid;
+	const char *inname;
+};
+
+static bool wait_batch_job(struct batch_job *running, int *nrunning)
+{
+	int status, i;
+	pid_t pid;
+	bool failed;
+
+	pid = wait(&status);
+	if (pid < 0)
+		die("Couldn't wait for batch job: %s\n", strerror(errno));
+
+	for (i = 0; running[i].pid != pid; i++)
+		assert(i < *nrunning);
+
+	failed = !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+	if (failed)
+		fprintf(stderr, "Failed to compile %s\n", running[i].inname);
+
+	running[i] = running[--(*nrunning)];
+	return failed;
+}
+
+static void run_batch(const char *manifest)
+{
+	struct batch_job *running = xmalloc(jobs * sizeof(*running));
+	int nrunning = 0, lineno = 0, n = 0, i;
+	bool failed = false;
+	char *line = NULL;
+	size_t linesize = 0;
+	char **innames = NULL, **outnames = NULL;
+	char *inname, *outname;
+	FILE *f;
+	pid_t pid;
+
+	/*
+	 * Read the whole manifest before starting any jobs: they share
+	 * its file descriptor, and exiting a job can move its offset.
+	 */
+	if (streq(manifest, "-"))
+		f = stdin;
+	else
+		f = fopen(manifest, "r");
+	if (!f)
+		die("Couldn't open batch manifest %s: %s\n", manifest,
+		    strerror(errno));
+
+	while (getline(&line, &linesize, f) >= 0) {
+		lineno++;
+
+		inname = strtok(line, " \t\n");
+		if (!inname || (*inname == '#'))
+			continue;
+		outname = strtok(NULL, " \t\n");
+		if (!outname || strtok(NULL, " \t\n"))
+			die("%s:%d: expected \"<input> <output>\"\n",
+			    manifest, lineno);
+
+		innames = xrealloc(innames, (n + 1) * sizeof(*innames));
+		outnames = xrealloc(outnames, (n + 1) * sizeof(*outnames));
+		innames[n] = xstrdup(inname);
+		outnames[n] = xstrdup(outname);
+		n++;
+	}
+
+	if (f != stdin)
+		fclose(f);
+	free(line);
+
+	for (i = 0; i < n; i++) {
+		if (nrunning == jobs)
+			failed |= wait_batch_job(running, &nrunning);
+
+		fflush(stdout);
+		fflush(stderr);
+		pid = fork();
+		if (pid < 0)
+			die("Couldn't start batch job: %s\n", strerror(errno));
+		if (pid == 0) {
+			jobs = 1;
+			compile(innames[i], outnames[i]);
+			exit(0);
+		}
+
+		running[nrunning].pid = pid;
+		running[nrunning].inname = innames[i];
+		nrunning++;
+	}
+
+	while (nrunning)
+		failed |= wait_batch_job(running, &nrunning);
+
+	for (i = 0; i < n; i++) {
+		free(innames[i]);
+		free(outnames[i]);
+	}
+	free(innames);
+	free(outnames);
+	free(running);
+	exit(failed ? 1 : 0);
+}
+
+int main(int argc, char *argv[])
+{
 	const char *outname = "-";
-	const char *depname = NULL;
-	bool force = false, sort = false;
+	const char *batchname = NULL;
 	const char *arg;
 	int opt;
-	FILE *outf = NULL;
-	int outversion = DEFAULT_FDT_VERSION;
-	long long cmdline_boot_cpuid = -1;
 
 	quiet      = 0;
 	reservenum = 0;
@@ -229,6 +448,12 @@ int main(int argc, char *argv[])
 		case 'i':
 			srcfile_add_search_path(optarg);
 			break;
+		case 'C':
+			include_cache_dir = optarg;
+			if (mkdir(optarg, 0777) && (errno != EEXIST))
+				die("Couldn't create include cache %s: %s\n",
+				    optarg, strerror(errno));
+			break;
 		case 'v':
 			util_version();
 		case 'H':
@@ -262,6 +487,22 @@ int main(int argc, char *argv[])
 			auto_label_aliases = 1;
 			break;
 
+		case 'T':
+			share_string_suffixes = 1;
+			break;
+		case 'P':
+			show_stats = 1;
+			break;
+		case 'j':
+			jobs = strtol(optarg, NULL, 0);
+			if (jobs < 1)
+				die("Invalid argument \"%s\" to -j option\n",
+				    optarg);
+			break;
+		case 'B':
+			batchname = optarg;
+			break;
+
 		case 'h':
 			usage(NULL);
 		default:
@@ -280,86 +521,12 @@ int main(int argc, char *argv[])
 	if (minsize && padsize)
 		die("Can't set both -p and -S\n");
 
-	if (depname) {
-		depfile = fopen(depname, "w");
-		if (!depfile)
-			die("Couldn't open dependency file %s: %s\n", depname,
-			    strerror(errno));
-		fprintf(depfile, "%s:", outname);
-	}
-
-	if (inform == NULL)
-		inform = guess_input_format(arg, "dts");
-	if (outform == NULL) {
-		outform = guess_type_by_name(outname, NULL);
-		if (outform == NULL) {
-			if (streq(inform, "dts"))
-				outform = "dtb";
-			else
-				outform = "dts";
-		}
-	}
-	if (streq(inform, "dts"))
-		dti = dt_from_source(arg);
-	else if (streq(inform, "fs"))
-		dti = dt_from_fs(arg);
-	else if(streq(inform, "dtb"))
-		dti = dt_from_blob(arg);
-	else
-		die("Unknown input format \"%s\"\n", inform);
-
-	dti->outname = outname;
-
-	if (depfile) {
-		fputc('\n', depfile);
-		fclose(depfile);
-	}
-
-	if (cmdline_boot_cpuid != -1)
-		dti->boot_cpuid_phys = cmdline_boot_cpuid;
-
-	fill_fullpaths(dti->dt, "");
-	process_checks(force, dti);
-
-	/* on a plugin, generate by default */
-	if (dti->dtsflags & DTSF_PLUGIN) {
-		generate_fixups = 1;
-	}
-
-	if (auto_label_aliases)
-		generate_label_tree(dti, "aliases", false);
-
-	if (generate_symbols)
-		generate_label_tree(dti, "__symbols__", true);
-
-	if (generate_fixups) {
-		generate_fixups_tree(dti, "__fixups__");
-		generate_local_fixups_tree(dti, "__local_fixups__");
-	}
-
-	if (sort)
-		sort_tree(dti);
-
-	if (streq(outname, "-")) {
-		outf = stdout;
-	} else {
-		outf = fopen(outname, "wb");
-		if (! outf)
-			die("Couldn't open output file %s: %s\n",
-			    outname, strerror(errno));
-	}
-
-	if (streq(outform, "dts")) {
-		dt_to_source(outf, dti);
-	} else if (streq(outform, "dtb")) {
-		dt_to_blob(outf, dti, outversion);
-	} else if (streq(outform, "asm")) {
-		dt_to_asm(outf, dti, outversion);
-	} else if (streq(outform, "null")) {
-		/* do nothing */
-	} else {
-		die("Unknown output format \"%s\"\n", outform);
+	if (batchname) {
+		if (depname || !streq(outname, "-") || (argc > optind))
+			usage("-B can't be used with -d, -o or an input file");
+		run_batch(batchname);
 	}
 
+	compile(arg, outname);
 	exit(0);
 }
@@ -58,6 +58,10 @@ extern int phandle_format;	/* Use linux,phandle or phandle properties */
 extern int generate_symbols;	/* generate symbols for nodes with labels */
 extern int generate_fixups;	/* generate fixups */
 extern int auto_label_aliases;	/* auto generate labels -> aliases */
+extern int share_string_suffixes; /* store names which are tails of others once */
+extern int show_stats;		/* print statistics to stderr */
+extern int jobs;		/* Number of threads to run checks in */
+extern const char *include_cache_dir; /* Directory to cache parsed includes in */
 
 #define PHANDLE_LEGACY	0x1
 #define PHANDLE_EPAPR	0x2
@@ -87,8 +91,10 @@ struct  marker {
 
 struct data {
 	int len;
+	int size;		/* allocated length of val, 0 if borrowed */
 	char *val;
 	struct marker *markers;
+	struct marker *last_marker;	/* tail of markers, for appending */
 };
 
 
@@ -105,8 +111,10 @@ void data_free(struct data d);
 struct data data_grow_for(struct data d, int xlen);
 
 struct data data_copy_mem(const char *mem, int len);
+struct data data_borrow_mem(char *mem, int len);
 struct data data_copy_escape_string(const char *s, int len);
 struct data data_copy_file(FILE *f, size_t len);
+struct data data_map_file(FILE *f, size_t len);
 
 struct data data_append_data(struct data d, const void *p, int len);
 struct data data_insert_at_marker(struct data d, struct marker *m,
@@ -167,6 +175,13 @@ struct node {
 
 	struct label *labels;
 	const struct bus_type *bus;
+
+	/* name lookup, maintained by add_property() and add_child() */
+	struct property *last_prop;
+	struct node *last_child;
+	bool indexed;
+	struct strmap prop_index;	/* name -> first struct property */
+	struct strmap child_index;	/* name -> first struct node */
 };
 
 #define for_each_label_withdel(l0, l) \
@@ -190,6 +205,11 @@ struct node {
 	for_each_child_withdel(n, c) \
 		if (!(c)->deleted)
 
+void new_tree_arena(void);
+void *tree_alloc(size_t len);
+char *tree_strdup(const char *s);
+char *tree_map_file(FILE *f, size_t maxlen, size_t *len);
+
 void add_label(struct label **labels, char *label);
 void delete_labels(struct label **labels);
 
@@ -204,6 +224,7 @@ struct node *name_node(struct node *node, char *name);
 struct node *chain_node(struct node *first, struct node *list);
 struct node *merge_nodes(struct node *old_node, struct node *new_node);
 
+void unindex_node(struct node *node);
 void add_property(struct node *node, struct property *prop);
 void delete_property_by_name(struct node *node, char *name);
 void delete_property(struct property *prop);
@@ -225,7 +246,6 @@ struct node *get_node_by_path(struct node *tree, const char *path);
 struct node *get_node_by_label(struct node *tree, const char *label);
 struct node *get_node_by_phandle(struct node *tree, cell_t phandle);
 struct node *get_node_by_ref(struct node *tree, const char *ref);
-cell_t get_node_phandle(struct node *root, struct node *node);
 
 uint32_t guess_boot_cpuid(struct node *tree);
 
@@ -252,6 +272,29 @@ struct dt_info {
 	uint32_t boot_cpuid_phys;
 	struct node *dt;		/* the device tree */
 	const char *outname;		/* filename being written to, "-" for stdout */
+	struct arena *arena;		/* holds the tree, see tree_alloc() */
+	struct tree_mapping *mappings;	/* see tree_map_file() */
+	char *blob;			/* input blob the tree refers to */
+	size_t blob_size;
+	bool blob_mapped;		/* blob is mmap()ed, not malloc()ed */
+
+	/* phandle allocator state, see get_node_phandle() */
+	cell_t *used_phandles;		/* sorted explicit phandles */
+	int num_used_phandles;
+	int next_used_phandle;		/* index of first not yet skipped */
+	cell_t next_phandle;		/* 0 until the tree has been scanned */
+
+	/* symbol tables, see dti_get_node_by_ref() */
+	bool have_symbols;
+	struct strmap labels;		/* label -> struct label_target */
+	struct strmap paths;		/* full path -> struct node */
+};
+
+/* What a label is attached to: a node, a property or a marker within one */
+struct label_target {
+	struct node *node;
+	struct property *prop;
+	struct marker *marker;
 };
 
 /* DTS version flags definitions */
@@ -261,10 +304,17 @@ struct dt_info {
 struct dt_info *build_dt_info(unsigned int dtsflags,
 			      struct reserve_info *reservelist,
 			      struct node *tree, uint32_t boot_cpuid_phys);
+void free_dt_info(struct dt_info *dti);
 void sort_tree(struct dt_info *dti);
 void generate_label_tree(struct dt_info *dti, char *name, bool allocph);
 void generate_fixups_tree(struct dt_info *dti, char *name);
 void generate_local_fixups_tree(struct dt_info *dti, char *name);
+cell_t get_node_phandle(struct dt_info *dti, struct node *node);
+void dti_build_symbols(struct dt_info *dti);
+struct label_target *dti_get_label(struct dt_info *dti, const char *label);
+struct node *dti_get_node_by_path(struct dt_info *dti, const char *path);
+struct node *dti_get_node_by_label(struct dt_info *dti, const char *label);
+struct node *dti_get_node_by_ref(struct dt_info *dti, const char *ref);
 
 /* Checks */
 
@@ -283,6 +333,34 @@ struct dt_info *dt_from_blob(const char *fname);
 void dt_to_source(FILE *f, struct dt_info *dti);
 struct dt_info *dt_from_source(const char *f);
 
+/* Include cache */
+
+/* A top-level statement of a source file, see dtc-parser.y */
+enum stmt_type {
+	STMT_ROOT,		/* / { ... }; */
+	STMT_REF,		/* label: &ref { ... }; */
+	STMT_DELETE,		/* /delete-node/ &ref; */
+};
+
+struct srcfile_state;
+struct srcpos;
+
+struct cached_stmt {
+	enum stmt_type type;
+	struct srcpos *pos;	/* of the reference, for diagnostics */
+	char *label;		/* may be NULL */
+	char *ref;
+	struct node *node;
+	struct cached_stmt *next;
+};
+
+bool include_cache_push(const char *fname, struct cached_stmt **stmts);
+void include_cache_record(enum stmt_type type, struct srcpos *pos,
+			  char *label, char *ref, struct node *node);
+void include_cache_reject(struct srcpos *pos);
+void include_cache_end_file(struct srcfile_state *file, bool complete);
+void include_cache_finish(void);
+
 /* FS trees */
 
 struct dt_info *dt_from_fs(const char *dirname);
@@ -27,6 +27,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <alloca.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <libfdt.h>
 
@@ -54,14 +58,49 @@ static const char * const usage_opts_help[] = {
 
 int verbose = 0;
 
+/*
+ * Map an overlay read-only, as applying it leaves it untouched.
+ * Returns NULL if it is not a regular file, and has to be read instead.
+ */
+static void *map_overlay(const char *filename, off_t *len)
+{
+	struct stat st;
+	void *blob;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	blob = NULL;
+	if (!fstat(fd, &st) && S_ISREG(st.st_mode)
+	    && (st.st_size >= sizeof(struct fdt_header))) {
+		blob = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (blob == MAP_FAILED)
+			blob = NULL;
+	}
+	close(fd);
+
+	if (blob && (fdt_totalsize(blob) > st.st_size)) {
+		munmap(blob, st.st_size);
+		blob = NULL;
+	}
+
+	if (blob)
+		*len = st.st_size;
+	return blob;
+}
+
 static int do_fdtoverlay(const char *input_filename,
 			 const char *output_filename,
 			 int argc, char *argv[])
 {
-	char *blob = NULL;
-	char **ovblob = NULL;
-	off_t blob_len, ov_len, total_len;
-	int i, ret = -1;
+	char *blob = NULL, *out = NULL;
+	void **ovblob = NULL;
+	off_t *ovmapped = NULL;
+	void *ws = NULL;
+	off_t blob_len, ov_len;
+	int i, wssize, failed = -1, ret = -1;
 
 	blob = utilfdt_read_len(input_filename, &blob_len);
 	if (!blob) {
@@ -71,30 +110,26 @@ static int do_fdtoverlay(const char *input_filename,
 	}
 	ret = 0;
 
-	/* allocate blob pointer array */
+	/* allocate blob pointer array, and the lengths of those mapped */
 	ovblob = alloca(sizeof(*ovblob) * argc);
 	memset(ovblob, 0, sizeof(*ovblob) * argc);
+	ovmapped = alloca(sizeof(*ovmapped) * argc);
+	memset(ovmapped, 0, sizeof(*ovmapped) * argc);
 
-	/* read and keep track of the overlay blobs */
-	total_len = 0;
+	/* map or read and keep track of the overlay blobs */
 	for (i = 0; i < argc; i++) {
-		ovblob[i] = utilfdt_read_len(argv[i], &ov_len);
+		ovblob[i] = map_overlay(argv[i], &ovmapped[i]);
+		ov_len = ovmapped[i];
+		if (!ovblob[i])
+			ovblob[i] = utilfdt_read_len(argv[i], &ov_len);
 		if (!ovblob[i]) {
 			fprintf(stderr, "\nFailed to read overlay %s\n",
 					argv[i]);
 			goto out_err;
 		}
-		total_len += ov_len;
-	}
 
-	/* grow the blob to worst case */
-	blob_len = fdt_totalsize(blob) + total_len;
-	blob = xrealloc(blob, blob_len);
-	fdt_open_into(blob, blob, blob_len);
-
-	/* apply the overlays in sequence */
-	for (i = 0; i < argc; i++) {
-		ret = fdt_overlay_apply(blob, ovblob[i]);
+		/* the batch can only be sized once every header is sound */
+		ret = fdt_check_header(ovblob[i]);
 		if (ret) {
 			fprintf(stderr, "\nFailed to apply %s (%d)\n",
 					argv[i], ret);
@@ -102,8 +137,33 @@ static int do_fdtoverlay(const char *input_filename,
 		}
 	}
 
-	fdt_pack(blob);
-	ret = utilfdt_write(output_filename, blob);
+	/* size the merged blob for the worst case, and the workspace */
+	ret = fdt_overlay_merged_size(blob, (const void *const *)ovblob, argc);
+	if (ret >= 0) {
+		blob_len = ret;
+		out = xmalloc(blob_len);
+		ret = wssize = fdt_overlay_apply_many_size(blob,
+				(const void *const *)ovblob, argc);
+	}
+	if (ret >= 0) {
+		ws = xmalloc(wssize);
+
+		/* apply the overlays in sequence */
+		ret = fdt_overlay_apply_many(blob, (const void *const *)ovblob,
+					     argc, ws, wssize, out, blob_len,
+					     &failed);
+	}
+	if (ret) {
+		if (failed >= 0)
+			fprintf(stderr, "\nFailed to apply %s (%d)\n",
+					argv[failed], ret);
+		else
+			fprintf(stderr, "\nFailed to apply overlays (%d)\n",
+					ret);
+		goto out_err;
+	}
+
+	ret = utilfdt_write(output_filename, out);
 	if (ret)
 		fprintf(stderr, "\nFailed to write output blob %s\n",
 				output_filename);
@@ -111,10 +171,14 @@ static int do_fdtoverlay(const char *input_filename,
 out_err:
 	if (ovblob) {
 		for (i = 0; i < argc; i++) {
-			if (ovblob[i])
+			if (ovmapped[i])
+				munmap(ovblob[i], ovmapped[i]);
+			else if (ovblob[i])
 				free(ovblob[i]);
 		}
 	}
+	free(ws);
+	free(out);
 	free(blob);
 
 	return ret;
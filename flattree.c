@@ -18,6 +18,9 @@
  *                                                                   USA
  */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "dtc.h"
 #include "srcpos.h"
 
@@ -57,36 +60,67 @@ struct emitter {
 	void (*property)(void *, struct label *labels);
 };
 
+/*
+ * The binary emitter writes the blob straight to a file, so that it is
+ * never assembled in memory.  With a NULL file it only counts, which
+ * gives the size of the structure block for the header.
+ */
+struct bin_out {
+	FILE *f;
+	unsigned int len;
+};
+
+static void bin_write(struct bin_out *out, const void *p, int len)
+{
+	if (out->f && (len > 0) && (fwrite(p, len, 1, out->f) != 1)) {
+		if (ferror(out->f))
+			die("Error writing device tree blob: %s\n",
+			    strerror(errno));
+		else
+			die("Short write on device tree blob\n");
+	}
+
+	out->len += len;
+}
+
+static void bin_write_zeroes(struct bin_out *out, int len)
+{
+	static const char zeroes[4096];
+	int n;
+
+	while (len > 0) {
+		n = (len < sizeof(zeroes)) ? len : sizeof(zeroes);
+		bin_write(out, zeroes, n);
+		len -= n;
+	}
+}
+
 static void bin_emit_cell(void *e, cell_t val)
 {
-	struct data *dtbuf = e;
+	fdt32_t beval = cpu_to_fdt32(val);
 
-	*dtbuf = data_append_cell(*dtbuf, val);
+	bin_write(e, &beval, sizeof(beval));
 }
 
 static void bin_emit_string(void *e, const char *str, int len)
 {
-	struct data *dtbuf = e;
-
 	if (len == 0)
 		len = strlen(str);
 
-	*dtbuf = data_append_data(*dtbuf, str, len);
-	*dtbuf = data_append_byte(*dtbuf, '\0');
+	bin_write(e, str, len);
+	bin_write_zeroes(e, 1);
 }
 
 static void bin_emit_align(void *e, int a)
 {
-	struct data *dtbuf = e;
+	struct bin_out *out = e;
 
-	*dtbuf = data_append_align(*dtbuf, a);
+	bin_write_zeroes(out, ALIGN(out->len, a) - out->len);
 }
 
 static void bin_emit_data(void *e, struct data d)
 {
-	struct data *dtbuf = e;
-
-	*dtbuf = data_append_data(*dtbuf, d.val, d.len);
+	bin_write(e, d.val, d.len);
 }
 
 static void bin_emit_beginnode(void *e, struct label *labels)
@@ -232,23 +266,86 @@ static struct emitter asm_emitter = {
 	.property = asm_emit_property,
 };
 
-static int stringtable_insert(struct data *d, const char *str)
+/*
+ * The strings block under construction, with a hash table from each
+ * string it contains to its offset.  Every suffix of every string is
+ * indexed too, so that a name which is the tail of one already in the
+ * block (e.g. "reg" in "phy-reg") is shared rather than added again.
+ */
+struct strtab {
+	struct data d;
+	int *slots;		/* offset + 1 of a string in d, or 0 if empty */
+	unsigned int mask;
+	unsigned int count;
+};
+
+static void strtab_init(struct strtab *t)
 {
-	int i;
+	t->d = empty_data;
+	t->mask = 63;
+	t->count = 0;
+	t->slots = xmalloc((t->mask + 1) * sizeof(*t->slots));
+	memset(t->slots, 0, (t->mask + 1) * sizeof(*t->slots));
+}
 
-	/* FIXME: do this more efficiently? */
+static void strtab_free(struct strtab *t)
+{
+	free(t->slots);
+}
 
-	for (i = 0; i < d->len; i++) {
-		if (streq(str, d->val + i))
-			return i;
-	}
+/* Returns the slot holding str, or the empty slot where it belongs */
+static int *strtab_slot(struct strtab *t, const char *str)
+{
+	unsigned int i = strhash(str) & t->mask;
+
+	while (t->slots[i] && !streq(t->d.val + t->slots[i] - 1, str))
+		i = (i + 1) & t->mask;
+	return &t->slots[i];
+}
+
+static void strtab_index(struct strtab *t, int offset)
+{
+	int *slot = strtab_slot(t, t->d.val + offset);
+	unsigned int i, oldsize;
+	int *old;
+
+	if (*slot)
+		return; /* first occurrence wins */
+	*slot = offset + 1;
+
+	if (++t->count * 4 < (t->mask + 1) * 3)
+		return;
+
+	old = t->slots;
+	oldsize = t->mask + 1;
+	t->mask = 2 * oldsize - 1;
+	t->slots = xmalloc((t->mask + 1) * sizeof(*t->slots));
+	memset(t->slots, 0, (t->mask + 1) * sizeof(*t->slots));
+	for (i = 0; i < oldsize; i++)
+		if (old[i])
+			*strtab_slot(t, t->d.val + old[i] - 1) = old[i];
+	free(old);
+}
+
+static int stringtable_insert(struct strtab *t, const char *str)
+{
+	int *slot = strtab_slot(t, str);
+	int i, offset, len;
+
+	if (*slot)
+		return *slot - 1;
+
+	offset = t->d.len;
+	len = strlen(str);
+	t->d = data_append_data(t->d, str, len+1);
+	for (i = 0; i <= len; i++)
+		strtab_index(t, offset + i);
 
-	*d = data_append_data(*d, str, strlen(str)+1);
-	return i;
+	return offset;
 }
 
 static void flatten_tree(struct node *tree, struct emitter *emit,
-			 void *etarget, struct data *strbuf,
+			 void *etarget, struct strtab *strtab,
 			 struct version_info *vi)
 {
 	struct property *prop;
@@ -273,7 +370,7 @@ static void flatten_tree(struct node *tree, struct emitter *emit,
 		if (streq(prop->name, "name"))
 			seen_name_prop = true;
 
-		nameoff = stringtable_insert(strbuf, prop->name);
+		nameoff = stringtable_insert(strtab, prop->name);
 
 		emit->property(etarget, prop->labels);
 		emit->cell(etarget, prop->val.len);
@@ -289,7 +386,7 @@ static void flatten_tree(struct node *tree, struct emitter *emit,
 	if ((vi->flags & FTF_NAMEPROPS) && !seen_name_prop) {
 		emit->property(etarget, NULL);
 		emit->cell(etarget, tree->basenamelen+1);
-		emit->cell(etarget, stringtable_insert(strbuf, "name"));
+		emit->cell(etarget, stringtable_insert(strtab, "name"));
 
 		if ((vi->flags & FTF_VARALIGN) && ((tree->basenamelen+1) >= 8))
 			emit->align(etarget, 8);
@@ -299,12 +396,115 @@ static void flatten_tree(struct node *tree, struct emitter *emit,
 	}
 
 	for_each_child(tree, child) {
-		flatten_tree(child, emit, etarget, strbuf, vi);
+		flatten_tree(child, emit, etarget, strtab, vi);
 	}
 
 	emit->endnode(etarget, tree->labels);
 }
 
+/* Like stringtable_insert(), but without sharing suffixes */
+static void add_name(struct strtab *names, const char *str)
+{
+	int offset = names->d.len;
+
+	if (*strtab_slot(names, str))
+		return;
+
+	names->d = data_append_data(names->d, str, strlen(str)+1);
+	strtab_index(names, offset);
+}
+
+static void collect_names(struct node *tree, struct version_info *vi,
+			  struct strtab *names)
+{
+	struct property *prop;
+	struct node *child;
+	bool seen_name_prop = false;
+
+	if (tree->deleted)
+		return;
+
+	for_each_property(tree, prop) {
+		if (streq(prop->name, "name"))
+			seen_name_prop = true;
+
+		add_name(names, prop->name);
+	}
+
+	if ((vi->flags & FTF_NAMEPROPS) && !seen_name_prop)
+		add_name(names, "name");
+
+	for_each_child(tree, child)
+		collect_names(child, vi, names);
+}
+
+/* Orders strings as if reversed, so each suffix sorts just before its hosts */
+static int cmp_reversed(const void *ap, const void *bp)
+{
+	const char *a = *((const char * const *)ap);
+	const char *b = *((const char * const *)bp);
+	int i = strlen(a), j = strlen(b);
+
+	while (i && j) {
+		i--;
+		j--;
+		if (a[i] != b[j])
+			return (unsigned char)a[i] - (unsigned char)b[j];
+	}
+	return i - j;
+}
+
+/*
+ * Pre-loads the strings table with every property name used in the
+ * tree, except those which are the tail of another name and so can
+ * share its storage.  Without this, a name is only shared if the name
+ * containing it happens to be used first.
+ */
+static void stringtable_share_suffixes(struct strtab *t, struct node *tree,
+				       struct version_info *vi)
+{
+	struct strtab names;
+	const char **sorted;
+	bool *shared;
+	const char *p;
+	int i, n = 0, la, lb;
+
+	strtab_init(&names);
+	collect_names(tree, vi, &names);
+	if (!names.d.len) {
+		strtab_free(&names);
+		return;
+	}
+
+	for (p = names.d.val; p < names.d.val + names.d.len; p += strlen(p)+1)
+		n++;
+	sorted = xmalloc(n * sizeof(*sorted));
+	for (i = 0, p = names.d.val; i < n; i++, p += strlen(p)+1)
+		sorted[i] = p;
+	qsort(sorted, n, sizeof(*sorted), cmp_reversed);
+
+	/* indexed by offset in names.d */
+	shared = xmalloc(names.d.len * sizeof(*shared));
+	for (i = 0; i < n; i++) {
+		shared[sorted[i] - names.d.val] = false;
+		if (i + 1 < n) {
+			la = strlen(sorted[i]);
+			lb = strlen(sorted[i+1]);
+			if (streq(sorted[i+1] + lb - la, sorted[i]))
+				shared[sorted[i] - names.d.val] = true;
+		}
+	}
+
+	for (p = names.d.val; p < names.d.val + names.d.len; p += strlen(p)+1)
+		if (!shared[p - names.d.val])
+			stringtable_insert(t, p);
+
+	free(shared);
+	free(sorted);
+	data_free(names.d);
+	strtab_free(&names);
+}
+
 static struct data flatten_reserve_list(struct reserve_info *reservelist,
 				 struct version_info *vi)
 {
@@ -361,10 +561,10 @@ void dt_to_blob(FILE *f, struct dt_info *dti, int version)
 {
 	struct version_info *vi = NULL;
 	int i;
-	struct data blob       = empty_data;
 	struct data reservebuf = empty_data;
-	struct data dtbuf      = empty_data;
-	struct data strbuf     = empty_data;
+	struct bin_out count = { NULL, 0 };
+	struct bin_out out = { f, 0 };
+	struct strtab strtab;
 	struct fdt_header fdt;
 	int padlen = 0;
 
@@ -375,13 +575,20 @@ void dt_to_blob(FILE *f, struct dt_info *dti, int version)
 	if (!vi)
 		die("Unknown device tree blob version %d\n", version);
 
-	flatten_tree(dti->dt, &bin_emitter, &dtbuf, &strbuf, vi);
-	bin_emit_cell(&dtbuf, FDT_END);
+	/*
+	 * Size the structure block, filling in the strings table as we
+	 * go.  Flattening it again below then only looks up the strings.
+	 */
+	strtab_init(&strtab);
+	if (share_string_suffixes)
+		stringtable_share_suffixes(&strtab, dti->dt, vi);
+	flatten_tree(dti->dt, &bin_emitter, &count, &strtab, vi);
+	bin_emit_cell(&count, FDT_END);
 
 	reservebuf = flatten_reserve_list(dti->reservelist, vi);
 
 	/* Make header */
-	make_fdt_header(&fdt, vi, reservebuf.len, dtbuf.len, strbuf.len,
+	make_fdt_header(&fdt, vi, reservebuf.len, count.len, strtab.d.len,
 			dti->boot_cpuid_phys);
 
 	/*
@@ -412,36 +619,31 @@ void dt_to_blob(FILE *f, struct dt_info *dti, int version)
 	}
 
 	/*
-	 * Assemble the blob: start with the header, add with alignment
+	 * Write out the blob: start with the header, add with alignment
 	 * the reserve buffer, add the reserve map terminating zeroes,
-	 * the device tree itself, and finally the strings.
+	 * the device tree itself, and finally the strings.  The
+	 * structure block is 8-byte aligned in the blob, so its internal
+	 * alignment is the same as when it was sized.
 	 */
-	blob = data_append_data(blob, &fdt, vi->hdr_size);
-	blob = data_append_align(blob, 8);
-	blob = data_merge(blob, reservebuf);
-	blob = data_append_zeroes(blob, sizeof(struct fdt_reserve_entry));
-	blob = data_merge(blob, dtbuf);
-	blob = data_merge(blob, strbuf);
+	bin_write(&out, &fdt, vi->hdr_size);
+	bin_emit_align(&out, 8);
+	bin_write(&out, reservebuf.val, reservebuf.len);
+	bin_write_zeroes(&out, sizeof(struct fdt_reserve_entry));
+	flatten_tree(dti->dt, &bin_emitter, &out, &strtab, vi);
+	bin_emit_cell(&out, FDT_END);
+	bin_write(&out, strtab.d.val, strtab.d.len);
 
 	/*
 	 * If the user asked for more space than is used, pad out the blob.
 	 */
 	if (padlen > 0)
-		blob = data_append_zeroes(blob, padlen);
+		bin_write_zeroes(&out, padlen);
 
-	if (fwrite(blob.val, blob.len, 1, f) != 1) {
-		if (ferror(f))
-			die("Error writing device tree blob: %s\n",
-			    strerror(errno));
-		else
-			die("Short write on device tree blob\n");
-	}
+	assert(out.len == fdt32_to_cpu(fdt.totalsize));
 
-	/*
-	 * data_merge() frees the right-hand element so only the blob
-	 * remains to be freed.
-	 */
-	data_free(blob);
+	data_free(reservebuf);
+	data_free(strtab.d);
+	strtab_free(&strtab);
 }
 
 static void dump_stringtable_asm(FILE *f, struct data strbuf)
@@ -462,7 +664,7 @@ void dt_to_asm(FILE *f, struct dt_info *dti, int version)
 {
 	struct version_info *vi = NULL;
 	int i;
-	struct data strbuf = empty_data;
+	struct strtab strtab;
 	struct reserve_info *re;
 	const char *symprefix = "dt";
 
@@ -548,14 +750,17 @@ void dt_to_asm(FILE *f, struct dt_info *dti, int version)
 	fprintf(f, "\t.long\t0, 0\n\t.long\t0, 0\n");
 
 	emit_label(f, symprefix, "struct_start");
-	flatten_tree(dti->dt, &asm_emitter, f, &strbuf, vi);
+	strtab_init(&strtab);
+	if (share_string_suffixes)
+		stringtable_share_suffixes(&strtab, dti->dt, vi);
+	flatten_tree(dti->dt, &asm_emitter, f, &strtab, vi);
 
 	fprintf(f, "\t/* FDT_END */\n");
 	asm_emit_cell(f, FDT_END);
 	emit_label(f, symprefix, "struct_end");
 
 	emit_label(f, symprefix, "strings_start");
-	dump_stringtable_asm(f, strbuf);
+	dump_stringtable_asm(f, strtab.d);
 	emit_label(f, symprefix, "strings_end");
 
 	emit_label(f, symprefix, "blob_end");
@@ -574,7 +779,8 @@ void dt_to_asm(FILE *f, struct dt_info *dti, int version)
 		asm_emit_align(f, alignsize);
 	emit_label(f, symprefix, "blob_abs_end");
 
-	data_free(strbuf);
+	data_free(strtab.d);
+	strtab_free(&strtab);
 }
 
 struct inbuf {
@@ -618,6 +824,11 @@ static void flat_realign(struct inbuf *inb, int align)
 		die("Premature end of data parsing flat device tree\n");
 }
 
+/*
+ * Strings and property values are not copied out of the blob: it is kept
+ * for as long as the tree (see dt_from_blob()), and values are copied by
+ * struct data when they're changed.
+ */
 static char *flat_read_string(struct inbuf *inb)
 {
 	int len = 0;
@@ -630,7 +841,7 @@ static char *flat_read_string(struct inbuf *inb)
 		len++;
 	} while ((*p++) != '\0');
 
-	str = xstrdup(inb->ptr);
+	str = inb->ptr;
 
 	inb->ptr += len;
 
@@ -641,15 +852,16 @@ static char *flat_read_string(struct inbuf *inb)
 
 static struct data flat_read_data(struct inbuf *inb, int len)
 {
-	struct data d = empty_data;
+	struct data d;
 
 	if (len == 0)
 		return empty_data;
 
-	d = data_grow_for(d, len);
-	d.len = len;
+	if ((inb->ptr + len) > inb->limit)
+		die("Premature end of data parsing flat device tree\n");
 
-	flat_read_chunk(inb, d.val, len);
+	d = data_borrow_mem(inb->ptr, len);
+	inb->ptr += len;
 
 	flat_realign(inb, sizeof(uint32_t));
 
@@ -672,7 +884,7 @@ static char *flat_read_stringtable(struct inbuf *inb, int offset)
 		p++;
 	}
 
-	return xstrdup(inb->base + offset);
+	return inb->base + offset;
 }
 
 static struct property *flat_read_property(struct inbuf *dtbuf,
@@ -739,7 +951,7 @@ static char *nodename_from_path(const char *ppath, const char *cpath)
 	if (!streq(ppath, "/"))
 		plen++;
 
-	return xstrdup(cpath + plen);
+	return tree_strdup(cpath + plen);
 }
 
 static struct node *unflatten_tree(struct inbuf *dtbuf,
@@ -799,14 +1011,34 @@ static struct node *unflatten_tree(struct inbuf *dtbuf,
 		}
 	} while (val != FDT_END_NODE);
 
-	if (node->name != flatname) {
-		free(flatname);
-	}
-
 	return node;
 }
 
 
+/*
+ * Map the blob if it is a regular file which f has only read the header
+ * of so far.  The mapping is private, so the tree can be changed in place
+ * without touching the file.  Returns NULL if the blob has to be read
+ * instead.
+ */
+static char *map_blob(FILE *f, uint32_t totalsize)
+{
+	struct stat st;
+	void *blob;
+
+	if (fstat(fileno(f), &st) || !S_ISREG(st.st_mode)
+	    || (st.st_size < totalsize)
+	    || (ftell(f) != 2 * sizeof(fdt32_t)))
+		return NULL;
+
+	blob = mmap(NULL, totalsize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		    fileno(f), 0);
+	if (blob == MAP_FAILED)
+		return NULL;
+
+	return blob;
+}
+
 struct dt_info *dt_from_blob(const char *fname)
 {
 	FILE *f;
@@ -822,9 +1054,12 @@ struct dt_info *dt_from_blob(const char *fname)
 	int sizeleft;
 	struct reserve_info *reservelist;
 	struct node *tree;
+	struct dt_info *dti;
+	bool mapped = false;
 	uint32_t val;
 	int flags = 0;
 
+	new_tree_arena();
 	f = srcfile_relative_open(fname, NULL);
 
 	rc = fread(&magic_buf, sizeof(magic_buf), 1, f);
@@ -856,13 +1091,19 @@ struct dt_info *dt_from_blob(const char *fname)
 	if (totalsize < FDT_V1_SIZE)
 		die("DT blob size (%d) is too small\n", totalsize);
 
-	blob = xmalloc(totalsize);
-
+	blob = map_blob(f, totalsize);
 	fdt = (struct fdt_header *)blob;
-	fdt->magic = cpu_to_fdt32(magic);
-	fdt->totalsize = cpu_to_fdt32(totalsize);
+	if (blob) {
+		mapped = true;
+		sizeleft = 0;
+	} else {
+		blob = xmalloc(totalsize);
+		fdt = (struct fdt_header *)blob;
+		fdt->magic = cpu_to_fdt32(magic);
+		fdt->totalsize = cpu_to_fdt32(totalsize);
+		sizeleft = totalsize - sizeof(magic) - sizeof(totalsize);
+	}
 
-	sizeleft = totalsize - sizeof(magic) - sizeof(totalsize);
 	p = blob + sizeof(magic)  + sizeof(totalsize);
 
 	while (sizeleft) {
@@ -932,9 +1173,13 @@ struct dt_info *dt_from_blob(const char *fname)
 	if (val != FDT_END)
 		die("Device tree blob doesn't end with FDT_END\n");
 
-	free(blob);
-
 	fclose(f);
 
-	return build_dt_info(DTSF_V1, reservelist, tree, boot_cpuid_phys);
+	/* The tree refers to the blob, so it stays until free_dt_info() */
+	dti = build_dt_info(DTSF_V1, reservelist, tree, boot_cpuid_phys);
+	dti->blob = blob;
+	dti->blob_size = totalsize;
+	dti->blob_mapped = mapped;
+
+	return dti;
 }
@@ -0,0 +1,633 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307
+ *                                                                   USA
+ */
+
+#include <sys/stat.h>
+
+#include "dtc.h"
+#include "srcpos.h"
+#include "version_gen.h"
+
+/*
+ * Include cache
+ *
+ * A file /include/d between the top-level statements of a source file,
+ * as .dtsi files usually are, adds a sequence of complete statements to
+ * the tree.  When dtc is given a cache directory, the parser records
+ * those statements, with the nodes they add as parsed, and this stores
+ * them in a file named by a hash of the included file's name, contents
+ * and the search path.  Later compiles replay the statements from the
+ * cache instead of lexing and parsing the file.
+ *
+ * Each entry lists the other files (nested includes and incbins) its
+ * statements were parsed from, with a hash of their contents, and is
+ * only used while they are unchanged.
+ *
+ * The entry is a sequence of big-endian cells and nul-terminated strings:
+ *
+ *	magic, version, DTC_VERSION
+ *	number of files, then for each: name, hash (two cells)
+ *	number of statements, then for each:
+ *		type, file name, first/last line/column, label, ref, node
+ *
+ * Strings which may be missing are a cell, 1 if the string follows, else
+ * 0.  A node is its deleted flag, name, labels, properties and children,
+ * each list being a count followed by its entries.  A label is its
+ * deleted flag and name; a property its deleted flag, name, labels, value
+ * length and bytes, and markers (type, offset and ref).
+ */
+
+#define CACHE_MAGIC	0x64746363	/* "dtcc" */
+#define CACHE_VERSION	1
+
+struct recording {
+	char *path;			/* of the cache entry */
+	struct srcfile_state *file;	/* NULL until pushed */
+	bool ended;			/* file's EOF has been reached */
+	bool failed;			/* file isn't just statements */
+
+	char *name;			/* of the included file */
+	uint64_t hash;			/* of its contents */
+	int first_dep, end_dep;		/* see srcfile_opened_name() */
+
+	struct data stmts;
+	int num_stmts;
+};
+
+/* At most one file is recorded at a time; nested includes are part of it */
+static struct recording *rec;
+
+extern bool treesource_error;
+
+static bool hash_file(FILE *f, uint64_t *hash)
+{
+	char buf[4096];
+	uint64_t h = MEMHASH_INIT;
+	size_t len;
+
+	while ((len = fread(buf, 1, sizeof(buf), f)) > 0)
+		h = memhash(h, buf, len);
+	if (ferror(f))
+		return false;
+
+	*hash = h;
+	return true;
+}
+
+static bool hash_named_file(const char *name, uint64_t *hash)
+{
+	FILE *f = fopen(name, "rb");
+	bool ok;
+
+	if (!f)
+		return false;
+	ok = hash_file(f, hash);
+	fclose(f);
+	return ok;
+}
+
+/*
+ * Reading entries.  A corrupt or truncated entry just sets bad, and the
+ * included file is parsed instead.
+ */
+struct reader {
+	const char *p, *end;
+	bool bad;
+};
+
+static const char *read_mem(struct reader *r, size_t len)
+{
+	const char *p = r->p;
+
+	if (r->bad || (len > (size_t)(r->end - r->p))) {
+		r->bad = true;
+		return NULL;
+	}
+	r->p += len;
+	return p;
+}
+
+static uint32_t read_cell(struct reader *r)
+{
+	const fdt32_t *p = (const fdt32_t *)read_mem(r, sizeof(*p));
+	fdt32_t cell;
+
+	if (!p)
+		return 0;
+	memcpy(&cell, p, sizeof(cell));
+	return fdt32_to_cpu(cell);
+}
+
+static uint64_t read_u64(struct reader *r)
+{
+	uint64_t hi = read_cell(r);
+
+	return (hi << 32) | read_cell(r);
+}
+
+static const char *read_string(struct reader *r)
+{
+	const char *nul;
+
+	if (r->bad)
+		return "";
+	nul = memchr(r->p, '\0', r->end - r->p);
+	if (!nul) {
+		r->bad = true;
+		return "";
+	}
+	return read_mem(r, nul - r->p + 1);
+}
+
+static char *read_tree_string(struct reader *r)
+{
+	if (!read_cell(r))
+		return NULL;
+	return tree_strdup(read_string(r));
+}
+
+static struct label *read_labels(struct reader *r)
+{
+	struct label *labels = NULL, **tail = &labels;
+	uint32_t n = read_cell(r);
+
+	while (n-- && !r->bad) {
+		struct label *l = tree_alloc(sizeof(*l));
+
+		l->deleted = read_cell(r);
+		l->label = read_tree_string(r);
+		if (!l->label)
+			r->bad = true;
+		*tail = l;
+		tail = &l->next;
+	}
+	return labels;
+}
+
+static struct property *read_property(struct reader *r)
+{
+	struct marker *m, **tail;
+	struct property *prop;
+	struct data val = empty_data;
+	bool deleted;
+	char *name;
+	uint32_t len, n;
+
+	deleted = read_cell(r);
+	name = read_tree_string(r);
+	if (!name)
+		r->bad = true;
+
+	prop = build_property(name, empty_data);
+	prop->deleted = deleted;
+	prop->labels = read_labels(r);
+
+	len = read_cell(r);
+	if (len) {
+		const char *mem = read_mem(r, len);
+
+		if (mem)
+			val = data_copy_mem(mem, len);
+	}
+
+	tail = &val.markers;
+	n = read_cell(r);
+	while (n-- && !r->bad) {
+		m = tree_alloc(sizeof(*m));
+		m->type = read_cell(r);
+		m->offset = read_cell(r);
+		m->ref = read_tree_string(r);
+		if ((m->type > LABEL) || (m->offset > val.len))
+			r->bad = true;
+		*tail = m;
+		tail = &m->next;
+		val.last_marker = m;
+	}
+
+	prop->val = val;
+	return prop;
+}
+
+static struct node *read_node(struct reader *r)
+{
+	struct property *proplist = NULL;
+	struct node *children = NULL, **tail = &children;
+	struct node *node;
+	struct label *labels;
+	bool deleted;
+	char *name;
+	uint32_t n;
+
+	deleted = read_cell(r);
+	name = read_tree_string(r);
+	labels = read_labels(r);
+
+	/* build_node() reverses the properties back into order */
+	n = read_cell(r);
+	while (n-- && !r->bad)
+		proplist = chain_property(read_property(r), proplist);
+
+	n = read_cell(r);
+	while (n-- && !r->bad) {
+		*tail = read_node(r);
+		tail = &(*tail)->next_sibling;
+	}
+
+	node = build_node(proplist, children);
+	node->deleted = deleted;
+	node->name = name;
+	node->labels = labels;
+	return node;
+}
+
+static struct srcpos *read_srcpos(struct reader *r)
+{
+	static struct srcfile_state *last_file;
+	struct srcpos *pos = xmalloc(sizeof(*pos));
+	const char *name = read_string(r);
+
+	/* Like the parsed files', these states stay for diagnostics */
+	if (!last_file || !streq(last_file->name, name)) {
+		last_file = xmalloc(sizeof(*last_file));
+		memset(last_file, 0, sizeof(*last_file));
+		last_file->name = xstrdup(name);
+	}
+
+	pos->file = last_file;
+	pos->first_line = read_cell(r);
+	pos->first_column = read_cell(r);
+	pos->last_line = read_cell(r);
+	pos->last_column = read_cell(r);
+	return pos;
+}
+
+static struct cached_stmt *read_stmts(struct reader *r)
+{
+	struct cached_stmt *stmts = NULL, **tail = &stmts;
+	uint32_t n = read_cell(r);
+
+	while (n-- && !r->bad) {
+		struct cached_stmt *stmt = tree_alloc(sizeof(*stmt));
+
+		stmt->type = read_cell(r);
+		stmt->pos = read_srcpos(r);
+		stmt->label = read_tree_string(r);
+		stmt->ref = read_tree_string(r);
+		if (stmt->type != STMT_DELETE)
+			stmt->node = read_node(r);
+
+		if ((stmt->type > STMT_DELETE)
+		    || ((stmt->type != STMT_ROOT) && !stmt->ref))
+			r->bad = true;
+		*tail = stmt;
+		tail = &stmt->next;
+	}
+	return stmts;
+}
+
+static char *entry_path(const char *fullname, uint64_t hash)
+{
+	uint64_t key = MEMHASH_INIT;
+	char *path;
+
+	key = memhash(key, DTC_VERSION, sizeof(DTC_VERSION));
+	key = memhash(key, fullname, strlen(fullname) + 1);
+	key = srcfile_hash_search_path(key);
+	key = memhash(key, &hash, sizeof(hash));
+
+	xasprintf(&path, "%s/%016llx.dtcc", include_cache_dir,
+		  (unsigned long long)key);
+	return path;
+}
+
+/*
+ * Looks up the file f, named fullname, in the cache.  If it's there, sets
+ * *stmts and returns true.  Otherwise, f is left at its start, and is
+ * recorded if nothing else is being.
+ */
+static bool load_entry(FILE *f, const char *fullname,
+		       struct cached_stmt **stmts)
+{
+	struct reader r;
+	struct data entry;
+	struct stat st;
+	uint64_t filehash, hash;
+	char *path;
+	const char **deps;
+	uint32_t n, i;
+	FILE *ef;
+
+	if (fstat(fileno(f), &st) || !S_ISREG(st.st_mode))
+		return false;
+
+	if (!hash_file(f, &filehash)) {
+		rewind(f);
+		return false;
+	}
+	rewind(f);
+
+	path = entry_path(fullname, filehash);
+	ef = fopen(path, "rb");
+	if (ef) {
+		entry = data_copy_file(ef, -1);
+		fclose(ef);
+	} else {
+		entry = empty_data;
+	}
+
+	r.p = entry.val;
+	r.end = entry.val + entry.len;
+	r.bad = false;
+
+	if ((read_cell(&r) != CACHE_MAGIC) || (read_cell(&r) != CACHE_VERSION)
+	    || !streq(read_string(&r), DTC_VERSION))
+		r.bad = true;
+
+	/* The included file itself was checked by its hash in the key */
+	n = read_cell(&r);
+	if (n > entry.len)
+		r.bad = true;
+	deps = xmalloc((r.bad ? 0 : n) * sizeof(*deps));
+	for (i = 0; (i < n) && !r.bad; i++) {
+		uint64_t dephash;
+
+		deps[i] = read_string(&r);
+		dephash = read_u64(&r);
+		if ((i > 0) && !r.bad
+		    && (!hash_named_file(deps[i], &hash) || (hash != dephash)))
+			r.bad = true;
+	}
+
+	if (!r.bad)
+		*stmts = read_stmts(&r);
+
+	/* srcfile_relative_open() has listed the included file itself */
+	if (!r.bad && depfile)
+		for (i = 1; i < n; i++)
+			fprintf(depfile, " %s", deps[i]);
+
+	free(deps);
+	data_free(entry);
+
+	/* Record a missing, stale or corrupt entry */
+	if (r.bad && !rec) {
+		rec = xmalloc(sizeof(*rec));
+		memset(rec, 0, sizeof(*rec));
+		rec->path = path;
+		rec->name = xstrdup(fullname);
+		rec->hash = filehash;
+	} else {
+		free(path);
+	}
+
+	return !r.bad;
+}
+
+/*
+ * Opens the file fname, included between top-level statements, like
+ * srcfile_push().  If the cache has its statements, sets *stmts and
+ * returns true instead.
+ */
+bool include_cache_push(const char *fname, struct cached_stmt **stmts)
+{
+	char *fullname;
+	FILE *f;
+
+	/* Includes nested in a recorded file are recorded as part of it */
+	if (streq(fname, "-") || (rec && rec->file && !rec->ended)) {
+		srcfile_push(fname);
+		return false;
+	}
+
+	f = srcfile_relative_open(fname, &fullname);
+	if (load_entry(f, fullname, stmts)) {
+		fclose(f);
+		free(fullname);
+		return true;
+	}
+
+	srcfile_push_file(f, fullname);
+	if (rec && !rec->file) {
+		rec->file = current_srcfile;
+		rec->first_dep = srcfile_num_opened();
+	}
+	return false;
+}
+
+static bool recorded(struct srcpos *pos)
+{
+	struct srcfile_state *file;
+
+	if (!rec->file)
+		return false;
+
+	for (file = pos->file; file; file = file->prev)
+		if (file == rec->file)
+			return true;
+	return false;
+}
+
+static struct data write_cell(struct data d, uint32_t val)
+{
+	return data_append_cell(d, val);
+}
+
+static struct data write_string(struct data d, const char *s)
+{
+	d = write_cell(d, s != NULL);
+	if (s)
+		d = data_append_data(d, s, strlen(s) + 1);
+	return d;
+}
+
+static struct data write_labels(struct data d, struct label *labels)
+{
+	struct label *l;
+	int n = 0;
+
+	for_each_label_withdel(labels, l)
+		n++;
+	d = write_cell(d, n);
+	for_each_label_withdel(labels, l) {
+		d = write_cell(d, l->deleted);
+		d = write_string(d, l->label);
+	}
+	return d;
+}
+
+static struct data write_property(struct data d, struct property *prop)
+{
+	struct marker *m;
+	int n = 0;
+
+	d = write_cell(d, prop->deleted);
+	d = write_string(d, prop->name);
+	d = write_labels(d, prop->labels);
+
+	d = write_cell(d, prop->val.len);
+	d = data_append_data(d, prop->val.val, prop->val.len);
+
+	m = prop->val.markers;
+	for_each_marker(m)
+		n++;
+	d = write_cell(d, n);
+	m = prop->val.markers;
+	for_each_marker(m) {
+		d = write_cell(d, m->type);
+		d = write_cell(d, m->offset);
+		d = write_string(d, m->ref);
+	}
+	return d;
+}
+
+static struct data write_node(struct data d, struct node *node)
+{
+	struct property *prop;
+	struct node *child;
+	int n;
+
+	d = write_cell(d, node->deleted);
+	d = write_string(d, node->name);
+	d = write_labels(d, node->labels);
+
+	n = 0;
+	for_each_property_withdel(node, prop)
+		n++;
+	d = write_cell(d, n);
+	for_each_property_withdel(node, prop)
+		d = write_property(d, prop);
+
+	n = 0;
+	for_each_child_withdel(node, child)
+		n++;
+	d = write_cell(d, n);
+	for_each_child_withdel(node, child)
+		d = write_node(d, child);
+	return d;
+}
+
+/*
+ * Called by the parser with each top-level statement before it is applied
+ * to the tree.  Statements which come from the recorded file are added to
+ * its entry; the first one after it completes the entry.
+ */
+void include_cache_record(enum stmt_type type, struct srcpos *pos,
+			  char *label, char *ref, struct node *node)
+{
+	struct data d;
+
+	if (!rec)
+		return;
+
+	if (!recorded(pos)) {
+		if (rec->ended)
+			include_cache_finish();
+		return;
+	}
+
+	d = rec->stmts;
+	d = write_cell(d, type);
+	d = data_append_data(d, pos->file->name, strlen(pos->file->name) + 1);
+	d = write_cell(d, pos->first_line);
+	d = write_cell(d, pos->first_column);
+	d = write_cell(d, pos->last_line);
+	d = write_cell(d, pos->last_column);
+	d = write_string(d, label);
+	d = write_string(d, ref);
+	if (node)
+		d = write_node(d, node);
+	rec->stmts = d;
+	rec->num_stmts++;
+}
+
+/* Called by the parser for anything else, which can't be cached */
+void include_cache_reject(struct srcpos *pos)
+{
+	if (rec && recorded(pos))
+		rec->failed = true;
+}
+
+/* Called by the lexer at the end of each file */
+void include_cache_end_file(struct srcfile_state *file, bool complete)
+{
+	if (!rec || (file != rec->file))
+		return;
+
+	rec->ended = true;
+	rec->end_dep = srcfile_num_opened();
+	if (!complete)
+		rec->failed = true;
+}
+
+static void save_entry(void)
+{
+	struct data d = empty_data;
+	char *tmpname;
+	uint64_t hash;
+	FILE *f;
+	int i;
+
+	d = write_cell(d, CACHE_MAGIC);
+	d = write_cell(d, CACHE_VERSION);
+	d = data_append_data(d, DTC_VERSION, sizeof(DTC_VERSION));
+
+	d = write_cell(d, 1 + rec->end_dep - rec->first_dep);
+	d = data_append_data(d, rec->name, strlen(rec->name) + 1);
+	d = data_append_integer(d, rec->hash, 64);
+	for (i = rec->first_dep; i < rec->end_dep; i++) {
+		const char *name = srcfile_opened_name(i);
+
+		if (!hash_named_file(name, &hash))
+			goto out;
+		d = data_append_data(d, name, strlen(name) + 1);
+		d = data_append_integer(d, hash, 64);
+	}
+
+	d = write_cell(d, rec->num_stmts);
+	d = data_append_data(d, rec->stmts.val, rec->stmts.len);
+
+	/* Concurrent compiles may write the same entry */
+	xasprintf(&tmpname, "%s.%d", rec->path, (int)getpid());
+	f = fopen(tmpname, "wb");
+	if (!f || (fwrite(d.val, 1, d.len, f) != d.len) || fclose(f)
+	    || rename(tmpname, rec->path)) {
+		if (quiet < 1)
+			fprintf(stderr, "Warning: Couldn't write include cache "
+				"entry %s: %s\n", rec->path, strerror(errno));
+		unlink(tmpname);
+	}
+	free(tmpname);
+
+out:
+	data_free(d);
+}
+
+/* Writes out the entry being recorded, if it's complete */
+void include_cache_finish(void)
+{
+	if (!rec)
+		return;
+
+	if (rec->ended && !rec->failed && !treesource_error
+	    && (rec->num_stmts > 0))
+		save_entry();
+
+	free(rec->name);
+	data_free(rec->stmts);
+	free(rec->path);
+	free(rec);
+	rec = NULL;
+}
@@ -74,6 +74,127 @@ int fdt_check_header(const void *fdt)
 	return 0;
 }
 
+int fdt_check_full(const void *fdt, size_t bufsize)
+{
+	unsigned int hdrsize, strsize, off;
+	const struct fdt_reserve_entry *re;
+	const struct fdt_property *prop;
+	int offset, nextoffset, depth = 0;
+	int seen_root = 0;
+	uint32_t tag;
+	int err;
+
+	if (bufsize < FDT_V1_SIZE)
+		return -FDT_ERR_TRUNCATED;
+	if ((err = fdt_check_header(fdt)) != 0)
+		return err;
+	if (fdt_magic(fdt) != FDT_MAGIC)
+		return -FDT_ERR_BADSTATE;
+	if (fdt_totalsize(fdt) > bufsize)
+		return -FDT_ERR_TRUNCATED;
+
+	hdrsize = (fdt_version(fdt) >= 17) ? FDT_V17_SIZE : FDT_V16_SIZE;
+	if (fdt_totalsize(fdt) < hdrsize)
+		return -FDT_ERR_TRUNCATED;
+
+	/* Check the blocks lie within the blob */
+	if ((fdt_off_dt_struct(fdt) < hdrsize)
+	    || (fdt_off_dt_struct(fdt) > fdt_totalsize(fdt))
+	    || (fdt_off_dt_strings(fdt) < hdrsize)
+	    || (fdt_off_dt_strings(fdt) > fdt_totalsize(fdt))
+	    || (fdt_off_mem_rsvmap(fdt) < hdrsize)
+	    || (fdt_off_mem_rsvmap(fdt) > fdt_totalsize(fdt)))
+		return -FDT_ERR_TRUNCATED;
+
+	if ((fdt_version(fdt) >= 17)
+	    && (fdt_size_dt_struct(fdt)
+		> (fdt_totalsize(fdt) - fdt_off_dt_struct(fdt))))
+		return -FDT_ERR_TRUNCATED;
+
+	strsize = fdt_size_dt_strings(fdt);
+	if (strsize > (fdt_totalsize(fdt) - fdt_off_dt_strings(fdt)))
+		return -FDT_ERR_TRUNCATED;
+
+	/* Check the reserve map is terminated within the blob */
+	if (fdt_off_mem_rsvmap(fdt) % sizeof(uint64_t))
+		return -FDT_ERR_BADOFFSET;
+	off = fdt_off_mem_rsvmap(fdt);
+	do {
+		if ((fdt_totalsize(fdt) - off) < sizeof(*re))
+			return -FDT_ERR_TRUNCATED;
+		re = (const struct fdt_reserve_entry *)((const char *)fdt + off);
+		off += sizeof(*re);
+	} while (fdt64_to_cpu(re->size) != 0);
+
+	/* Walk the structure block, checking the nesting and names */
+	offset = 0;
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+		if (nextoffset < 0)
+			return nextoffset;
+
+		switch (tag) {
+		case FDT_NOP:
+			break;
+
+		case FDT_BEGIN_NODE:
+			if ((depth == 0) && seen_root)
+				return -FDT_ERR_BADSTRUCTURE;
+			seen_root = 1;
+			depth++;
+			break;
+
+		case FDT_END_NODE:
+			if (depth == 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			depth--;
+			break;
+
+		case FDT_PROP:
+			if (depth == 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			prop = _fdt_offset_ptr(fdt, offset);
+			off = fdt32_to_cpu(prop->nameoff);
+			if ((off >= strsize)
+			    || !memchr(fdt_string(fdt, off), '\0', strsize - off))
+				return -FDT_ERR_BADSTRUCTURE;
+			break;
+
+		case FDT_END:
+			if ((depth != 0) || !seen_root)
+				return -FDT_ERR_BADSTRUCTURE;
+			break;
+		}
+
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	return 0;
+}
+
+/*
+ * Returns the number of bytes which may be accessed from the given
+ * structure block offset, under the same rules as fdt_offset_ptr().
+ */
+static unsigned int _fdt_struct_space(const void *fdt, int offset)
+{
+	unsigned absoffset = offset + fdt_off_dt_struct(fdt);
+	unsigned space;
+
+	if ((absoffset < offset) || (absoffset >= fdt_totalsize(fdt)))
+		return 0;
+	space = fdt_totalsize(fdt) - absoffset;
+
+	if (fdt_version(fdt) >= 0x11) {
+		if (offset >= fdt_size_dt_struct(fdt))
+			return 0;
+		if ((fdt_size_dt_struct(fdt) - offset) < space)
+			space = fdt_size_dt_struct(fdt) - offset;
+	}
+
+	return space;
+}
+
 const void *fdt_offset_ptr(const void *fdt, int offset, unsigned int len)
 {
 	unsigned absoffset = offset + fdt_off_dt_struct(fdt);
@@ -96,7 +217,7 @@ uint32_t fdt_next_tag(const void *fdt, int startoffset, int *nextoffset)
 	const fdt32_t *tagp, *lenp;
 	uint32_t tag;
 	int offset = startoffset;
-	const char *p;
+	const char *p, *q;
 
 	*nextoffset = -FDT_ERR_TRUNCATED;
 	tagp = fdt_offset_ptr(fdt, offset, FDT_TAGSIZE);
@@ -108,12 +229,12 @@ uint32_t fdt_next_tag(const void *fdt, int startoffset, int *nextoffset)
 	*nextoffset = -FDT_ERR_BADSTRUCTURE;
 	switch (tag) {
 	case FDT_BEGIN_NODE:
-		/* skip name */
-		do {
-			p = fdt_offset_ptr(fdt, offset++, 1);
-		} while (p && (*p != '\0'));
-		if (!p)
+		/* skip name, in one go rather than byte by byte */
+		p = _fdt_offset_ptr(fdt, offset);
+		q = memchr(p, '\0', _fdt_struct_space(fdt, offset));
+		if (!q)
 			return FDT_END; /* premature end */
+		offset += q - p + 1;
 		break;
 
 	case FDT_PROP:
@@ -227,6 +348,84 @@ int fdt_next_subnode(const void *fdt, int offset)
 	return offset;
 }
 
+uint32_t fdt_next_tag_trusted(const void *fdt, int startoffset, int *nextoffset)
+{
+	const fdt32_t *tagp = _fdt_offset_ptr(fdt, startoffset);
+	const struct fdt_property *prop;
+	uint32_t tag = fdt32_to_cpu(*tagp);
+	int offset = startoffset + FDT_TAGSIZE;
+
+	switch (tag) {
+	case FDT_BEGIN_NODE:
+		/* the name is known to be terminated, let strlen() skip it */
+		offset += strlen(_fdt_offset_ptr(fdt, offset)) + 1;
+		break;
+
+	case FDT_PROP:
+		prop = (const struct fdt_property *)tagp;
+		offset += sizeof(*prop) - FDT_TAGSIZE + fdt32_to_cpu(prop->len);
+		break;
+	}
+
+	*nextoffset = FDT_TAGALIGN(offset);
+	return tag;
+}
+
+int fdt_next_node_trusted(const void *fdt, int offset, int *depth)
+{
+	int nextoffset = 0;
+	uint32_t tag;
+
+	if (offset >= 0)
+		fdt_next_tag_trusted(fdt, offset, &nextoffset);
+
+	do {
+		offset = nextoffset;
+		tag = fdt_next_tag_trusted(fdt, offset, &nextoffset);
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (depth)
+				(*depth)++;
+			break;
+
+		case FDT_END_NODE:
+			if (depth && ((--(*depth)) < 0))
+				return nextoffset;
+			break;
+
+		case FDT_END:
+			return -FDT_ERR_NOTFOUND;
+		}
+	} while (tag != FDT_BEGIN_NODE);
+
+	return offset;
+}
+
+int fdt_first_subnode_trusted(const void *fdt, int offset)
+{
+	int depth = 0;
+
+	offset = fdt_next_node_trusted(fdt, offset, &depth);
+	if (offset < 0 || depth != 1)
+		return -FDT_ERR_NOTFOUND;
+
+	return offset;
+}
+
+int fdt_next_subnode_trusted(const void *fdt, int offset)
+{
+	int depth = 1;
+
+	do {
+		offset = fdt_next_node_trusted(fdt, offset, &depth);
+		if (offset < 0 || depth < 1)
+			return -FDT_ERR_NOTFOUND;
+	} while (depth > 1);
+
+	return offset;
+}
+
 const char *_fdt_find_string(const char *strtab, int tabsize, const char *s)
 {
 	int len = strlen(s) + 1;
@@ -0,0 +1,1170 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *
+ * libfdt is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This library is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This library is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "libfdt_env.h"
+
+#include <fdt.h>
+#include <libfdt.h>
+
+#include "libfdt_internal.h"
+
+int fdt_index_size(const void *fdt)
+{
+	int offset = 0, nextoffset, count = 0;
+	uint32_t tag;
+
+	FDT_CHECK_HEADER(fdt);
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+		if (tag == FDT_BEGIN_NODE)
+			count++;
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	/* An unfinished sequential-write tree has no FDT_END tag */
+	if ((nextoffset < 0) && (nextoffset != -FDT_ERR_TRUNCATED))
+		return nextoffset;
+
+	if (count > ((INT32_MAX - sizeof(struct fdt_index_header))
+		     / sizeof(struct fdt_index_node)))
+		return -FDT_ERR_NOSPACE;
+
+	return sizeof(struct fdt_index_header)
+		+ count * sizeof(struct fdt_index_node);
+}
+
+int fdt_index_build(const void *fdt, void *idx, int idxsize)
+{
+	struct fdt_index_header *hdr = idx;
+	struct fdt_index_node *nodes = (struct fdt_index_node *)(hdr + 1);
+	int maxnodes, n = 0, cur = -1, prev = -1;
+	int offset = 0, nextoffset;
+	uint32_t tag;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (idxsize < (int)sizeof(*hdr))
+		return -FDT_ERR_NOSPACE;
+	maxnodes = (idxsize - sizeof(*hdr)) / sizeof(*nodes);
+
+	/* Not usable until we've finished filling it in */
+	hdr->magic = 0;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if ((cur < 0) && (n > 0))
+				return -FDT_ERR_BADSTRUCTURE; /* second root */
+			if (n >= maxnodes)
+				return -FDT_ERR_NOSPACE;
+
+			nodes[n].offset = offset;
+			nodes[n].end = -1;
+			nodes[n].depth = (cur >= 0) ? nodes[cur].depth + 1 : 0;
+			nodes[n].parent = cur;
+			nodes[n].first_child = -1;
+			nodes[n].next_sibling = -1;
+
+			if (prev >= 0)
+				nodes[prev].next_sibling = n;
+			else if (cur >= 0)
+				nodes[cur].first_child = n;
+
+			cur = n++;
+			prev = -1;
+			break;
+
+		case FDT_END_NODE:
+			if (cur < 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			nodes[cur].end = nextoffset;
+			prev = cur;
+			cur = nodes[cur].parent;
+			break;
+
+		case FDT_END:
+			if ((nextoffset < 0)
+			    && ((nextoffset != -FDT_ERR_TRUNCATED) || (cur >= 0)))
+				return nextoffset;
+			break;
+		}
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	if ((cur >= 0) || (n == 0))
+		return -FDT_ERR_BADSTRUCTURE;
+
+	hdr->size_dt_struct = fdt_size_dt_struct(fdt);
+	hdr->num_nodes = n;
+	hdr->reserved = 0;
+	hdr->magic = FDT_INDEX_MAGIC;
+
+	return 0;
+}
+
+/*
+ * Returns the index header if idx is a usable index for fdt, or NULL
+ * if the caller should fall back to scanning the structure block.
+ */
+static const struct fdt_index_header *_fdt_index_get(const void *fdt,
+						     const void *idx)
+{
+	const struct fdt_index_header *hdr = idx;
+
+	if (!hdr || (hdr->magic != FDT_INDEX_MAGIC)
+	    || (hdr->size_dt_struct != fdt_size_dt_struct(fdt)))
+		return NULL;
+
+	return hdr;
+}
+
+/* Nodes are recorded in structure block order, so bisect on offset */
+static int _fdt_index_find(const struct fdt_index_header *hdr, int nodeoffset)
+{
+	const struct fdt_index_node *nodes = _fdt_index_nodes(hdr);
+	int lo = 0, hi = hdr->num_nodes;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (nodes[mid].offset < nodeoffset)
+			lo = mid + 1;
+		else if (nodes[mid].offset > nodeoffset)
+			hi = mid;
+		else
+			return mid;
+	}
+
+	return -FDT_ERR_BADOFFSET;
+}
+
+int fdt_index_subnode_offset_namelen(const void *fdt, const void *idx,
+				     int parentoffset,
+				     const char *name, int namelen)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	const struct fdt_index_node *nodes;
+	int n;
+
+	if (!hdr)
+		return fdt_subnode_offset_namelen(fdt, parentoffset,
+						  name, namelen);
+
+	FDT_CHECK_HEADER(fdt);
+
+	n = _fdt_index_find(hdr, parentoffset);
+	if (n < 0)
+		return n;
+
+	nodes = _fdt_index_nodes(hdr);
+	for (n = nodes[n].first_child; n >= 0; n = nodes[n].next_sibling)
+		if (_fdt_nodename_eq(fdt, nodes[n].offset, name, namelen))
+			return nodes[n].offset;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_index_subnode_offset(const void *fdt, const void *idx,
+			     int parentoffset, const char *name)
+{
+	return fdt_index_subnode_offset_namelen(fdt, idx, parentoffset,
+						name, strlen(name));
+}
+
+static const char *_fdt_index_get_alias_namelen(const void *fdt,
+						const void *idx,
+						const char *name, int namelen)
+{
+	int aliasoffset;
+
+	aliasoffset = fdt_index_subnode_offset(fdt, idx, 0, "aliases");
+	if (aliasoffset < 0)
+		return NULL;
+
+	return fdt_getprop_namelen(fdt, aliasoffset, name, namelen, NULL);
+}
+
+int fdt_index_path_offset_namelen(const void *fdt, const void *idx,
+				  const char *path, int namelen)
+{
+	const char *end = path + namelen;
+	const char *p = path;
+	int offset = 0;
+
+	if (!_fdt_index_get(fdt, idx))
+		return fdt_path_offset_namelen(fdt, path, namelen);
+
+	FDT_CHECK_HEADER(fdt);
+
+	/* see if we have an alias */
+	if (*path != '/') {
+		const char *q = memchr(path, '/', end - p);
+
+		if (!q)
+			q = end;
+
+		p = _fdt_index_get_alias_namelen(fdt, idx, p, q - p);
+		if (!p)
+			return -FDT_ERR_BADPATH;
+		offset = fdt_index_path_offset(fdt, idx, p);
+
+		p = q;
+	}
+
+	while (p < end) {
+		const char *q;
+
+		while (*p == '/') {
+			p++;
+			if (p == end)
+				return offset;
+		}
+		q = memchr(p, '/', end - p);
+		if (! q)
+			q = end;
+
+		offset = fdt_index_subnode_offset_namelen(fdt, idx, offset,
+							  p, q-p);
+		if (offset < 0)
+			return offset;
+
+		p = q;
+	}
+
+	return offset;
+}
+
+int fdt_index_path_offset(const void *fdt, const void *idx, const char *path)
+{
+	return fdt_index_path_offset_namelen(fdt, idx, path, strlen(path));
+}
+
+int fdt_index_first_subnode(const void *fdt, const void *idx, int offset)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	int n;
+
+	if (!hdr)
+		return fdt_first_subnode(fdt, offset);
+
+	n = _fdt_index_find(hdr, offset);
+	if (n < 0)
+		return n;
+
+	n = _fdt_index_nodes(hdr)[n].first_child;
+	if (n < 0)
+		return -FDT_ERR_NOTFOUND;
+
+	return _fdt_index_nodes(hdr)[n].offset;
+}
+
+int fdt_index_next_subnode(const void *fdt, const void *idx, int offset)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	int n;
+
+	if (!hdr)
+		return fdt_next_subnode(fdt, offset);
+
+	n = _fdt_index_find(hdr, offset);
+	if (n < 0)
+		return n;
+
+	n = _fdt_index_nodes(hdr)[n].next_sibling;
+	if (n < 0)
+		return -FDT_ERR_NOTFOUND;
+
+	return _fdt_index_nodes(hdr)[n].offset;
+}
+
+int fdt_index_get_path(const void *fdt, const void *idx, int nodeoffset,
+		       char *buf, int buflen)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	const struct fdt_index_node *nodes;
+	const char *name;
+	int n, i, namelen, len, p;
+
+	if (!hdr)
+		return fdt_get_path(fdt, nodeoffset, buf, buflen);
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (buflen < 2)
+		return -FDT_ERR_NOSPACE;
+
+	n = _fdt_index_find(hdr, nodeoffset);
+	if (n < 0)
+		return n;
+	nodes = _fdt_index_nodes(hdr);
+
+	/* First work out how much room we need... */
+	len = 1;
+	for (i = n; nodes[i].parent >= 0; i = nodes[i].parent) {
+		name = fdt_get_name(fdt, nodes[i].offset, &namelen);
+		if (!name)
+			return namelen;
+		len += namelen + 1;
+	}
+	if (len == 1)
+		len++; /* special case so that root path is "/", not "" */
+
+	if (len > buflen)
+		return -FDT_ERR_NOSPACE;
+
+	/* ...then fill in the components from the leaf upwards */
+	p = len - 1;
+	buf[p] = '\0';
+	buf[0] = '/';
+	for (i = n; nodes[i].parent >= 0; i = nodes[i].parent) {
+		name = fdt_get_name(fdt, nodes[i].offset, &namelen);
+		p -= namelen;
+		memcpy(buf + p, name, namelen);
+		buf[--p] = '/';
+	}
+
+	return 0;
+}
+
+int fdt_index_supernode_atdepth_offset(const void *fdt, const void *idx,
+				       int nodeoffset, int supernodedepth,
+				       int *nodedepth)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	const struct fdt_index_node *nodes;
+	int n, depth;
+
+	if (!hdr)
+		return fdt_supernode_atdepth_offset(fdt, nodeoffset,
+						    supernodedepth, nodedepth);
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (supernodedepth < 0)
+		return -FDT_ERR_NOTFOUND;
+
+	n = _fdt_index_find(hdr, nodeoffset);
+	if (n < 0)
+		return n;
+	nodes = _fdt_index_nodes(hdr);
+
+	depth = nodes[n].depth;
+	if (nodedepth)
+		*nodedepth = depth;
+
+	if (supernodedepth > depth)
+		return -FDT_ERR_NOTFOUND;
+
+	while (depth-- > supernodedepth)
+		n = nodes[n].parent;
+
+	return nodes[n].offset;
+}
+
+int fdt_index_node_depth(const void *fdt, const void *idx, int nodeoffset)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	int n;
+
+	if (!hdr)
+		return fdt_node_depth(fdt, nodeoffset);
+
+	FDT_CHECK_HEADER(fdt);
+
+	n = _fdt_index_find(hdr, nodeoffset);
+	if (n < 0)
+		return n;
+
+	return _fdt_index_nodes(hdr)[n].depth;
+}
+
+int fdt_index_parent_offset(const void *fdt, const void *idx, int nodeoffset)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	const struct fdt_index_node *nodes;
+	int n;
+
+	if (!hdr)
+		return fdt_parent_offset(fdt, nodeoffset);
+
+	FDT_CHECK_HEADER(fdt);
+
+	n = _fdt_index_find(hdr, nodeoffset);
+	if (n < 0)
+		return n;
+	nodes = _fdt_index_nodes(hdr);
+
+	if (nodes[n].parent < 0)
+		return -FDT_ERR_NOTFOUND;
+
+	return nodes[nodes[n].parent].offset;
+}
+
+int fdt_index_node_end_offset(const void *fdt, const void *idx,
+			      int nodeoffset)
+{
+	const struct fdt_index_header *hdr = _fdt_index_get(fdt, idx);
+	int n, depth = 0;
+
+	if (!hdr) {
+		n = nodeoffset;
+		do {
+			n = fdt_next_node(fdt, n, &depth);
+		} while ((n >= 0) && (depth >= 0));
+		return n;
+	}
+
+	FDT_CHECK_HEADER(fdt);
+
+	n = _fdt_index_find(hdr, nodeoffset);
+	if (n < 0)
+		return n;
+
+	return _fdt_index_nodes(hdr)[n].end;
+}
+
+/*
+ * Phandle map
+ */
+#define FDT_PHANDLE_MAP_MIN_SLOTS	8
+
+static inline struct fdt_phandle_map_slot *_fdt_phandle_map_slots(void *map)
+{
+	return (struct fdt_phandle_map_slot *)
+		((struct fdt_phandle_map_header *)map + 1);
+}
+
+static inline uint32_t _fdt_phandle_hash(uint32_t phandle, uint32_t mask)
+{
+	/* Fibonacci hashing: phandles are usually small and dense */
+	return (phandle * 0x9e3779b1U) & mask;
+}
+
+static int _fdt_phandle_valid(uint32_t phandle)
+{
+	return (phandle != 0) && (phandle != (uint32_t)-1);
+}
+
+/* Returns the slot holding phandle, or the empty slot where it belongs */
+static uint32_t _fdt_phandle_map_probe(const struct fdt_phandle_map_header *hdr,
+				       uint32_t phandle)
+{
+	const struct fdt_phandle_map_slot *slots =
+		_fdt_phandle_map_slots((void *)(uintptr_t)hdr);
+	uint32_t i = _fdt_phandle_hash(phandle, hdr->mask);
+
+	while (slots[i].phandle && (slots[i].phandle != phandle))
+		i = (i + 1) & hdr->mask;
+
+	return i;
+}
+
+static int _fdt_phandle_map_insert(struct fdt_phandle_map_header *hdr,
+				   uint32_t phandle, int offset, int replace)
+{
+	struct fdt_phandle_map_slot *slots = _fdt_phandle_map_slots(hdr);
+	uint32_t i = _fdt_phandle_map_probe(hdr, phandle);
+
+	if (slots[i].phandle) {
+		if (replace)
+			slots[i].offset = offset;
+		return 0;
+	}
+
+	/* Keep the load factor at or below 3/4 so probe chains stay short */
+	if ((hdr->count + 1) > ((hdr->mask + 1) / 4) * 3)
+		return -FDT_ERR_NOSPACE;
+
+	slots[i].phandle = phandle;
+	slots[i].offset = offset;
+	hdr->count++;
+	if (phandle > hdr->max_phandle)
+		hdr->max_phandle = phandle;
+
+	return 0;
+}
+
+/*
+ * Walks the structure block once, calling _fdt_phandle_map_insert()
+ * for each node with a valid phandle (if hdr is non-NULL), and
+ * returns the number of such nodes.
+ */
+static int _fdt_phandle_map_scan(const void *fdt,
+				 struct fdt_phandle_map_header *hdr)
+{
+	int offset = 0, nextoffset, node = -1;
+	uint32_t phandle = 0, tag;
+	int have_phandle = 0;	/* phandle came from "phandle" itself */
+	int count = 0, err;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+
+		switch (tag) {
+		case FDT_PROP: {
+			const struct fdt_property *prop;
+			const char *name;
+
+			if (have_phandle)
+				break;
+			prop = _fdt_offset_ptr(fdt, offset);
+			if (fdt32_to_cpu(prop->len) != sizeof(fdt32_t))
+				break;
+			name = fdt_string(fdt, fdt32_to_cpu(prop->nameoff));
+			if (strcmp(name, "phandle") == 0)
+				have_phandle = 1;
+			else if (phandle || (strcmp(name, "linux,phandle") != 0))
+				break;
+			phandle = fdt32_to_cpu(*(const fdt32_t *)prop->data);
+			break;
+		}
+
+		case FDT_BEGIN_NODE:
+		case FDT_END_NODE:
+		case FDT_END:
+			/* Properties always precede subnodes, so we're
+			 * done with the current node */
+			if ((node >= 0) && _fdt_phandle_valid(phandle)) {
+				if (hdr) {
+					err = _fdt_phandle_map_insert(hdr,
+								phandle,
+								node, 0);
+					if (err)
+						return err;
+				}
+				count++;
+			}
+			phandle = 0;
+			have_phandle = 0;
+			node = (tag == FDT_BEGIN_NODE) ? offset : -1;
+			break;
+		}
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	/* An unfinished sequential-write tree has no FDT_END tag */
+	if ((nextoffset < 0) && (nextoffset != -FDT_ERR_TRUNCATED))
+		return nextoffset;
+
+	return count;
+}
+
+int fdt_phandle_map_size(const void *fdt, int extra)
+{
+	uint32_t slots = FDT_PHANDLE_MAP_MIN_SLOTS;
+	int count;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (extra < 0)
+		return -FDT_ERR_BADVALUE;
+
+	count = _fdt_phandle_map_scan(fdt, NULL);
+	if (count < 0)
+		return count;
+
+	/* Aim for a load factor of 1/2 */
+	while (slots < 2 * ((uint32_t)count + extra)) {
+		slots *= 2;
+		if (slots > (INT32_MAX - sizeof(struct fdt_phandle_map_header))
+		    / sizeof(struct fdt_phandle_map_slot))
+			return -FDT_ERR_NOSPACE;
+	}
+
+	return sizeof(struct fdt_phandle_map_header)
+		+ slots * sizeof(struct fdt_phandle_map_slot);
+}
+
+int fdt_phandle_map_build(const void *fdt, void *map, int mapsize)
+{
+	struct fdt_phandle_map_header *hdr = map;
+	uint32_t slots = FDT_PHANDLE_MAP_MIN_SLOTS;
+	int err;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (mapsize < (int)(sizeof(*hdr) + slots
+			    * sizeof(struct fdt_phandle_map_slot)))
+		return -FDT_ERR_NOSPACE;
+
+	/* Use the largest power of two number of slots that fits */
+	while ((sizeof(*hdr) + 2 * slots * sizeof(struct fdt_phandle_map_slot))
+	       <= (unsigned)mapsize)
+		slots *= 2;
+
+	hdr->magic = 0;
+	hdr->mask = slots - 1;
+	hdr->count = 0;
+	hdr->max_phandle = 0;
+	memset(_fdt_phandle_map_slots(map), 0,
+	       slots * sizeof(struct fdt_phandle_map_slot));
+
+	err = _fdt_phandle_map_scan(fdt, hdr);
+	if (err < 0)
+		return err;
+
+	hdr->magic = FDT_PHANDLE_MAP_MAGIC;
+	return 0;
+}
+
+static int _fdt_phandle_map_ok(const void *map)
+{
+	return map && (((const struct fdt_phandle_map_header *)map)->magic
+		       == FDT_PHANDLE_MAP_MAGIC);
+}
+
+int fdt_phandle_map_node_offset(const void *fdt, const void *map,
+				uint32_t phandle)
+{
+	const struct fdt_phandle_map_header *hdr = map;
+	const struct fdt_phandle_map_slot *slots;
+	uint32_t i;
+	int offset;
+
+	if (!_fdt_phandle_map_ok(map))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	if (!_fdt_phandle_valid(phandle))
+		return -FDT_ERR_BADPHANDLE;
+
+	FDT_CHECK_HEADER(fdt);
+
+	slots = _fdt_phandle_map_slots((void *)(uintptr_t)map);
+	i = _fdt_phandle_map_probe(hdr, phandle);
+	if (!slots[i].phandle)
+		return -FDT_ERR_NOTFOUND;
+
+	/* Cheap sanity check, in case the map wasn't kept up to date */
+	offset = slots[i].offset;
+	if (fdt_get_phandle(fdt, offset) != phandle)
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	return offset;
+}
+
+uint32_t fdt_phandle_map_get_max_phandle(const void *fdt, const void *map)
+{
+	if (!_fdt_phandle_map_ok(map))
+		return fdt_get_max_phandle(fdt);
+
+	return ((const struct fdt_phandle_map_header *)map)->max_phandle;
+}
+
+int fdt_phandle_map_set(void *map, uint32_t phandle, int nodeoffset)
+{
+	if (!_fdt_phandle_map_ok(map))
+		return -FDT_ERR_BADVALUE;
+
+	if (!_fdt_phandle_valid(phandle))
+		return -FDT_ERR_BADPHANDLE;
+
+	if (nodeoffset < 0)
+		return -FDT_ERR_BADOFFSET;
+
+	return _fdt_phandle_map_insert(map, phandle, nodeoffset, 1);
+}
+
+int fdt_phandle_map_shift(void *map, int nodeoffset, int delta)
+{
+	struct fdt_phandle_map_header *hdr = map;
+	struct fdt_phandle_map_slot *slots;
+	uint32_t i;
+
+	if (!_fdt_phandle_map_ok(map))
+		return -FDT_ERR_BADVALUE;
+
+	slots = _fdt_phandle_map_slots(map);
+	for (i = 0; i <= hdr->mask; i++)
+		if (slots[i].phandle && (slots[i].offset > nodeoffset))
+			slots[i].offset += delta;
+
+	return 0;
+}
+
+/* Backward shift deletion, so that no tombstones are needed */
+static void _fdt_phandle_map_remove_slot(struct fdt_phandle_map_header *hdr,
+					 uint32_t i)
+{
+	struct fdt_phandle_map_slot *slots = _fdt_phandle_map_slots(hdr);
+	uint32_t j = i, k;
+
+	for (;;) {
+		j = (j + 1) & hdr->mask;
+		if (!slots[j].phandle)
+			break;
+		k = _fdt_phandle_hash(slots[j].phandle, hdr->mask);
+		/* Leave it be if its home slot is cyclically in (i, j] */
+		if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+			continue;
+		slots[i] = slots[j];
+		i = j;
+	}
+	slots[i].phandle = 0;
+	hdr->count--;
+}
+
+int fdt_phandle_map_del_node(void *map, int nodeoffset, int len)
+{
+	struct fdt_phandle_map_header *hdr = map;
+	struct fdt_phandle_map_slot *slots;
+	uint32_t start, i, n;
+
+	if (!_fdt_phandle_map_ok(map))
+		return -FDT_ERR_BADVALUE;
+
+	if ((nodeoffset < 0) || (len < 0))
+		return -FDT_ERR_BADOFFSET;
+
+	slots = _fdt_phandle_map_slots(map);
+
+	/* Start just after an empty slot (there always is one), so that
+	 * entries moved down by a deletion are ones we've yet to visit */
+	for (start = 0; slots[start].phandle; start++)
+		;
+
+	for (n = 1; n <= hdr->mask + 1; n++) {
+		i = (start + n) & hdr->mask;
+		while (slots[i].phandle && (slots[i].offset >= nodeoffset)
+		       && (slots[i].offset < nodeoffset + len))
+			_fdt_phandle_map_remove_slot(hdr, i);
+	}
+
+	hdr->max_phandle = 0;
+	for (i = 0; i <= hdr->mask; i++) {
+		if (!slots[i].phandle)
+			continue;
+		if (slots[i].offset > nodeoffset)
+			slots[i].offset -= len;
+		if (slots[i].phandle > hdr->max_phandle)
+			hdr->max_phandle = slots[i].phandle;
+	}
+
+	return 0;
+}
+
+/*
+ * Compatible matching
+ */
+
+/*
+ * Walks the structure block once, calling fn() for every string of
+ * every node's compatible property, with the structure block offset
+ * of the string and its position in the list.  Stops early if fn()
+ * returns non-zero, and returns that value.
+ */
+static int _fdt_compat_scan(const void *fdt,
+			    int (*fn)(const void *fdt, void *ctx,
+				      int nodeoffset, int stroffset,
+				      int priority),
+			    void *ctx)
+{
+	int offset = 0, nextoffset, node = -1;
+	int32_t compat_nameoff = -1;
+	uint32_t tag;
+	int err;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+
+		if (tag == FDT_BEGIN_NODE) {
+			node = offset;
+		} else if ((tag == FDT_PROP) && (node >= 0)) {
+			const struct fdt_property *prop;
+			int32_t nameoff;
+			int len, pos, priority = 0;
+
+			prop = _fdt_offset_ptr(fdt, offset);
+			nameoff = fdt32_to_cpu(prop->nameoff);
+			/* dtc merges identical names, so once we've
+			 * seen "compatible" this is usually a single
+			 * integer compare */
+			if (nameoff != compat_nameoff) {
+				if (strcmp(fdt_string(fdt, nameoff),
+					   "compatible") != 0)
+					goto next;
+				compat_nameoff = nameoff;
+			}
+
+			len = fdt32_to_cpu(prop->len);
+			pos = 0;
+			while (pos < len) {
+				const char *s = prop->data + pos;
+				int slen = strnlen(s, len - pos);
+
+				if (pos + slen >= len)
+					break; /* not NUL terminated */
+				err = fn(fdt, ctx, node,
+					 (s - (const char *)_fdt_offset_ptr(fdt, 0)),
+					 priority++);
+				if (err)
+					return err;
+				pos += slen + 1;
+			}
+		}
+	next:
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	/* An unfinished sequential-write tree has no FDT_END tag */
+	if ((nextoffset < 0) && (nextoffset != -FDT_ERR_TRUNCATED))
+		return nextoffset;
+
+	return 0;
+}
+
+struct _fdt_match_ctx {
+	const char *const *table;
+	const int32_t *sorted;	/* table entries, sorted by string */
+	int nsorted;
+	struct fdt_compatible_match *matches;
+	int maxmatches;
+	int count;
+};
+
+/* Orders table entries by string, then by position in the table */
+static int _fdt_match_cmp(const char *const *table, int32_t a, int32_t b)
+{
+	int cmp = strcmp(table[a], table[b]);
+
+	if (cmp)
+		return cmp;
+	return (a > b) - (a < b);
+}
+
+static void _fdt_match_sift_down(const char *const *table, int32_t *s,
+				 int root, int n)
+{
+	int32_t tmp;
+	int child;
+
+	while ((child = 2 * root + 1) < n) {
+		if ((child + 1 < n)
+		    && (_fdt_match_cmp(table, s[child], s[child + 1]) < 0))
+			child++;
+		if (_fdt_match_cmp(table, s[root], s[child]) >= 0)
+			return;
+		tmp = s[root];
+		s[root] = s[child];
+		s[child] = tmp;
+		root = child;
+	}
+}
+
+static int _fdt_match_sort(const char *const *table, int tablelen,
+			   int32_t *s)
+{
+	int32_t tmp;
+	int i, n = 0;
+
+	for (i = 0; i < tablelen; i++)
+		if (table[i])
+			s[n++] = i;
+
+	for (i = n / 2 - 1; i >= 0; i--)
+		_fdt_match_sift_down(table, s, i, n);
+
+	for (i = n - 1; i > 0; i--) {
+		tmp = s[0];
+		s[0] = s[i];
+		s[i] = tmp;
+		_fdt_match_sift_down(table, s, 0, i);
+	}
+
+	return n;
+}
+
+static int _fdt_match_one(const void *fdt, void *ctx, int nodeoffset,
+			  int stroffset, int priority)
+{
+	struct _fdt_match_ctx *m = ctx;
+	const char *s = _fdt_offset_ptr(fdt, stroffset);
+	int lo = 0, hi = m->nsorted;
+
+	/* First table entry for the string, by bisection */
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (strcmp(m->table[m->sorted[mid]], s) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < m->nsorted; lo++) {
+		int i = m->sorted[lo];
+
+		if (strcmp(m->table[i], s) != 0)
+			break;
+
+		if (m->count < m->maxmatches) {
+			m->matches[m->count].nodeoffset = nodeoffset;
+			m->matches[m->count].entry = i;
+			m->matches[m->count].priority = priority;
+		}
+		if (m->count == INT32_MAX)
+			return -FDT_ERR_NOSPACE;
+		m->count++;
+	}
+
+	return 0;
+}
+
+int fdt_match_compatible_size(int tablelen)
+{
+	if ((tablelen < 0) || (tablelen > (INT32_MAX / sizeof(int32_t))))
+		return -FDT_ERR_NOSPACE;
+
+	return tablelen * sizeof(int32_t);
+}
+
+int fdt_match_compatible(const void *fdt, const char *const *table,
+			 int tablelen, void *ws, int wssize,
+			 struct fdt_compatible_match *matches,
+			 int maxmatches)
+{
+	struct _fdt_match_ctx m;
+	int size, err;
+
+	FDT_CHECK_HEADER(fdt);
+
+	size = fdt_match_compatible_size(tablelen);
+	if (size < 0)
+		return size;
+	if (wssize < size)
+		return -FDT_ERR_NOSPACE;
+
+	m.table = table;
+	m.sorted = ws;
+	m.nsorted = _fdt_match_sort(table, tablelen, ws);
+	m.matches = matches;
+	m.maxmatches = matches ? maxmatches : 0;
+	m.count = 0;
+
+	err = _fdt_compat_scan(fdt, _fdt_match_one, &m);
+	if (err)
+		return err;
+
+	return m.count;
+}
+
+/*
+ * Compatible index: one (string, node) pair per compatible string in
+ * the tree, sorted by string then node offset.  Strings are referred
+ * to by their offset in the structure block.
+ */
+static int _fdt_compat_count(const void *fdt, void *ctx, int nodeoffset,
+			     int stroffset, int priority)
+{
+	int *count = ctx;
+
+	if (*count == INT32_MAX)
+		return -FDT_ERR_NOSPACE;
+	(*count)++;
+	return 0;
+}
+
+int fdt_compat_index_size(const void *fdt)
+{
+	int count = 0, err;
+
+	FDT_CHECK_HEADER(fdt);
+
+	err = _fdt_compat_scan(fdt, _fdt_compat_count, &count);
+	if (err)
+		return err;
+
+	if (count > ((INT32_MAX - sizeof(struct fdt_index_header))
+		     / sizeof(struct fdt_compat_index_entry)))
+		return -FDT_ERR_NOSPACE;
+
+	return sizeof(struct fdt_index_header)
+		+ count * sizeof(struct fdt_compat_index_entry);
+}
+
+struct _fdt_compat_build_ctx {
+	struct fdt_compat_index_entry *entries;
+	int maxentries;
+	int count;
+};
+
+static int _fdt_compat_add(const void *fdt, void *ctx, int nodeoffset,
+			   int stroffset, int priority)
+{
+	struct _fdt_compat_build_ctx *b = ctx;
+
+	if (b->count >= b->maxentries)
+		return -FDT_ERR_NOSPACE;
+
+	b->entries[b->count].stroffset = stroffset;
+	b->entries[b->count].nodeoffset = nodeoffset;
+	b->count++;
+	return 0;
+}
+
+static int _fdt_compat_cmp(const void *fdt,
+			   const struct fdt_compat_index_entry *a,
+			   const struct fdt_compat_index_entry *b)
+{
+	int cmp = strcmp(_fdt_offset_ptr(fdt, a->stroffset),
+			 _fdt_offset_ptr(fdt, b->stroffset));
+
+	if (cmp)
+		return cmp;
+	return a->nodeoffset - b->nodeoffset;
+}
+
+static void _fdt_compat_sift_down(const void *fdt,
+				  struct fdt_compat_index_entry *e,
+				  int root, int n)
+{
+	struct fdt_compat_index_entry tmp;
+	int child;
+
+	while ((child = 2 * root + 1) < n) {
+		if ((child + 1 < n)
+		    && (_fdt_compat_cmp(fdt, &e[child], &e[child + 1]) < 0))
+			child++;
+		if (_fdt_compat_cmp(fdt, &e[root], &e[child]) >= 0)
+			return;
+		tmp = e[root];
+		e[root] = e[child];
+		e[child] = tmp;
+		root = child;
+	}
+}
+
+/* Heapsort, since we have no room to spare for anything fancier */
+static void _fdt_compat_sort(const void *fdt,
+			     struct fdt_compat_index_entry *e, int n)
+{
+	struct fdt_compat_index_entry tmp;
+	int i;
+
+	for (i = n / 2 - 1; i >= 0; i--)
+		_fdt_compat_sift_down(fdt, e, i, n);
+
+	for (i = n - 1; i > 0; i--) {
+		tmp = e[0];
+		e[0] = e[i];
+		e[i] = tmp;
+		_fdt_compat_sift_down(fdt, e, 0, i);
+	}
+}
+
+int fdt_compat_index_build(const void *fdt, void *cidx, int cidxsize)
+{
+	struct fdt_index_header *hdr = cidx;
+	struct _fdt_compat_build_ctx b;
+	int err;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (cidxsize < (int)sizeof(*hdr))
+		return -FDT_ERR_NOSPACE;
+
+	hdr->magic = 0;
+
+	b.entries = (struct fdt_compat_index_entry *)(hdr + 1);
+	b.maxentries = (cidxsize - sizeof(*hdr)) / sizeof(*b.entries);
+	b.count = 0;
+
+	err = _fdt_compat_scan(fdt, _fdt_compat_add, &b);
+	if (err)
+		return err;
+
+	_fdt_compat_sort(fdt, b.entries, b.count);
+
+	hdr->size_dt_struct = fdt_size_dt_struct(fdt);
+	hdr->num_nodes = b.count;
+	hdr->reserved = 0;
+	hdr->magic = FDT_COMPAT_INDEX_MAGIC;
+
+	return 0;
+}
+
+int fdt_compat_index_node_offset(const void *fdt, const void *cidx,
+				 int startoffset, const char *compatible)
+{
+	const struct fdt_index_header *hdr = cidx;
+	const struct fdt_compat_index_entry *e;
+	int lo, hi;
+
+	if (!hdr || (hdr->magic != FDT_COMPAT_INDEX_MAGIC)
+	    || (hdr->size_dt_struct != fdt_size_dt_struct(fdt)))
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	FDT_CHECK_HEADER(fdt);
+
+	e = (const struct fdt_compat_index_entry *)(hdr + 1);
+
+	/* Find the first entry for compatible after startoffset */
+	lo = 0;
+	hi = hdr->num_nodes;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		int cmp = strcmp(_fdt_offset_ptr(fdt, e[mid].stroffset),
+				 compatible);
+
+		if ((cmp < 0) || ((cmp == 0) && (e[mid].nodeoffset
+						 <= startoffset)))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if ((lo == hdr->num_nodes)
+	    || (strcmp(_fdt_offset_ptr(fdt, e[lo].stroffset), compatible) != 0))
+		return -FDT_ERR_NOTFOUND;
+
+	return e[lo].nodeoffset;
+}
@@ -5,9 +5,137 @@
 
 #include "libfdt_internal.h"
 
+/*
+ * Changes to the overlay's property values.  When the overlay is to be
+ * left untouched, they are recorded in the overlay index instead,
+ * sorted by property, and made to the copies of the values written to
+ * the merged tree.
+ */
+static struct fdt_overlay_patch *overlay_patches(void *ovi)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+
+	return (struct fdt_overlay_patch *)((char *)ovi + hdr->patches);
+}
+
+static int overlay_prop_offset(const void *fdto, const struct fdt_property *p)
+{
+	return (const char *)p - ((const char *)fdto + fdt_off_dt_struct(fdto));
+}
+
+/**
+ * overlay_patch - Stores a phandle in an overlay property's value
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @p: Property of the overlay
+ * @poffset: Offset of the phandle within the value, which the caller
+ *           has checked lies within it
+ * @phandle: Phandle to store
+ *
+ * overlay_patch() stores the phandle in the overlay, unless the
+ * overlay index is recording the changes to make to its values.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_patch(const void *fdto, void *ovi,
+			 const struct fdt_property *p, int poffset,
+			 uint32_t phandle)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_patch *patch;
+	fdt32_t val;
+
+	if (!hdr || (hdr->num_patches < 0)) {
+		/* phandles to fixup can be unaligned */
+		val = cpu_to_fdt32(phandle);
+		memcpy((char *)(uintptr_t)p->data + poffset, &val, sizeof(val));
+		return 0;
+	}
+
+	if (hdr->num_patches >= hdr->max_patches)
+		return -FDT_ERR_INTERNAL;
+
+	patch = &overlay_patches(ovi)[hdr->num_patches++];
+	patch->prop = overlay_prop_offset(fdto, p);
+	patch->offset = poffset;
+	patch->phandle = phandle;
+	return 0;
+}
+
+static void overlay_patch_sift_down(struct fdt_overlay_patch *s,
+				    int root, int n)
+{
+	struct fdt_overlay_patch tmp;
+	int child;
+
+	while ((child = 2 * root + 1) < n) {
+		if ((child + 1 < n) && (s[child].prop < s[child + 1].prop))
+			child++;
+		if (s[root].prop >= s[child].prop)
+			return;
+		tmp = s[root];
+		s[root] = s[child];
+		s[child] = tmp;
+		root = child;
+	}
+}
+
+static void overlay_patch_sort(struct fdt_overlay_patch *s, int n)
+{
+	struct fdt_overlay_patch tmp;
+	int i;
+
+	for (i = n / 2 - 1; i >= 0; i--)
+		overlay_patch_sift_down(s, i, n);
+
+	for (i = n - 1; i > 0; i--) {
+		tmp = s[0];
+		s[0] = s[i];
+		s[i] = tmp;
+		overlay_patch_sift_down(s, 0, i);
+	}
+}
+
+/**
+ * overlay_patch_value - Makes the recorded changes to a copied value
+ * @ovi: Overlay index, or NULL
+ * @prop: Structure offset of the overlay property the value is from
+ * @val: Copy of the property's value
+ */
+static void overlay_patch_value(const void *ovi, int prop, void *val)
+{
+	const struct fdt_overlay_index_header *hdr = ovi;
+	const struct fdt_overlay_patch *patches;
+	int lo = 0, hi;
+	fdt32_t tmp;
+
+	if (!hdr || (hdr->num_patches <= 0))
+		return;
+
+	patches = (const struct fdt_overlay_patch *)
+		((const char *)ovi + hdr->patches);
+	hi = hdr->num_patches;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (patches[mid].prop < prop)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; (lo < hdr->num_patches) && (patches[lo].prop == prop); lo++) {
+		tmp = cpu_to_fdt32(patches[lo].phandle);
+		memcpy((char *)val + patches[lo].offset, &tmp, sizeof(tmp));
+	}
+}
+
 /**
  * overlay_get_target_phandle - retrieves the target phandle of a fragment
  * @fdto: pointer to the device tree overlay blob
+ * @ovi: Overlay index, or NULL
  * @fragment: node offset of the fragment in the overlay
  *
  * overlay_get_target_phandle() retrieves the target phandle of an
@@ -19,25 +147,31 @@
  *      0, if the phandle was not found
  *	-1, if the phandle was malformed
  */
-static uint32_t overlay_get_target_phandle(const void *fdto, int fragment)
+static uint32_t overlay_get_target_phandle(const void *fdto, const void *ovi,
+					   int fragment)
 {
-	const fdt32_t *val;
+	const struct fdt_property *prop;
+	fdt32_t val;
 	int len;
 
-	val = fdt_getprop(fdto, fragment, "target", &len);
-	if (!val)
+	prop = fdt_get_property(fdto, fragment, "target", &len);
+	if (!prop)
 		return 0;
 
-	if ((len != sizeof(*val)) || (fdt32_to_cpu(*val) == (uint32_t)-1))
+	if (len != sizeof(val))
 		return (uint32_t)-1;
 
-	return fdt32_to_cpu(*val);
+	memcpy(&val, prop->data, sizeof(val));
+	overlay_patch_value(ovi, overlay_prop_offset(fdto, prop), &val);
+
+	return fdt32_to_cpu(val);
 }
 
 /**
  * overlay_get_target - retrieves the offset of a fragment's target
  * @fdt: Base device tree blob
  * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
  * @fragment: node offset of the fragment in the overlay
  * @pathp: pointer which receives the path of the target (or NULL)
  *
@@ -50,14 +184,15 @@ static uint32_t overlay_get_target_phandle(const void *fdto, int fragment)
  *      Negative error code on error
  */
 static int overlay_get_target(const void *fdt, const void *fdto,
-			      int fragment, char const **pathp)
+			      const void *ovi, int fragment,
+			      char const **pathp)
 {
 	uint32_t phandle;
 	const char *path = NULL;
 	int path_len = 0, ret;
 
 	/* Try first to do a phandle based lookup */
-	phandle = overlay_get_target_phandle(fdto, fragment);
+	phandle = overlay_get_target_phandle(fdto, ovi, fragment);
 	if (phandle == (uint32_t)-1)
 		return -FDT_ERR_BADPHANDLE;
 
@@ -95,9 +230,10 @@ static int overlay_get_target(const void *fdt, const void *fdto,
 
 /**
  * overlay_phandle_add_offset - Increases a phandle by an offset
- * @fdt: Base device tree blob
- * @node: Device tree overlay blob
- * @name: Name of the property to modify (phandle or linux,phandle)
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @p: phandle property
+ * @len: length of its value
  * @delta: offset to apply
  *
  * overlay_phandle_add_offset() increments a node phandle by a given
@@ -107,21 +243,18 @@ static int overlay_get_target(const void *fdt, const void *fdto,
  *      0 on success.
  *      Negative error code on error
  */
-static int overlay_phandle_add_offset(void *fdt, int node,
-				      const char *name, uint32_t delta)
+static int overlay_phandle_add_offset(const void *fdto, void *ovi,
+				      const struct fdt_property *p, int len,
+				      uint32_t delta)
 {
-	const fdt32_t *val;
 	uint32_t adj_val;
-	int len;
-
-	val = fdt_getprop(fdt, node, name, &len);
-	if (!val)
-		return len;
+	fdt32_t tmp;
 
-	if (len != sizeof(*val))
+	if (len != sizeof(tmp))
 		return -FDT_ERR_BADPHANDLE;
 
-	adj_val = fdt32_to_cpu(*val);
+	memcpy(&tmp, p->data, sizeof(tmp));
+	adj_val = fdt32_to_cpu(tmp);
 	if ((adj_val + delta) < adj_val)
 		return -FDT_ERR_NOPHANDLES;
 
@@ -129,40 +262,58 @@ static int overlay_phandle_add_offset(void *fdt, int node,
 	if (adj_val == (uint32_t)-1)
 		return -FDT_ERR_NOPHANDLES;
 
-	return fdt_setprop_inplace_u32(fdt, node, name, adj_val);
+	return overlay_patch(fdto, ovi, p, 0, adj_val);
 }
 
 /**
- * overlay_adjust_node_phandles - Offsets the phandles of a node
+ * overlay_update_local_property_references - Adjust a property's references
  * @fdto: Device tree overlay blob
- * @node: Offset of the node we want to adjust
+ * @ovi: Overlay index, or NULL
+ * @p: property holding the references
+ * @len: length of its value
+ * @fixup_val: pointer to the matching local fixups property
+ * @fixup_len: length of the local fixups property
  * @delta: Offset to shift the phandles of
  *
- * overlay_adjust_node_phandles() adds a constant to all the phandles
- * of a given node. This is mainly use as part of the overlay
- * application process, when we want to update all the overlay
- * phandles to not conflict with the overlays of the base device tree.
+ * overlay_update_local_property_references() adds a constant delta
+ * to each phandle stored in a property, at the offsets listed in the
+ * matching __local_fixups__ property.
  *
  * returns:
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_adjust_node_phandles(void *fdto, int node,
-					uint32_t delta)
+static int overlay_update_local_property_references(const void *fdto,
+						    void *ovi,
+						    const struct fdt_property *p,
+						    int len,
+						    const fdt32_t *fixup_val,
+						    int fixup_len,
+						    uint32_t delta)
 {
-	int child;
-	int ret;
+	int i, ret;
 
-	ret = overlay_phandle_add_offset(fdto, node, "phandle", delta);
-	if (ret && ret != -FDT_ERR_NOTFOUND)
-		return ret;
+	if (fixup_len % sizeof(uint32_t))
+		return -FDT_ERR_BADOVERLAY;
 
-	ret = overlay_phandle_add_offset(fdto, node, "linux,phandle", delta);
-	if (ret && ret != -FDT_ERR_NOTFOUND)
-		return ret;
+	for (i = 0; i < (fixup_len / sizeof(uint32_t)); i++) {
+		fdt32_t adj_val;
+		uint32_t poffset;
 
-	fdt_for_each_subnode(child, fdto, node) {
-		ret = overlay_adjust_node_phandles(fdto, child, delta);
+		poffset = fdt32_to_cpu(fixup_val[i]);
+		if ((poffset > len) || ((len - poffset) < sizeof(adj_val)))
+			return -FDT_ERR_BADOVERLAY;
+
+		/*
+		 * phandles to fixup can be unaligned.
+		 *
+		 * Use a memcpy for the architectures that do
+		 * not support unaligned accesses.
+		 */
+		memcpy(&adj_val, p->data + poffset, sizeof(adj_val));
+
+		ret = overlay_patch(fdto, ovi, p, poffset,
+				    fdt32_to_cpu(adj_val) + delta);
 		if (ret)
 			return ret;
 	}
@@ -170,38 +321,48 @@ static int overlay_adjust_node_phandles(void *fdto, int node,
 	return 0;
 }
 
-/**
- * overlay_adjust_local_phandles - Adjust the phandles of a whole overlay
- * @fdto: Device tree overlay blob
- * @delta: Offset to shift the phandles of
- *
- * overlay_adjust_local_phandles() adds a constant to all the
- * phandles of an overlay. This is mainly use as part of the overlay
- * application process, when we want to update all the overlay
- * phandles to not conflict with the overlays of the base device tree.
- *
- * returns:
- *      0 on success
- *      Negative error code on failure
- */
-static int overlay_adjust_local_phandles(void *fdto, uint32_t delta)
+static int overlay_property_name_eq(const void *fdto,
+				    const struct fdt_property *a,
+				    const struct fdt_property *b)
 {
-	/*
-	 * Start adjusting the phandles from the overlay root
-	 */
-	return overlay_adjust_node_phandles(fdto, 0, delta);
+	if (a->nameoff == b->nameoff)
+		return 1;
+
+	return !strcmp(fdt_string(fdto, fdt32_to_cpu(a->nameoff)),
+		       fdt_string(fdto, fdt32_to_cpu(b->nameoff)));
+}
+
+static int overlay_node_name_eq(const void *fdto, int a, int b)
+{
+	const char *aname, *bname;
+	int alen, blen;
+
+	aname = fdt_get_name(fdto, a, &alen);
+	bname = fdt_get_name(fdto, b, &blen);
+
+	return aname && bname && (alen == blen) && !memcmp(aname, bname, alen);
 }
 
 /**
- * overlay_update_local_node_references - Adjust the overlay references
+ * overlay_adjust_node - Offsets the phandles of a subtree and the
+ *                       references to them
  * @fdto: Device tree overlay blob
- * @tree_node: Node offset of the node to operate on
- * @fixup_node: Node offset of the matching local fixups node
+ * @ovi: Overlay index, or NULL
+ * @node: Offset of the node we want to adjust
+ * @fixup_node: Node offset of the matching local fixups node, or -1
  * @delta: Offset to shift the phandles of
+ * @phandles: Whether to shift the phandles of the subtree, or only
+ *            the references listed under @fixup_node
  *
- * overlay_update_local_nodes_references() update the phandles
- * pointing to a node within the device tree overlay by adding a
- * constant delta.
+ * overlay_adjust_node() adds a constant to all the phandles of a
+ * subtree, and to all the phandle references listed in the matching
+ * __local_fixups__ subtree, in a single walk of both.
+ *
+ * dtc lays the __local_fixups__ properties and subnodes out in the
+ * same order as the properties and subnodes they refer to, so the
+ * next unused fixup is expected to match the property or subnode
+ * being walked.  Fixups out of that order are looked up by name
+ * afterwards.
  *
  * This is mainly used as part of a device tree application process,
  * where you want the device tree overlays phandles to not conflict
@@ -211,86 +372,132 @@ static int overlay_adjust_local_phandles(void *fdto, uint32_t delta)
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_update_local_node_references(void *fdto,
-						int tree_node,
-						int fixup_node,
-						uint32_t delta)
+static int overlay_adjust_node(const void *fdto, void *ovi, int node,
+			       int fixup_node, uint32_t delta, int phandles)
 {
-	int fixup_prop;
-	int fixup_child;
-	int ret;
+	const struct fdt_property *fixup;
+	const char *name;
+	int prop, fixup_prop, child, fixup_child;
+	int len, fixup_len, ret;
+
+	fixup_prop = -FDT_ERR_NOTFOUND;
+	if (fixup_node >= 0) {
+		fixup_prop = fdt_first_property_offset(fdto, fixup_node);
+		if ((fixup_prop < 0) && (fixup_prop != -FDT_ERR_NOTFOUND))
+			return fixup_prop;
+	}
+
+	fdt_for_each_property_offset(prop, fdto, node) {
+		const struct fdt_property *p;
+
+		p = fdt_get_property_by_offset(fdto, prop, &len);
+		if (!p)
+			return len;
+
+		if (phandles) {
+			name = fdt_string(fdto, fdt32_to_cpu(p->nameoff));
+			if (!name)
+				return -FDT_ERR_BADSTRUCTURE;
+
+			if (!strcmp(name, "phandle")
+			    || !strcmp(name, "linux,phandle")) {
+				ret = overlay_phandle_add_offset(fdto, ovi, p,
+								 len, delta);
+				if (ret)
+					return ret;
+			}
+		}
+
+		if (fixup_prop < 0)
+			continue;
 
-	fdt_for_each_property_offset(fixup_prop, fdto, fixup_node) {
+		fixup = fdt_get_property_by_offset(fdto, fixup_prop,
+						   &fixup_len);
+		if (!fixup)
+			return fixup_len;
+
+		if (!overlay_property_name_eq(fdto, p, fixup))
+			continue;
+
+		ret = overlay_update_local_property_references(fdto, ovi,
+				p, len, (const fdt32_t *)fixup->data,
+				fixup_len, delta);
+		if (ret)
+			return ret;
+
+		fixup_prop = fdt_next_property_offset(fdto, fixup_prop);
+		if ((fixup_prop < 0) && (fixup_prop != -FDT_ERR_NOTFOUND))
+			return fixup_prop;
+	}
+	if (prop != -FDT_ERR_NOTFOUND)
+		return prop;
+
+	/* Fixups for properties we've walked past */
+	for (; fixup_prop >= 0;
+	     fixup_prop = fdt_next_property_offset(fdto, fixup_prop)) {
+		const struct fdt_property *p;
 		const fdt32_t *fixup_val;
-		const char *tree_val;
-		const char *name;
-		int fixup_len;
-		int tree_len;
-		int i;
 
 		fixup_val = fdt_getprop_by_offset(fdto, fixup_prop,
 						  &name, &fixup_len);
 		if (!fixup_val)
 			return fixup_len;
 
-		if (fixup_len % sizeof(uint32_t))
-			return -FDT_ERR_BADOVERLAY;
-
-		tree_val = fdt_getprop(fdto, tree_node, name, &tree_len);
-		if (!tree_val) {
-			if (tree_len == -FDT_ERR_NOTFOUND)
+		p = fdt_get_property(fdto, node, name, &len);
+		if (!p) {
+			if (len == -FDT_ERR_NOTFOUND)
 				return -FDT_ERR_BADOVERLAY;
 
-			return tree_len;
+			return len;
 		}
 
-		for (i = 0; i < (fixup_len / sizeof(uint32_t)); i++) {
-			fdt32_t adj_val;
-			uint32_t poffset;
-
-			poffset = fdt32_to_cpu(fixup_val[i]);
-
-			/*
-			 * phandles to fixup can be unaligned.
-			 *
-			 * Use a memcpy for the architectures that do
-			 * not support unaligned accesses.
-			 */
-			memcpy(&adj_val, tree_val + poffset, sizeof(adj_val));
-
-			adj_val = cpu_to_fdt32(fdt32_to_cpu(adj_val) + delta);
-
-			ret = fdt_setprop_inplace_namelen_partial(fdto,
-								  tree_node,
-								  name,
-								  strlen(name),
-								  poffset,
-								  &adj_val,
-								  sizeof(adj_val));
-			if (ret == -FDT_ERR_NOSPACE)
-				return -FDT_ERR_BADOVERLAY;
+		ret = overlay_update_local_property_references(fdto, ovi, p,
+							       len, fixup_val,
+							       fixup_len,
+							       delta);
+		if (ret)
+			return ret;
+	}
+	if (fixup_prop != -FDT_ERR_NOTFOUND)
+		return fixup_prop;
 
-			if (ret)
-				return ret;
+	fixup_child = -FDT_ERR_NOTFOUND;
+	if (fixup_node >= 0)
+		fixup_child = fdt_first_subnode(fdto, fixup_node);
+
+	fdt_for_each_subnode(child, fdto, node) {
+		int match = -1;
+
+		if ((fixup_child >= 0)
+		    && overlay_node_name_eq(fdto, child, fixup_child)) {
+			match = fixup_child;
+			fixup_child = fdt_next_subnode(fdto, fixup_child);
 		}
+
+		if (!phandles && (match < 0))
+			continue;
+
+		ret = overlay_adjust_node(fdto, ovi, child, match, delta,
+					  phandles);
+		if (ret)
+			return ret;
 	}
 
-	fdt_for_each_subnode(fixup_child, fdto, fixup_node) {
-		const char *fixup_child_name = fdt_get_name(fdto, fixup_child,
-							    NULL);
-		int tree_child;
+	/* Fixups for subnodes we've walked past */
+	for (; fixup_child >= 0;
+	     fixup_child = fdt_next_subnode(fdto, fixup_child)) {
+		name = fdt_get_name(fdto, fixup_child, &len);
+		if (!name)
+			return len;
 
-		tree_child = fdt_subnode_offset(fdto, tree_node,
-						fixup_child_name);
-		if (tree_child == -FDT_ERR_NOTFOUND)
+		child = fdt_subnode_offset_namelen(fdto, node, name, len);
+		if (child == -FDT_ERR_NOTFOUND)
 			return -FDT_ERR_BADOVERLAY;
-		if (tree_child < 0)
-			return tree_child;
+		if (child < 0)
+			return child;
 
-		ret = overlay_update_local_node_references(fdto,
-							   tree_child,
-							   fixup_child,
-							   delta);
+		ret = overlay_adjust_node(fdto, ovi, child, fixup_child,
+					  delta, 0);
 		if (ret)
 			return ret;
 	}
@@ -299,13 +506,14 @@ static int overlay_update_local_node_references(void *fdto,
 }
 
 /**
- * overlay_update_local_references - Adjust the overlay references
+ * overlay_adjust_local_phandles - Adjust the phandles of a whole overlay
  * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
  * @delta: Offset to shift the phandles of
  *
- * overlay_update_local_references() update all the phandles pointing
- * to a node within the device tree overlay by adding a constant
- * delta to not conflict with the base overlay.
+ * overlay_adjust_local_phandles() adds a constant to all the
+ * phandles of an overlay, and updates all the phandles pointing to a
+ * node within the overlay to match.
  *
  * This is mainly used as part of a device tree application process,
  * where you want the device tree overlays phandles to not conflict
@@ -315,526 +523,1956 @@ static int overlay_update_local_node_references(void *fdto,
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_update_local_references(void *fdto, uint32_t delta)
+static int overlay_adjust_local_phandles(const void *fdto, void *ovi,
+					 uint32_t delta)
 {
 	int fixups;
 
-	fixups = fdt_path_offset(fdto, "/__local_fixups__");
-	if (fixups < 0) {
-		/* There's no local phandles to adjust, bail out */
-		if (fixups == -FDT_ERR_NOTFOUND)
-			return 0;
-
+	fixups = fdt_subnode_offset(fdto, 0, "__local_fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		fixups = -1; /* There's no local phandles to adjust */
+	else if (fixups < 0)
 		return fixups;
-	}
 
 	/*
-	 * Update our local references from the root of the tree
+	 * Start adjusting the phandles from the overlay root
 	 */
-	return overlay_update_local_node_references(fdto, 0, fixups,
-						    delta);
+	return overlay_adjust_node(fdto, ovi, 0, fixups, delta, 1);
+}
+
+/*
+ * The overlay index holds the base tree's symbols sorted by label, so
+ * each label used by the overlay's fixups can be found by bisection
+ * rather than by a scan of /__symbols__.
+ */
+static const void *overlay_fdt_index(const void *ovi)
+{
+	const struct fdt_overlay_index_header *hdr = ovi;
+
+	return hdr ? (const char *)ovi + hdr->fdt_index : NULL;
+}
+
+static const void *overlay_fdto_index(const void *ovi)
+{
+	const struct fdt_overlay_index_header *hdr = ovi;
+
+	return hdr ? (const char *)ovi + hdr->fdto_index : NULL;
+}
+
+static struct fdt_overlay_symbol *overlay_symbols(void *ovi)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+
+	return (struct fdt_overlay_symbol *)((char *)ovi + hdr->symbols);
+}
+
+static int overlay_symbol_cmp(const void *fdt,
+			      const struct fdt_overlay_symbol *a,
+			      const struct fdt_overlay_symbol *b)
+{
+	return strcmp(fdt_string(fdt, a->nameoff),
+		      fdt_string(fdt, b->nameoff));
+}
+
+static void overlay_symbol_sift_down(const void *fdt,
+				     struct fdt_overlay_symbol *s,
+				     int root, int n)
+{
+	struct fdt_overlay_symbol tmp;
+	int child;
+
+	while ((child = 2 * root + 1) < n) {
+		if ((child + 1 < n)
+		    && (overlay_symbol_cmp(fdt, &s[child], &s[child + 1]) < 0))
+			child++;
+		if (overlay_symbol_cmp(fdt, &s[root], &s[child]) >= 0)
+			return;
+		tmp = s[root];
+		s[root] = s[child];
+		s[child] = tmp;
+		root = child;
+	}
+}
+
+static void overlay_symbol_sort(const void *fdt,
+				struct fdt_overlay_symbol *s, int n)
+{
+	struct fdt_overlay_symbol tmp;
+	int i;
+
+	for (i = n / 2 - 1; i >= 0; i--)
+		overlay_symbol_sift_down(fdt, s, i, n);
+
+	for (i = n - 1; i > 0; i--) {
+		tmp = s[0];
+		s[0] = s[i];
+		s[i] = tmp;
+		overlay_symbol_sift_down(fdt, s, 0, i);
+	}
+}
+
+static struct fdt_overlay_symbol *overlay_find_symbol(const void *fdt,
+						      void *ovi,
+						      const char *label)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_symbol *syms = overlay_symbols(ovi);
+	int lo = 0, hi = hdr->num_symbols;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		int cmp = strcmp(fdt_string(fdt, syms[mid].nameoff), label);
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else if (cmp > 0)
+			hi = mid;
+		else
+			return &syms[mid];
+	}
+
+	return NULL;
 }
 
 /**
- * overlay_fixup_one_phandle - Set an overlay phandle to the base one
+ * overlay_count_symbols - Counts the symbols of a base device tree
  * @fdt: Base Device Tree blob
- * @fdto: Device tree overlay blob
- * @symbols_off: Node offset of the symbols node in the base device tree
- * @path: Path to a node holding a phandle in the overlay
- * @path_len: number of path characters to consider
- * @name: Name of the property holding the phandle reference in the overlay
- * @name_len: number of name characters to consider
- * @poffset: Offset within the overlay property where the phandle is stored
- * @label: Label of the node referenced by the phandle
- *
- * overlay_fixup_one_phandle() resolves an overlay phandle pointing to
- * a node in the base device tree.
- *
- * This is part of the device tree overlay application process, when
- * you want all the phandles in the overlay to point to the actual
- * base dt nodes.
  *
  * returns:
- *      0 on success
+ *      the number of properties of the /__symbols__ node, 0 if it
+ *      doesn't exist
  *      Negative error code on failure
  */
-static int overlay_fixup_one_phandle(void *fdt, void *fdto,
-				     int symbols_off,
-				     const char *path, uint32_t path_len,
-				     const char *name, uint32_t name_len,
-				     int poffset, const char *label)
+static int overlay_count_symbols(const void *fdt)
 {
-	const char *symbol_path;
-	uint32_t phandle;
-	fdt32_t phandle_prop;
-	int symbol_off, fixup_off;
-	int prop_len;
+	int symbols_off, prop, count = 0;
 
+	symbols_off = fdt_subnode_offset(fdt, 0, "__symbols__");
+	if (symbols_off == -FDT_ERR_NOTFOUND)
+		return 0;
 	if (symbols_off < 0)
 		return symbols_off;
 
-	symbol_path = fdt_getprop(fdt, symbols_off, label,
-				  &prop_len);
-	if (!symbol_path)
-		return prop_len;
+	fdt_for_each_property_offset(prop, fdt, symbols_off) {
+		if (count == INT32_MAX)
+			return -FDT_ERR_NOSPACE;
+		count++;
+	}
+	if (prop != -FDT_ERR_NOTFOUND)
+		return prop;
 
-	symbol_off = fdt_path_offset(fdt, symbol_path);
-	if (symbol_off < 0)
-		return symbol_off;
+	return count;
+}
 
-	phandle = fdt_get_phandle(fdt, symbol_off);
-	if (!phandle)
-		return -FDT_ERR_NOTFOUND;
+static int overlay_count_fragments(const void *fdto)
+{
+	int fragment, overlay, count = 0;
 
-	fixup_off = fdt_path_offset_namelen(fdto, path, path_len);
-	if (fixup_off == -FDT_ERR_NOTFOUND)
-		return -FDT_ERR_BADOVERLAY;
-	if (fixup_off < 0)
-		return fixup_off;
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+		count++;
+	}
 
-	phandle_prop = cpu_to_fdt32(phandle);
-	return fdt_setprop_inplace_namelen_partial(fdto, fixup_off,
-						   name, name_len, poffset,
-						   &phandle_prop,
-						   sizeof(phandle_prop));
-};
+	return count;
+}
+
+/* Adds n to a size bound, failing if the sum would not fit in an int */
+static int overlay_add_bound(int *total, int n)
+{
+	if (n > (INT32_MAX - *total))
+		return -FDT_ERR_NOSPACE;
+
+	*total += n;
+	return 0;
+}
 
 /**
- * overlay_fixup_phandle - Set an overlay phandle to the base one
- * @fdt: Base Device Tree blob
+ * overlay_count_subtree_patches - Bounds the changes to a subtree's values
  * @fdto: Device tree overlay blob
- * @symbols_off: Node offset of the symbols node in the base device tree
- * @property: Property offset in the overlay holding the list of fixups
- *
- * overlay_fixup_phandle() resolves all the overlay phandles pointed
- * to in a __fixups__ property, and updates them to match the phandles
- * in use in the base device tree.
- *
- * This is part of the device tree overlay application process, when
- * you want all the phandles in the overlay to point to the actual
- * base dt nodes.
+ * @node: Node offset of the root of the subtree
+ * @phandles: Whether to count the phandle properties of the subtree,
+ *            or the references its (local fixups) properties list
+ * @count: running total, which receives the bound
  *
  * returns:
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_fixup_phandle(void *fdt, void *fdto, int symbols_off,
-				 int property)
+static int overlay_count_subtree_patches(const void *fdto, int node,
+					 int phandles, int *count)
 {
-	const char *value;
-	const char *label;
-	int len;
+	const char *name;
+	int prop, depth = 0, len, ret;
 
-	value = fdt_getprop_by_offset(fdto, property,
-				      &label, &len);
-	if (!value) {
-		if (len == -FDT_ERR_NOTFOUND)
-			return -FDT_ERR_INTERNAL;
+	do {
+		fdt_for_each_property_offset(prop, fdto, node) {
+			if (!fdt_getprop_by_offset(fdto, prop, &name, &len))
+				return len;
 
-		return len;
-	}
+			if (phandles)
+				len = !strcmp(name, "phandle")
+					|| !strcmp(name, "linux,phandle");
+			else
+				len /= sizeof(fdt32_t);
 
-	do {
-		const char *path, *name, *fixup_end;
-		const char *fixup_str = value;
-		uint32_t path_len, name_len;
-		uint32_t fixup_len;
-		char *sep, *endptr;
-		int poffset, ret;
+			ret = overlay_add_bound(count, len);
+			if (ret)
+				return ret;
+		}
+		if (prop != -FDT_ERR_NOTFOUND)
+			return prop;
 
-		fixup_end = memchr(value, '\0', len);
-		if (!fixup_end)
-			return -FDT_ERR_BADOVERLAY;
-		fixup_len = fixup_end - fixup_str;
+		node = fdt_next_node(fdto, node, &depth);
+	} while ((node >= 0) && (depth > 0));
 
-		len -= fixup_len + 1;
-		value += fixup_len + 1;
-
-		path = fixup_str;
-		sep = memchr(fixup_str, ':', fixup_len);
-		if (!sep || *sep != ':')
-			return -FDT_ERR_BADOVERLAY;
-
-		path_len = sep - path;
-		if (path_len == (fixup_len - 1))
-			return -FDT_ERR_BADOVERLAY;
-
-		fixup_len -= path_len + 1;
-		name = sep + 1;
-		sep = memchr(name, ':', fixup_len);
-		if (!sep || *sep != ':')
-			return -FDT_ERR_BADOVERLAY;
-
-		name_len = sep - name;
-		if (!name_len)
-			return -FDT_ERR_BADOVERLAY;
-
-		poffset = strtoul(sep + 1, &endptr, 10);
-		if ((*endptr != '\0') || (endptr <= (sep + 1)))
-			return -FDT_ERR_BADOVERLAY;
-
-		ret = overlay_fixup_one_phandle(fdt, fdto, symbols_off,
-						path, path_len, name, name_len,
-						poffset, label);
-		if (ret)
-			return ret;
-	} while (len > 0);
+	if ((node < 0) && (node != -FDT_ERR_NOTFOUND))
+		return node;
 
 	return 0;
 }
 
 /**
- * overlay_fixup_phandles - Resolve the overlay phandles to the base
- *                          device tree
- * @fdt: Base Device Tree blob
+ * overlay_count_patches - Bounds the changes to an overlay's values
  * @fdto: Device tree overlay blob
  *
- * overlay_fixup_phandles() resolves all the overlay phandles pointing
- * to nodes in the base device tree.
- *
- * This is one of the steps of the device tree overlay application
- * process, when you want all the phandles in the overlay to point to
- * the actual base dt nodes.
- *
  * returns:
- *      0 on success
+ *      the number of phandle properties of the overlay, plus the
+ *      number of references listed by its __local_fixups__ and
+ *      __fixups__ nodes
  *      Negative error code on failure
  */
-static int overlay_fixup_phandles(void *fdt, void *fdto)
+static int overlay_count_patches(const void *fdto)
 {
-	int fixups_off, symbols_off;
-	int property;
+	const char *val;
+	int node, prop, len, i, count = 0, ret;
 
-	/* We can have overlays without any fixups */
-	fixups_off = fdt_path_offset(fdto, "/__fixups__");
-	if (fixups_off == -FDT_ERR_NOTFOUND)
-		return 0; /* nothing to do */
-	if (fixups_off < 0)
-		return fixups_off;
+	ret = overlay_count_subtree_patches(fdto, 0, 1, &count);
+	if (ret)
+		return ret;
 
-	/* And base DTs without symbols */
-	symbols_off = fdt_path_offset(fdt, "/__symbols__");
-	if ((symbols_off < 0 && (symbols_off != -FDT_ERR_NOTFOUND)))
-		return symbols_off;
+	node = fdt_subnode_offset(fdto, 0, "__local_fixups__");
+	if (node >= 0)
+		ret = overlay_count_subtree_patches(fdto, node, 0, &count);
+	else if (node != -FDT_ERR_NOTFOUND)
+		ret = node;
+	if (ret)
+		return ret;
 
-	fdt_for_each_property_offset(property, fdto, fixups_off) {
-		int ret;
+	node = fdt_subnode_offset(fdto, 0, "__fixups__");
+	if (node == -FDT_ERR_NOTFOUND)
+		return count;
+	if (node < 0)
+		return node;
 
-		ret = overlay_fixup_phandle(fdt, fdto, symbols_off, property);
-		if (ret)
-			return ret;
+	/* One reference per string */
+	fdt_for_each_property_offset(prop, fdto, node) {
+		val = fdt_getprop_by_offset(fdto, prop, NULL, &len);
+		if (!val)
+			return len;
+
+		for (i = 0; i < len; i++) {
+			if (val[i])
+				continue;
+
+			ret = overlay_add_bound(&count, 1);
+			if (ret)
+				return ret;
+		}
 	}
+	if (prop != -FDT_ERR_NOTFOUND)
+		return prop;
 
-	return 0;
+	return count;
+}
+
+static int overlay_max_depth(const void *fdt)
+{
+	int offset = 0, depth = 0, max = 0;
+
+	do {
+		if (depth > max)
+			max = depth;
+		offset = fdt_next_node(fdt, offset, &depth);
+	} while ((offset >= 0) && (depth >= 0));
+
+	if ((offset < 0) && (offset != -FDT_ERR_NOTFOUND))
+		return offset;
+
+	return max;
 }
 
 /**
- * overlay_apply_node - Merges a node into the base device tree
- * @fdt: Base Device Tree blob
- * @target: Node offset in the base device tree to apply the fragment to
- * @fdto: Device tree overlay blob
- * @node: Node offset in the overlay holding the changes to merge
- *
- * overlay_apply_node() merges a node into a target base device tree
- * node pointed.
- *
- * This is part of the final step in the device tree overlay
- * application process, when all the phandles have been adjusted and
- * resolved and you just have to merge overlay into the base device
- * tree.
+ * overlay_max_path_len - Finds the length of the longest path in a subtree
+ * @fdt: Device tree blob
+ * @node: Node offset of the root of the subtree
+ * @len: length of the path of @node
  *
  * returns:
- *      0 on success
+ *      the length of the longest path of a node in the subtree
  *      Negative error code on failure
  */
-static int overlay_apply_node(void *fdt, int target,
-			      void *fdto, int node)
+static int overlay_max_path_len(const void *fdt, int node, int len)
 {
-	int property;
-	int subnode;
-
-	fdt_for_each_property_offset(property, fdto, node) {
-		const char *name;
-		const void *prop;
-		int prop_len;
-		int ret;
+	int child, namelen, max = len, ret;
 
-		prop = fdt_getprop_by_offset(fdto, property, &name,
-					     &prop_len);
-		if (prop_len == -FDT_ERR_NOTFOUND)
-			return -FDT_ERR_INTERNAL;
-		if (prop_len < 0)
-			return prop_len;
+	fdt_for_each_subnode(child, fdt, node) {
+		/* No longer than the structure block, so cannot overflow */
+		if (!fdt_get_name(fdt, child, &namelen))
+			return namelen;
 
-		ret = fdt_setprop(fdt, target, name, prop, prop_len);
-		if (ret)
+		ret = overlay_max_path_len(fdt, child, len + namelen + 1);
+		if (ret < 0)
 			return ret;
+		if (ret > max)
+			max = ret;
 	}
+	if (child != -FDT_ERR_NOTFOUND)
+		return child;
 
-	fdt_for_each_subnode(subnode, fdto, node) {
-		const char *name = fdt_get_name(fdto, subnode, NULL);
-		int nnode;
-		int ret;
+	return max;
+}
 
-		nnode = fdt_add_subnode(fdt, target, name);
-		if (nnode == -FDT_ERR_EXISTS) {
-			nnode = fdt_subnode_offset(fdt, target, name);
-			if (nnode == -FDT_ERR_NOTFOUND)
-				return -FDT_ERR_INTERNAL;
-		}
+/* Reserves count entries of entsize bytes, returning their offset */
+static int overlay_index_reserve(int *size, int count, int entsize)
+{
+	int offset = *size;
 
-		if (nnode < 0)
-			return nnode;
+	if (count > ((INT32_MAX - *size) / entsize))
+		return -FDT_ERR_NOSPACE;
 
-		ret = overlay_apply_node(fdt, nnode, fdto, subnode);
-		if (ret)
-			return ret;
-	}
+	*size += count * entsize;
+	return offset;
+}
 
-	return 0;
+/*
+ * Each node fdt_overlay_apply_into() writes has at most one overlay
+ * node to merge per fragment, and it holds a list of them for every
+ * level from the root down.
+ */
+static int overlay_stack_size(int fragments, int fdt_depth, int fdto_depth)
+{
+	if ((fdto_depth > (INT32_MAX - 2 - fdt_depth))
+	    || (fragments > (INT32_MAX / (fdt_depth + fdto_depth + 2))))
+		return -FDT_ERR_NOSPACE;
+
+	return fragments * (fdt_depth + fdto_depth + 2);
 }
 
 /**
- * overlay_merge - Merge an overlay into its base device tree
+ * overlay_index_place - Places the parts of an overlay index
+ * @hdr: header holding the capacity of each part, which receives
+ *	their offsets
+ * @fdto_size: size of the overlay's lookup index
+ * @batch: whether to reserve room for the merged tree's lookup index
+ *
+ * returns:
+ *      the size of the index in bytes, on success
+ *      -FDT_ERR_NOSPACE, if the index would not fit in an int
+ */
+static int overlay_index_place(struct fdt_overlay_index_header *hdr,
+			       int fdto_size, int batch)
+{
+	int size = sizeof(*hdr);
+
+	hdr->fdt_index = overlay_index_reserve(&size, hdr->fdt_index_size, 1);
+	hdr->next_fdt_index = batch
+		? overlay_index_reserve(&size, hdr->fdt_index_size, 1) : 0;
+	hdr->fdto_index = overlay_index_reserve(&size, fdto_size, 1);
+	hdr->symbols = overlay_index_reserve(&size, hdr->max_symbols,
+					     sizeof(struct fdt_overlay_symbol));
+	hdr->fragments = overlay_index_reserve(&size, hdr->max_fragments,
+				sizeof(struct fdt_overlay_fragment));
+	hdr->stack = overlay_index_reserve(&size, hdr->stack_size,
+					   sizeof(int32_t));
+	hdr->patches = overlay_index_reserve(&size, hdr->max_patches,
+				sizeof(struct fdt_overlay_patch));
+	if ((hdr->fdt_index < 0) || (hdr->next_fdt_index < 0)
+	    || (hdr->fdto_index < 0) || (hdr->symbols < 0)
+	    || (hdr->fragments < 0) || (hdr->stack < 0)
+	    || (hdr->patches < 0))
+		return -FDT_ERR_NOSPACE;
+
+	hdr->num_symbols = 0;
+	hdr->num_fragments = 0;
+	hdr->num_patches = -1;
+	return size;
+}
+
+/**
+ * overlay_index_layout - Lays out an overlay index
  * @fdt: Base Device Tree blob
  * @fdto: Device tree overlay blob
- *
- * overlay_merge() merges an overlay into its base device tree.
- *
- * This is the next to last step in the device tree overlay application
- * process, when all the phandles have been adjusted and resolved and
- * you just have to merge overlay into the base device tree.
+ * @hdr: header which receives the offsets and sizes of the parts
  *
  * returns:
- *      0 on success
+ *      the size of the index in bytes, on success
  *      Negative error code on failure
  */
-static int overlay_merge(void *fdt, void *fdto)
+static int overlay_index_layout(const void *fdt, const void *fdto,
+				struct fdt_overlay_index_header *hdr)
 {
-	int fragment;
+	int fdto_size, fdt_depth, fdto_depth;
 
-	fdt_for_each_subnode(fragment, fdto, 0) {
-		int overlay;
-		int target;
-		int ret;
+	hdr->fdt_index_size = fdt_index_size(fdt);
+	if (hdr->fdt_index_size < 0)
+		return hdr->fdt_index_size;
 
-		/*
-		 * Each fragments will have an __overlay__ node. If
-		 * they don't, it's not supposed to be merged
-		 */
-		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
-		if (overlay == -FDT_ERR_NOTFOUND)
-			continue;
+	fdto_size = fdt_index_size(fdto);
+	if (fdto_size < 0)
+		return fdto_size;
 
-		if (overlay < 0)
-			return overlay;
+	hdr->max_symbols = overlay_count_symbols(fdt);
+	if (hdr->max_symbols < 0)
+		return hdr->max_symbols;
 
-		target = overlay_get_target(fdt, fdto, fragment, NULL);
-		if (target < 0)
-			return target;
+	hdr->max_fragments = overlay_count_fragments(fdto);
+	if (hdr->max_fragments < 0)
+		return hdr->max_fragments;
 
-		ret = overlay_apply_node(fdt, target, fdto, overlay);
-		if (ret)
-			return ret;
-	}
+	hdr->max_patches = overlay_count_patches(fdto);
+	if (hdr->max_patches < 0)
+		return hdr->max_patches;
 
-	return 0;
+	fdt_depth = overlay_max_depth(fdt);
+	if (fdt_depth < 0)
+		return fdt_depth;
+
+	fdto_depth = overlay_max_depth(fdto);
+	if (fdto_depth < 0)
+		return fdto_depth;
+
+	hdr->stack_size = overlay_stack_size(hdr->max_fragments,
+					     fdt_depth, fdto_depth);
+	if (hdr->stack_size < 0)
+		return hdr->stack_size;
+
+	return overlay_index_place(hdr, fdto_size, 0);
 }
 
-static int get_path_len(const void *fdt, int nodeoffset)
+int fdt_overlay_index_size(const void *fdt, const void *fdto)
 {
-	int len = 0, namelen;
-	const char *name;
+	struct fdt_overlay_index_header hdr;
 
 	FDT_CHECK_HEADER(fdt);
+	FDT_CHECK_HEADER(fdto);
 
-	for (;;) {
-		name = fdt_get_name(fdt, nodeoffset, &namelen);
-		if (!name)
-			return namelen;
+	return overlay_index_layout(fdt, fdto, &hdr);
+}
 
-		/* root? we're done */
-		if (namelen == 0)
-			break;
+/**
+ * overlay_index_build_base - Indexes a base device tree
+ * @fdt: Base Device Tree blob
+ * @ovi: Overlay index, laid out
+ *
+ * overlay_index_build_base() builds a lookup index of the base tree
+ * into the overlay index, followed by the tree's symbols sorted by
+ * label. The phandles of the labelled nodes are filled in when first
+ * needed.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_index_build_base(const void *fdt, void *ovi)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_symbol *syms = overlay_symbols(ovi);
+	int symbols_off, prop;
+	int n = 0, ret;
 
-		nodeoffset = fdt_parent_offset(fdt, nodeoffset);
-		if (nodeoffset < 0)
-			return nodeoffset;
-		len += namelen + 1;
+	ret = fdt_index_build(fdt, (char *)ovi + hdr->fdt_index,
+			      hdr->fdt_index_size);
+	if (ret)
+		return ret;
+
+	symbols_off = fdt_index_subnode_offset(fdt, overlay_fdt_index(ovi),
+					       0, "__symbols__");
+	if ((symbols_off < 0) && (symbols_off != -FDT_ERR_NOTFOUND))
+		return symbols_off;
+
+	if (symbols_off >= 0) {
+		fdt_for_each_property_offset(prop, fdt, symbols_off) {
+			const struct fdt_property *p;
+			int len;
+
+			p = fdt_get_property_by_offset(fdt, prop, &len);
+			if (!p)
+				return len;
+
+			if (n >= hdr->max_symbols)
+				return -FDT_ERR_INTERNAL;
+
+			syms[n].nameoff = fdt32_to_cpu(p->nameoff);
+			syms[n].prop = prop;
+			syms[n].phandle = 0;
+			n++;
+		}
+		if (prop != -FDT_ERR_NOTFOUND)
+			return prop;
 	}
 
-	/* in case of root pretend it's "/" */
-	if (len == 0)
-		len++;
-	return len;
+	overlay_symbol_sort(fdt, syms, n);
+
+	hdr->num_symbols = n;
+	return 0;
 }
 
 /**
- * overlay_symbol_update - Update the symbols of base tree after a merge
+ * overlay_index_build - Indexes a base device tree and an overlay
  * @fdt: Base Device Tree blob
  * @fdto: Device tree overlay blob
+ * @ovi: buffer to hold the overlay index
+ * @ovisize: size of the buffer at ovi
  *
- * overlay_symbol_update() updates the symbols of the base tree with the
- * symbols of the applied overlay
- *
- * This is the last step in the device tree overlay application
- * process, allowing the reference of overlay symbols by subsequent
- * overlay operations.
+ * overlay_index_build() builds lookup indexes of both trees into
+ * the buffer, followed by the base tree's symbols sorted by
+ * label. The fragment table is filled in once the overlay's phandles
+ * have been resolved.
  *
  * returns:
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_symbol_update(void *fdt, void *fdto)
+static int overlay_index_build(const void *fdt, const void *fdto,
+			       void *ovi, int ovisize)
 {
-	int root_sym, ov_sym, prop, path_len, fragment, target;
-	int len, frag_name_len, ret, rel_path_len;
-	const char *s, *e;
-	const char *path;
-	const char *name;
-	const char *frag_name;
-	const char *rel_path;
-	const char *target_path;
-	char *buf;
-	void *p;
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_index_header layout;
+	int size, ret;
 
-	ov_sym = fdt_subnode_offset(fdto, 0, "__symbols__");
+	if (ovisize < (int)sizeof(*hdr))
+		return -FDT_ERR_NOSPACE;
 
-	/* if no overlay symbols exist no problem */
-	if (ov_sym < 0)
-		return 0;
+	/* Not usable until we've finished filling it in */
+	hdr->magic = 0;
 
-	root_sym = fdt_subnode_offset(fdt, 0, "__symbols__");
+	size = overlay_index_layout(fdt, fdto, &layout);
+	if (size < 0)
+		return size;
+	if (size > ovisize)
+		return -FDT_ERR_NOSPACE;
+	*hdr = layout;
+	hdr->magic = 0;
 
-	/* it no root symbols exist we should create them */
-	if (root_sym == -FDT_ERR_NOTFOUND)
-		root_sym = fdt_add_subnode(fdt, 0, "__symbols__");
+	ret = overlay_index_build_base(fdt, ovi);
+	if (ret)
+		return ret;
 
-	/* any error is fatal now */
-	if (root_sym < 0)
-		return root_sym;
+	ret = fdt_index_build(fdto, (char *)ovi + hdr->fdto_index,
+			      hdr->symbols - hdr->fdto_index);
+	if (ret)
+		return ret;
 
-	/* iterate over each overlay symbol */
-	fdt_for_each_property_offset(prop, fdto, ov_sym) {
-		path = fdt_getprop_by_offset(fdto, prop, &name, &path_len);
-		if (!path)
-			return path_len;
+	hdr->magic = FDT_OVERLAY_INDEX_MAGIC;
+	return 0;
+}
 
-		/* verify it's a string property (terminated by a single \0) */
-		if (path_len < 1 || memchr(path, '\0', path_len) != &path[path_len - 1])
-			return -FDT_ERR_BADVALUE;
+/**
+ * overlay_symbol_phandle - Retrieves the phandle of a base symbol
+ * @fdt: Base Device Tree blob
+ * @ovi: Overlay index, or NULL
+ * @symbols_off: Node offset of the symbols node in the base device tree
+ * @label: Label of the node
+ * @phandlep: pointer which receives the phandle of the node
+ *
+ * overlay_symbol_phandle() looks up the node a base device tree
+ * symbol points to, and retrieves its phandle. With an overlay
+ * index, the phandle is remembered so that later references to the
+ * same label cost a single bisection.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_symbol_phandle(const void *fdt, void *ovi,
+				  int symbols_off, const char *label,
+				  uint32_t *phandlep)
+{
+	struct fdt_overlay_symbol *sym = NULL;
+	const char *symbol_path;
+	uint32_t phandle;
+	int symbol_off;
+	int prop_len;
 
-		/* keep end marker to avoid strlen() */
-		e = path + path_len;
+	if (ovi) {
+		sym = overlay_find_symbol(fdt, ovi, label);
+		if (!sym)
+			return -FDT_ERR_NOTFOUND;
 
-		/* format: /<fragment-name>/__overlay__/<relative-subnode-path> */
+		if (sym->phandle) {
+			*phandlep = sym->phandle;
+			return 0;
+		}
 
-		if (*path != '/')
-			return -FDT_ERR_BADVALUE;
+		symbol_path = fdt_getprop_by_offset(fdt, sym->prop, NULL,
+						    &prop_len);
+	} else {
+		if (symbols_off < 0)
+			return symbols_off;
 
-		/* get fragment name first */
-		s = strchr(path + 1, '/');
-		if (!s)
-			return -FDT_ERR_BADOVERLAY;
+		symbol_path = fdt_getprop(fdt, symbols_off, label,
+					  &prop_len);
+	}
+	if (!symbol_path)
+		return prop_len;
 
-		frag_name = path + 1;
-		frag_name_len = s - path - 1;
+	symbol_off = fdt_index_path_offset(fdt, overlay_fdt_index(ovi),
+					   symbol_path);
+	if (symbol_off < 0)
+		return symbol_off;
 
-		/* verify format; safe since "s" lies in \0 terminated prop */
-		len = sizeof("/__overlay__/") - 1;
-		if ((e - s) < len || memcmp(s, "/__overlay__/", len))
+	phandle = fdt_get_phandle(fdt, symbol_off);
+	if (!phandle)
+		return -FDT_ERR_NOTFOUND;
+
+	if (sym)
+		sym->phandle = phandle;
+
+	*phandlep = phandle;
+	return 0;
+}
+
+/**
+ * overlay_fixup_one_phandle - Set an overlay phandle to the base one
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @path: Path to a node holding a phandle in the overlay
+ * @path_len: number of path characters to consider
+ * @name: Name of the property holding the phandle reference in the overlay
+ * @name_len: number of name characters to consider
+ * @poffset: Offset within the overlay property where the phandle is stored
+ * @phandle: Phandle of the referenced node in the base device tree
+ *
+ * overlay_fixup_one_phandle() resolves an overlay phandle pointing to
+ * a node in the base device tree.
+ *
+ * This is part of the device tree overlay application process, when
+ * you want all the phandles in the overlay to point to the actual
+ * base dt nodes.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_fixup_one_phandle(const void *fdto, void *ovi,
+				     const char *path, uint32_t path_len,
+				     const char *name, uint32_t name_len,
+				     int poffset, uint32_t phandle)
+{
+	const struct fdt_property *p;
+	int fixup_off, len;
+
+	fixup_off = fdt_index_path_offset_namelen(fdto,
+						  overlay_fdto_index(ovi),
+						  path, path_len);
+	if (fixup_off == -FDT_ERR_NOTFOUND)
+		return -FDT_ERR_BADOVERLAY;
+	if (fixup_off < 0)
+		return fixup_off;
+
+	p = fdt_get_property_namelen(fdto, fixup_off, name, name_len, &len);
+	if (!p)
+		return len;
+
+	if ((poffset < 0) || (poffset > (len - (int)sizeof(fdt32_t))))
+		return -FDT_ERR_NOSPACE;
+
+	return overlay_patch(fdto, ovi, p, poffset, phandle);
+};
+
+/**
+ * overlay_fixup_phandle - Set an overlay phandle to the base one
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @symbols_off: Node offset of the symbols node in the base device tree
+ * @property: Property offset in the overlay holding the list of fixups
+ *
+ * overlay_fixup_phandle() resolves all the overlay phandles pointed
+ * to in a __fixups__ property, and updates them to match the phandles
+ * in use in the base device tree.
+ *
+ * This is part of the device tree overlay application process, when
+ * you want all the phandles in the overlay to point to the actual
+ * base dt nodes.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_fixup_phandle(const void *fdt, const void *fdto,
+				 void *ovi, int symbols_off, int property)
+{
+	const char *value;
+	const char *label;
+	uint32_t phandle = 0;
+	int len;
+
+	value = fdt_getprop_by_offset(fdto, property,
+				      &label, &len);
+	if (!value) {
+		if (len == -FDT_ERR_NOTFOUND)
+			return -FDT_ERR_INTERNAL;
+
+		return len;
+	}
+
+	do {
+		const char *path, *name, *fixup_end;
+		const char *fixup_str = value;
+		uint32_t path_len, name_len;
+		uint32_t fixup_len;
+		char *sep, *endptr;
+		int poffset, ret;
+
+		fixup_end = memchr(value, '\0', len);
+		if (!fixup_end)
+			return -FDT_ERR_BADOVERLAY;
+		fixup_len = fixup_end - fixup_str;
+
+		len -= fixup_len + 1;
+		value += fixup_len + 1;
+
+		path = fixup_str;
+		sep = memchr(fixup_str, ':', fixup_len);
+		if (!sep || *sep != ':')
+			return -FDT_ERR_BADOVERLAY;
+
+		path_len = sep - path;
+		if (path_len == (fixup_len - 1))
+			return -FDT_ERR_BADOVERLAY;
+
+		fixup_len -= path_len + 1;
+		name = sep + 1;
+		sep = memchr(name, ':', fixup_len);
+		if (!sep || *sep != ':')
+			return -FDT_ERR_BADOVERLAY;
+
+		name_len = sep - name;
+		if (!name_len)
+			return -FDT_ERR_BADOVERLAY;
+
+		poffset = strtoul(sep + 1, &endptr, 10);
+		if ((*endptr != '\0') || (endptr <= (sep + 1)))
+			return -FDT_ERR_BADOVERLAY;
+
+		/* Every fixup in the property refers to the same label */
+		if (!phandle) {
+			ret = overlay_symbol_phandle(fdt, ovi, symbols_off,
+						     label, &phandle);
+			if (ret)
+				return ret;
+		}
+
+		ret = overlay_fixup_one_phandle(fdto, ovi, path, path_len,
+						name, name_len, poffset,
+						phandle);
+		if (ret)
+			return ret;
+	} while (len > 0);
+
+	return 0;
+}
+
+/**
+ * overlay_fixup_phandles - Resolve the overlay phandles to the base
+ *                          device tree
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ *
+ * overlay_fixup_phandles() resolves all the overlay phandles pointing
+ * to nodes in the base device tree.
+ *
+ * This is one of the steps of the device tree overlay application
+ * process, when you want all the phandles in the overlay to point to
+ * the actual base dt nodes.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_fixup_phandles(const void *fdt, const void *fdto,
+				  void *ovi)
+{
+	int fixups_off, symbols_off;
+	int property;
+
+	/* We can have overlays without any fixups */
+	fixups_off = fdt_index_path_offset(fdto, overlay_fdto_index(ovi),
+					   "/__fixups__");
+	if (fixups_off == -FDT_ERR_NOTFOUND)
+		return 0; /* nothing to do */
+	if (fixups_off < 0)
+		return fixups_off;
+
+	/* And base DTs without symbols */
+	symbols_off = fdt_index_path_offset(fdt, overlay_fdt_index(ovi),
+					    "/__symbols__");
+	if ((symbols_off < 0 && (symbols_off != -FDT_ERR_NOTFOUND)))
+		return symbols_off;
+
+	fdt_for_each_property_offset(property, fdto, fixups_off) {
+		int ret;
+
+		ret = overlay_fixup_phandle(fdt, fdto, ovi, symbols_off,
+					    property);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * overlay_apply_node - Merges a node into the base device tree
+ * @fdt: Base Device Tree blob
+ * @target: Node offset in the base device tree to apply the fragment to
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @node: Node offset in the overlay holding the changes to merge
+ *
+ * overlay_apply_node() merges a node into a target base device tree
+ * node pointed.
+ *
+ * This is part of the final step in the device tree overlay
+ * application process, when all the phandles have been adjusted and
+ * resolved and you just have to merge overlay into the base device
+ * tree.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_apply_node(void *fdt, int target,
+			      const void *fdto, const void *ovi, int node)
+{
+	int property;
+	int subnode;
+
+	fdt_for_each_property_offset(property, fdto, node) {
+		const char *name;
+		const void *prop;
+		void *val;
+		int prop_len;
+		int ret;
+
+		prop = fdt_getprop_by_offset(fdto, property, &name,
+					     &prop_len);
+		if (prop_len == -FDT_ERR_NOTFOUND)
+			return -FDT_ERR_INTERNAL;
+		if (prop_len < 0)
+			return prop_len;
+
+		ret = fdt_setprop_placeholder(fdt, target, name, prop_len,
+					      &val);
+		if (ret)
+			return ret;
+
+		memcpy(val, prop, prop_len);
+		overlay_patch_value(ovi, property, val);
+	}
+
+	fdt_for_each_subnode(subnode, fdto, node) {
+		const char *name = fdt_get_name(fdto, subnode, NULL);
+		int nnode;
+		int ret;
+
+		nnode = fdt_add_subnode(fdt, target, name);
+		if (nnode == -FDT_ERR_EXISTS) {
+			nnode = fdt_subnode_offset(fdt, target, name);
+			if (nnode == -FDT_ERR_NOTFOUND)
+				return -FDT_ERR_INTERNAL;
+		}
+
+		if (nnode < 0)
+			return nnode;
+
+		ret = overlay_apply_node(fdt, nnode, fdto, ovi, subnode);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * overlay_merge - Merge an overlay into its base device tree
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ *
+ * overlay_merge() merges an overlay into its base device tree.
+ *
+ * This is the next to last step in the device tree overlay application
+ * process, when all the phandles have been adjusted and resolved and
+ * you just have to merge overlay into the base device tree.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_merge(void *fdt, const void *fdto, const void *ovi)
+{
+	int fragment;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		int overlay;
+		int target;
+		int ret;
+
+		/*
+		 * Each fragments will have an __overlay__ node. If
+		 * they don't, it's not supposed to be merged
+		 */
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+
+		if (overlay < 0)
+			return overlay;
+
+		target = overlay_get_target(fdt, fdto, ovi, fragment, NULL);
+		if (target < 0)
+			return target;
+
+		ret = overlay_apply_node(fdt, target, fdto, ovi, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int get_path_len(const void *fdt, const void *idx, int nodeoffset)
+{
+	int len = 0, namelen;
+	const char *name;
+
+	FDT_CHECK_HEADER(fdt);
+
+	for (;;) {
+		name = fdt_get_name(fdt, nodeoffset, &namelen);
+		if (!name)
+			return namelen;
+
+		/* root? we're done */
+		if (namelen == 0)
+			break;
+
+		nodeoffset = fdt_index_parent_offset(fdt, idx, nodeoffset);
+		if (nodeoffset < 0)
+			return nodeoffset;
+		len += namelen + 1;
+	}
+
+	/* in case of root pretend it's "/" */
+	if (len == 0)
+		len++;
+	return len;
+}
+
+/**
+ * overlay_symbol_fragment - Parses a symbol of an overlay
+ * @fdto: Device tree overlay blob
+ * @fdto_idx: Lookup index of the overlay, or NULL
+ * @path: Value of the symbol property
+ * @path_len: Length of the value
+ * @rel_pathp: pointer which receives the path of the labelled node
+ *             relative to the __overlay__ node of its fragment
+ * @rel_path_lenp: pointer which receives the length of that path,
+ *                 including its terminating \0
+ *
+ * returns:
+ *      the node offset of the fragment holding the labelled node
+ *      Negative error code on failure
+ */
+static int overlay_symbol_fragment(const void *fdto, const void *fdto_idx,
+				   const char *path, int path_len,
+				   const char **rel_pathp, int *rel_path_lenp)
+{
+	const char *s, *e;
+	const char *frag_name;
+	int frag_name_len, len, fragment, ret;
+
+	/* verify it's a string property (terminated by a single \0) */
+	if (path_len < 1 || memchr(path, '\0', path_len) != &path[path_len - 1])
+		return -FDT_ERR_BADVALUE;
+
+	/* keep end marker to avoid strlen() */
+	e = path + path_len;
+
+	/* format: /<fragment-name>/__overlay__/<relative-subnode-path> */
+
+	if (*path != '/')
+		return -FDT_ERR_BADVALUE;
+
+	/* get fragment name first */
+	s = strchr(path + 1, '/');
+	if (!s)
+		return -FDT_ERR_BADOVERLAY;
+
+	frag_name = path + 1;
+	frag_name_len = s - path - 1;
+
+	/* verify format; safe since "s" lies in \0 terminated prop */
+	len = sizeof("/__overlay__/") - 1;
+	if ((e - s) < len || memcmp(s, "/__overlay__/", len))
+		return -FDT_ERR_BADOVERLAY;
+
+	*rel_pathp = s + len;
+	*rel_path_lenp = e - *rel_pathp;
+
+	/* find the fragment index in which the symbol lies */
+	ret = fdt_index_subnode_offset_namelen(fdto, fdto_idx, 0, frag_name,
+					       frag_name_len);
+	/* not found? */
+	if (ret < 0)
+		return -FDT_ERR_BADOVERLAY;
+	fragment = ret;
+
+	/* an __overlay__ subnode must exist */
+	ret = fdt_index_subnode_offset(fdto, fdto_idx, fragment, "__overlay__");
+	if (ret < 0)
+		return -FDT_ERR_BADOVERLAY;
+
+	return fragment;
+}
+
+/**
+ * overlay_symbol_update - Update the symbols of base tree after a merge
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ *
+ * overlay_symbol_update() updates the symbols of the base tree with the
+ * symbols of the applied overlay
+ *
+ * This is the last step in the device tree overlay application
+ * process, allowing the reference of overlay symbols by subsequent
+ * overlay operations.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_symbol_update(void *fdt, const void *fdto,
+				 const void *ovi)
+{
+	int root_sym, ov_sym, prop, path_len, fragment, target;
+	int len, ret, rel_path_len;
+	const char *path;
+	const char *name;
+	const char *rel_path;
+	const char *target_path;
+	char *buf;
+	void *p;
+
+	ov_sym = fdt_subnode_offset(fdto, 0, "__symbols__");
+
+	/* if no overlay symbols exist no problem */
+	if (ov_sym < 0)
+		return 0;
+
+	root_sym = fdt_subnode_offset(fdt, 0, "__symbols__");
+
+	/* it no root symbols exist we should create them */
+	if (root_sym == -FDT_ERR_NOTFOUND)
+		root_sym = fdt_add_subnode(fdt, 0, "__symbols__");
+
+	/* any error is fatal now */
+	if (root_sym < 0)
+		return root_sym;
+
+	/* iterate over each overlay symbol */
+	fdt_for_each_property_offset(prop, fdto, ov_sym) {
+		path = fdt_getprop_by_offset(fdto, prop, &name, &path_len);
+		if (!path)
+			return path_len;
+
+		ret = overlay_symbol_fragment(fdto, NULL, path, path_len,
+					      &rel_path, &rel_path_len);
+		if (ret < 0)
+			return ret;
+		fragment = ret;
+
+		/* get the target of the fragment */
+		ret = overlay_get_target(fdt, fdto, ovi, fragment,
+					 &target_path);
+		if (ret < 0)
+			return ret;
+		target = ret;
+
+		/* if we have a target path use */
+		if (!target_path) {
+			ret = get_path_len(fdt, NULL, target);
+			if (ret < 0)
+				return ret;
+			len = ret;
+		} else {
+			len = strlen(target_path);
+		}
+
+		ret = fdt_setprop_placeholder(fdt, root_sym, name,
+				len + (len > 1) + rel_path_len + 1, &p);
+		if (ret < 0)
+			return ret;
+
+		if (!target_path) {
+			/* again in case setprop_placeholder changed it */
+			ret = overlay_get_target(fdt, fdto, ovi, fragment,
+						 &target_path);
+			if (ret < 0)
+				return ret;
+			target = ret;
+		}
+
+		buf = p;
+		if (len > 1) { /* target is not root */
+			if (!target_path) {
+				ret = fdt_get_path(fdt, target, buf, len + 1);
+				if (ret < 0)
+					return ret;
+			} else
+				memcpy(buf, target_path, len + 1);
+
+		} else
+			len--;
+
+		buf[len] = '/';
+		memcpy(buf + len + 1, rel_path, rel_path_len);
+		buf[len + 1 + rel_path_len] = '\0';
+	}
+
+	return 0;
+}
+
+/*
+ * Rebuilding merge.  Rather than splicing each property and subnode
+ * of the overlay into the base tree, each splice moving the tail of
+ * the blob, fdt_overlay_apply_into() writes the merged tree into a new
+ * buffer with the sequential-write functions, in one walk of the base
+ * tree.  Every node written is merged with the overlay nodes which
+ * apply to it, listed in fragment order, which is also overlay offset
+ * order.  The lists are kept in the overlay index, as a stack with one
+ * list per level of the tree.  The overlay's values are copied with the
+ * changes recorded in the index made to them.
+ */
+struct overlay_rebuild {
+	const void *fdt;
+	const void *fdto;
+	const void *fdt_idx;
+	const void *fdto_idx;
+	void *buf;
+	const struct fdt_overlay_fragment *frags;
+	int num_frags;
+	int32_t *stack;
+	int stack_top;
+	int stack_size;
+	int ov_sym;		/* the overlay's __symbols__ node, or -1 */
+	int symbols_done;	/* whether its symbols have been written */
+	int replaced;		/* whether any of them are the base tree's */
+	void *ovi;
+	struct fdt_index_node *nodes;	/* the merged tree's index, or NULL */
+	int num_nodes;
+	int max_nodes;
+	struct fdt_overlay_symbol *syms; /* the symbol table, or NULL */
+	int num_syms;
+	int max_syms;
+};
+
+static struct fdt_overlay_fragment *overlay_fragments(void *ovi)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+
+	return (struct fdt_overlay_fragment *)((char *)ovi + hdr->fragments);
+}
+
+/**
+ * overlay_symbol_target - Finds a fragment's target by its phandle
+ * @fdt: Base Device Tree blob
+ * @ovi: Overlay index
+ * @phandle: Phandle of the target
+ *
+ * Fragments almost always target labelled nodes, whose phandles the
+ * fixups have just looked up through the symbol table, so
+ * overlay_symbol_target() looks for the phandle there before
+ * resorting to a scan of the whole base tree.
+ *
+ * returns:
+ *      the node offset of the target
+ *      Negative error code on failure
+ */
+static int overlay_symbol_target(const void *fdt, void *ovi,
+				 uint32_t phandle)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_symbol *syms = overlay_symbols(ovi);
+	const char *path;
+	int i, len, node;
+
+	for (i = 0; i < hdr->num_symbols; i++) {
+		if (syms[i].phandle != phandle)
+			continue;
+
+		path = fdt_getprop_by_offset(fdt, syms[i].prop, NULL, &len);
+		if (!path)
+			break;
+
+		node = fdt_index_path_offset(fdt, overlay_fdt_index(ovi), path);
+		if ((node >= 0) && (fdt_get_phandle(fdt, node) == phandle))
+			return node;
+		break;
+	}
+
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
+/**
+ * overlay_fragments_build - Resolves the targets of all fragments
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index
+ *
+ * overlay_fragments_build() fills in the overlay index's fragment
+ * table, sorted by target offset and then by fragment order.
+ *
+ * returns:
+ *      0 on success
+ *      -FDT_ERR_NOTFOUND, if a target isn't in the base device tree
+ *      Negative error code on failure
+ */
+static int overlay_fragments_build(const void *fdt, const void *fdto,
+				   void *ovi)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_overlay_fragment *frags = overlay_fragments(ovi);
+	const void *fdto_idx = overlay_fdto_index(ovi);
+	int fragment, overlay, target;
+	uint32_t phandle;
+	int i, n = 0;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_index_subnode_offset(fdto, fdto_idx, fragment,
+						   "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+
+		phandle = overlay_get_target_phandle(fdto, ovi, fragment);
+		if (phandle && (phandle != (uint32_t)-1))
+			target = overlay_symbol_target(fdt, ovi, phandle);
+		else
+			target = overlay_get_target(fdt, fdto, ovi, fragment,
+						    NULL);
+		if (target < 0)
+			return target;
+
+		if (n >= hdr->max_fragments)
+			return -FDT_ERR_INTERNAL;
+
+		/* Fragments are few, so an insertion sort will do */
+		for (i = n; (i > 0) && (frags[i - 1].target > target); i--)
+			frags[i] = frags[i - 1];
+		frags[i].target = target;
+		frags[i].overlay = overlay;
+		frags[i].fragment = fragment;
+		n++;
+	}
+
+	hdr->num_fragments = n;
+	return 0;
+}
+
+/**
+ * overlay_rebuild_list - Lists the overlay nodes to merge into a node
+ * @r: Rebuild state
+ * @list: Overlay nodes merged into the parent node
+ * @n: Number of entries in @list
+ * @node: Node offset in the base device tree, or -1 for a new node
+ * @name: Name of the node
+ * @namelen: Length of the name
+ * @listp: pointer which receives the list
+ *
+ * overlay_rebuild_list() pushes a list of the overlay nodes to merge
+ * into a node: the subnodes of the same name of the nodes merged into
+ * its parent, and the __overlay__ nodes of the fragments targeting
+ * it, in fragment order.
+ *
+ * returns:
+ *      the number of entries in the list
+ *      Negative error code on failure
+ */
+static int overlay_rebuild_list(struct overlay_rebuild *r,
+				const int32_t *list, int n, int node,
+				const char *name, int namelen,
+				int32_t **listp)
+{
+	int32_t *out = r->stack + r->stack_top;
+	int count = 0, lo, hi, i, j, sub;
+
+	for (i = 0; i < n; i++) {
+		sub = fdt_index_subnode_offset_namelen(r->fdto, r->fdto_idx,
+						       list[i], name, namelen);
+		if (sub == -FDT_ERR_NOTFOUND)
+			continue;
+		if (sub < 0)
+			return sub;
+
+		if (r->stack_top + count >= r->stack_size)
+			return -FDT_ERR_INTERNAL;
+		out[count++] = sub;
+	}
+
+	/* Find the fragments targeting the node by bisection */
+	lo = 0;
+	hi = node >= 0 ? r->num_frags : 0;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (r->frags[mid].target < node)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; (lo < r->num_frags) && (r->frags[lo].target == node); lo++) {
+		if (r->stack_top + count >= r->stack_size)
+			return -FDT_ERR_INTERNAL;
+
+		for (j = count; (j > 0) && (out[j - 1] > r->frags[lo].overlay);
+		     j--)
+			out[j] = out[j - 1];
+		out[j] = r->frags[lo].overlay;
+		count++;
+	}
+
+	r->stack_top += count;
+	*listp = out;
+	return count;
+}
+
+/**
+ * overlay_rebuild_track_symbol - Records a symbol written out
+ * @r: Rebuild state
+ * @name: Label of the symbol
+ * @offset: Offset of the property written in the merged tree
+ * @changed: whether the symbol's value may differ from the base tree's
+ *
+ * When fdt_overlay_apply_many() will go on to apply another overlay,
+ * overlay_rebuild_track_symbol() keeps the symbol table in step with
+ * the merged tree's /__symbols__ node, so that it need not be rebuilt,
+ * and the phandles it has resolved are kept where still valid.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_rebuild_track_symbol(struct overlay_rebuild *r,
+					const char *name, int offset,
+					int changed)
+{
+	struct fdt_overlay_symbol *sym;
+
+	if (!r->syms)
+		return 0;
+
+	/* Entries added by this merge lie beyond those searched */
+	sym = overlay_find_symbol(r->fdt, r->ovi, name);
+	if (!sym) {
+		if (r->num_syms >= r->max_syms)
+			return -FDT_ERR_INTERNAL;
+		sym = &r->syms[r->num_syms++];
+		changed = 1;
+	}
+
+	/* The name offset is only known once the tree is finished */
+	sym->prop = offset;
+	if (changed)
+		sym->phandle = 0;
+
+	return 0;
+}
+
+/**
+ * overlay_rebuild_symbols - Writes out the symbols of the overlay
+ * @r: Rebuild state
+ *
+ * overlay_rebuild_symbols() is the rebuilding counterpart of
+ * overlay_symbol_update(), writing each overlay symbol with the path
+ * of its node in the merged tree.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_rebuild_symbols(struct overlay_rebuild *r)
+{
+	const char *path, *name, *rel_path, *target_path;
+	int prop, path_len, rel_path_len, fragment, target;
+	int i, len, offset, ret;
+	char *buf;
+	void *p;
+
+	fdt_for_each_property_offset(prop, r->fdto, r->ov_sym) {
+		path = fdt_getprop_by_offset(r->fdto, prop, &name, &path_len);
+		if (!path)
+			return path_len;
+
+		fragment = overlay_symbol_fragment(r->fdto, r->fdto_idx,
+						   path, path_len,
+						   &rel_path, &rel_path_len);
+		if (fragment < 0)
+			return fragment;
+
+		for (i = 0; i < r->num_frags; i++)
+			if (r->frags[i].fragment == fragment)
+				break;
+		if (i == r->num_frags)
 			return -FDT_ERR_BADOVERLAY;
+		target = r->frags[i].target;
 
-		rel_path = s + len;
-		rel_path_len = e - rel_path;
+		/* if the fragment has a target path, use that */
+		target_path = NULL;
+		if (!overlay_get_target_phandle(r->fdto, r->ovi, fragment))
+			target_path = fdt_getprop(r->fdto, fragment,
+						  "target-path", NULL);
 
-		/* find the fragment index in which the symbol lies */
-		ret = fdt_subnode_offset_namelen(fdto, 0, frag_name,
-					       frag_name_len);
-		/* not found? */
+		if (!target_path) {
+			ret = get_path_len(r->fdt, r->fdt_idx, target);
+			if (ret < 0)
+				return ret;
+			len = ret;
+		} else {
+			len = strlen(target_path);
+		}
+
+		offset = fdt_size_dt_struct(r->buf);
+		ret = fdt_property_placeholder(r->buf, name,
+				len + (len > 1) + rel_path_len + 1, &p);
 		if (ret < 0)
-			return -FDT_ERR_BADOVERLAY;
-		fragment = ret;
+			return ret;
+
+		ret = overlay_rebuild_track_symbol(r, name, offset, 1);
+		if (ret)
+			return ret;
+
+		buf = p;
+		if (len > 1) { /* target is not root */
+			if (!target_path) {
+				ret = fdt_index_get_path(r->fdt, r->fdt_idx,
+							 target, buf, len + 1);
+				if (ret < 0)
+					return ret;
+			} else
+				memcpy(buf, target_path, len + 1);
+
+		} else
+			len--;
+
+		buf[len] = '/';
+		memcpy(buf + len + 1, rel_path, rel_path_len);
+		buf[len + 1 + rel_path_len] = '\0';
+	}
+
+	r->symbols_done = 1;
+	return 0;
+}
+
+/* Does a symbol of the overlay replace the named one? */
+static int overlay_rebuild_symbol_exists(struct overlay_rebuild *r,
+					 int symbols, const char *name)
+{
+	return symbols && fdt_getprop(r->fdto, r->ov_sym, name, NULL);
+}
+
+/**
+ * overlay_rebuild_node - Writes out a merged node
+ * @r: Rebuild state
+ * @node: Node offset in the base device tree, or -1 for a new node
+ * @name: Name of the node
+ * @list: Overlay nodes to merge into the node
+ * @n: Number of entries in @list
+ * @depth: Depth of the node
+ * @parent: Index entry of the parent node, or -1
+ * @prev: Index entry of the previous sibling, or -1, updated
+ *
+ * overlay_rebuild_node() writes out a node of the base device tree
+ * with the overlay nodes in @list merged into it, as
+ * overlay_apply_node() would have applied them one after the other,
+ * then does the same for each of its subnodes.
+ *
+ * The properties and subnodes of the base node keep their order, and
+ * those the overlay adds follow them in the order they first appear
+ * in the overlay.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_rebuild_node(struct overlay_rebuild *r, int node,
+				const char *name, const int32_t *list, int n,
+				int depth, int parent, int *prev)
+{
+	const struct fdt_property *prop, *p;
+	const char *pname, *cname;
+	const void *val;
+	int32_t *clist;
+	int offset, sub, child, top, cn, cnamelen, out, src;
+	int self = -1, last = -1;
+	int at_symbols, symbols, len, vlen, i, j, err;
+	void *copy;
+
+	at_symbols = (depth == 1) && !strcmp(name, "__symbols__");
+	symbols = at_symbols && (r->ov_sym >= 0);
+
+	if (r->nodes) {
+		struct fdt_index_node *e;
+
+		if (r->num_nodes >= r->max_nodes)
+			return -FDT_ERR_INTERNAL;
+
+		self = r->num_nodes++;
+		e = &r->nodes[self];
+		e->offset = fdt_size_dt_struct(r->buf);
+		e->end = -1;
+		e->depth = depth;
+		e->parent = parent;
+		e->first_child = -1;
+		e->next_sibling = -1;
+
+		if (*prev >= 0)
+			r->nodes[*prev].next_sibling = self;
+		else if (parent >= 0)
+			r->nodes[parent].first_child = self;
+		*prev = self;
+	}
+
+	err = fdt_begin_node(r->buf, name);
+	if (err)
+		return err;
+
+	/*
+	 * The base node's properties, as last set by the overlay. The
+	 * merged tree starts with the base tree's strings, so their names
+	 * need not be looked up.
+	 */
+	if (node >= 0) {
+		fdt_for_each_property_offset(offset, r->fdt, node) {
+			prop = fdt_get_property_by_offset(r->fdt, offset, &len);
+			if (!prop)
+				return len;
+
+			pname = fdt_string(r->fdt, fdt32_to_cpu(prop->nameoff));
+			if (!pname)
+				return -FDT_ERR_BADSTRUCTURE;
+			if (r->replaced
+			    && overlay_rebuild_symbol_exists(r, symbols, pname))
+				continue;
+
+			val = prop->data;
+			src = -1;
+			for (i = n - 1; i >= 0; i--) {
+				p = fdt_get_property(r->fdto, list[i], pname,
+						     &vlen);
+				if (p) {
+					val = p->data;
+					len = vlen;
+					src = overlay_prop_offset(r->fdto, p);
+					break;
+				}
+			}
+
+			out = fdt_size_dt_struct(r->buf);
+			err = _fdt_sw_property_copied(r->buf, r->fdt,
+					fdt32_to_cpu(prop->nameoff), len, &copy);
+			if (err)
+				return err;
+
+			memcpy(copy, val, len);
+			if (src >= 0)
+				overlay_patch_value(r->ovi, src, copy);
+
+			if (at_symbols) {
+				err = overlay_rebuild_track_symbol(r, pname, out,
+							val != prop->data);
+				if (err)
+					return err;
+			}
+		}
+		if (offset != -FDT_ERR_NOTFOUND)
+			return offset;
+	}
+
+	/* Then the properties the overlay adds */
+	for (i = 0; i < n; i++) {
+		fdt_for_each_property_offset(offset, r->fdto, list[i]) {
+			val = fdt_getprop_by_offset(r->fdto, offset, &pname,
+						    &len);
+			if (!val)
+				return len;
+			src = offset;
+
+			if ((node >= 0)
+			    && fdt_get_property(r->fdt, node, pname, NULL))
+				continue;
+			if (overlay_rebuild_symbol_exists(r, symbols, pname))
+				continue;
+			for (j = 0; j < i; j++)
+				if (fdt_getprop(r->fdto, list[j], pname, NULL))
+					break;
+			if (j < i)
+				continue;
+
+			for (j = n - 1; j > i; j--) {
+				p = fdt_get_property(r->fdto, list[j], pname,
+						     &vlen);
+				if (p) {
+					val = p->data;
+					len = vlen;
+					src = overlay_prop_offset(r->fdto, p);
+					break;
+				}
+			}
+
+			out = fdt_size_dt_struct(r->buf);
+			err = fdt_property_placeholder(r->buf, pname, len, &copy);
+			if (err)
+				return err;
+
+			memcpy(copy, val, len);
+			overlay_patch_value(r->ovi, src, copy);
+
+			if (at_symbols) {
+				err = overlay_rebuild_track_symbol(r, pname, out,
+								   1);
+				if (err)
+					return err;
+			}
+		}
+		if (offset != -FDT_ERR_NOTFOUND)
+			return offset;
+	}
+
+	if (symbols) {
+		err = overlay_rebuild_symbols(r);
+		if (err)
+			return err;
+	}
+
+	/* The base node's subnodes */
+	if (node >= 0) {
+		fdt_for_each_subnode(child, r->fdt, node) {
+			cname = fdt_get_name(r->fdt, child, &cnamelen);
+			if (!cname)
+				return cnamelen;
+
+			top = r->stack_top;
+			cn = overlay_rebuild_list(r, list, n, child,
+						  cname, cnamelen, &clist);
+			if (cn < 0)
+				return cn;
+
+			err = overlay_rebuild_node(r, child, cname, clist, cn,
+						   depth + 1, self, &last);
+			r->stack_top = top;
+			if (err)
+				return err;
+		}
+	}
+
+	/* Then the subnodes the overlay adds */
+	for (i = 0; i < n; i++) {
+		fdt_for_each_subnode(sub, r->fdto, list[i]) {
+			cname = fdt_get_name(r->fdto, sub, &cnamelen);
+			if (!cname)
+				return cnamelen;
+
+			if (node >= 0) {
+				child = fdt_index_subnode_offset_namelen(r->fdt,
+						r->fdt_idx, node,
+						cname, cnamelen);
+				if (child >= 0)
+					continue;
+				if (child != -FDT_ERR_NOTFOUND)
+					return child;
+			}
+			for (j = 0; j < i; j++)
+				if (fdt_index_subnode_offset_namelen(r->fdto,
+						r->fdto_idx, list[j],
+						cname, cnamelen) >= 0)
+					break;
+			if (j < i)
+				continue;
+
+			top = r->stack_top;
+			cn = overlay_rebuild_list(r, list + i, n - i, -1,
+						  cname, cnamelen, &clist);
+			if (cn < 0)
+				return cn;
+
+			err = overlay_rebuild_node(r, -1, cname, clist, cn,
+						   depth + 1, self, &last);
+			r->stack_top = top;
+			if (err)
+				return err;
+		}
+	}
+
+	/* The base tree had no symbols for the overlay's to join */
+	if ((depth == 0) && (r->ov_sym >= 0) && !r->symbols_done) {
+		err = overlay_rebuild_node(r, -1, "__symbols__", NULL, 0, 1,
+					   self, &last);
+		if (err)
+			return err;
+	}
+
+	err = fdt_end_node(r->buf);
+	if (err)
+		return err;
+
+	if (r->nodes)
+		r->nodes[self].end = fdt_size_dt_struct(r->buf);
+
+	return 0;
+}
+
+/**
+ * overlay_rebuild - Writes out the merge of an overlay and its base tree
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, with the fragment table filled in
+ * @buf: Buffer to write the merged tree to
+ * @bufsize: Size of the buffer at buf
+ *
+ * overlay_rebuild() is the rebuilding counterpart of overlay_merge()
+ * followed by overlay_symbol_update().
+ *
+ * If the overlay index has room for the merged tree's lookup index,
+ * overlay_rebuild() also fills that in, and brings the symbol table up
+ * to date with the merged tree.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_rebuild(const void *fdt, const void *fdto, void *ovi,
+			   void *buf, int bufsize)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	struct fdt_index_header *next = NULL;
+	struct overlay_rebuild r;
+	uint64_t address, size;
+	int32_t *list;
+	int i, n, num_rsv, prev = -1, err;
+
+	r.fdt = fdt;
+	r.fdto = fdto;
+	r.fdt_idx = overlay_fdt_index(ovi);
+	r.fdto_idx = overlay_fdto_index(ovi);
+	r.buf = buf;
+	r.frags = overlay_fragments(ovi);
+	r.num_frags = hdr->num_fragments;
+	r.stack = (int32_t *)((char *)ovi + hdr->stack);
+	r.stack_top = 0;
+	r.stack_size = hdr->stack_size;
+	r.symbols_done = 0;
+	r.ovi = ovi;
+	r.nodes = NULL;
+	r.syms = NULL;
+
+	if (hdr->next_fdt_index) {
+		next = (struct fdt_index_header *)((char *)ovi
+						   + hdr->next_fdt_index);
+		next->magic = 0;
+		r.nodes = (struct fdt_index_node *)(next + 1);
+		r.num_nodes = 0;
+		r.max_nodes = (hdr->fdt_index_size - sizeof(*next))
+			/ sizeof(struct fdt_index_node);
+		r.syms = overlay_symbols(ovi);
+		r.num_syms = hdr->num_symbols;
+		r.max_syms = hdr->max_symbols;
+	}
+
+	/* if no overlay symbols exist no problem */
+	r.ov_sym = fdt_index_subnode_offset(fdto, r.fdto_idx, 0,
+					    "__symbols__");
+	if (r.ov_sym < 0)
+		r.ov_sym = -1;
+
+	/*
+	 * Only look for each base symbol among the overlay's if the
+	 * sorted symbol table says some are there.
+	 */
+	r.replaced = 0;
+	if (r.ov_sym >= 0) {
+		const char *name;
+
+		fdt_for_each_property_offset(i, fdto, r.ov_sym) {
+			if (!fdt_getprop_by_offset(fdto, i, &name, NULL))
+				return -FDT_ERR_BADSTRUCTURE;
+			if (overlay_find_symbol(fdt, ovi, name)) {
+				r.replaced = 1;
+				break;
+			}
+		}
+	}
+
+	n = overlay_rebuild_list(&r, NULL, 0, 0, "", 0, &list);
+	if (n < 0)
+		return n;
+
+	err = fdt_create(buf, bufsize);
+	num_rsv = fdt_num_mem_rsv(fdt);
+	for (i = 0; !err && (i < num_rsv); i++) {
+		err = fdt_get_mem_rsv(fdt, i, &address, &size);
+		if (!err)
+			err = fdt_add_reservemap_entry(buf, address, size);
+	}
+	if (!err)
+		err = fdt_finish_reservemap(buf);
+	if (!err)
+		err = _fdt_sw_copy_strings(buf, fdt);
+	if (!err)
+		err = overlay_rebuild_node(&r, 0, "", list, n, 0, -1, &prev);
+	if (!err)
+		err = fdt_finish(buf);
+	if (err)
+		return err;
+
+	fdt_set_boot_cpuid_phys(buf, fdt_boot_cpuid_phys(fdt));
+
+	if (next) {
+		next->size_dt_struct = fdt_size_dt_struct(buf);
+		next->num_nodes = r.num_nodes;
+		next->reserved = 0;
+		next->magic = FDT_INDEX_MAGIC;
+
+		for (i = 0; i < r.num_syms; i++) {
+			const struct fdt_property *p;
+			int len;
+
+			p = fdt_get_property_by_offset(buf, r.syms[i].prop,
+						       &len);
+			if (!p)
+				return len;
+			r.syms[i].nameoff = fdt32_to_cpu(p->nameoff);
+		}
+
+		if (r.num_syms > hdr->num_symbols)
+			overlay_symbol_sort(buf, r.syms, r.num_syms);
+		hdr->num_symbols = r.num_syms;
+	}
+
+	return 0;
+}
+
+/**
+ * overlay_prepare - Readies an overlay to be merged
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, or NULL
+ * @delta: Highest phandle in the base device tree
+ * @record: Whether to record the changes in the overlay index rather
+ *          than make them to the overlay
+ *
+ * overlay_prepare() renumbers the overlay's own phandles so they
+ * follow the base tree's, and points its references to base nodes at
+ * their phandles.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_prepare(const void *fdt, const void *fdto, void *ovi,
+			   uint32_t delta, int record)
+{
+	struct fdt_overlay_index_header *hdr = ovi;
+	int ret;
+
+	if (hdr)
+		hdr->num_patches = record ? 0 : -1;
+
+	ret = overlay_adjust_local_phandles(fdto, ovi, delta);
+	if (ret)
+		return ret;
+
+	ret = overlay_fixup_phandles(fdt, fdto, ovi);
+	if (ret)
+		return ret;
 
-		/* an __overlay__ subnode must exist */
-		ret = fdt_subnode_offset(fdto, fragment, "__overlay__");
-		if (ret < 0)
-			return -FDT_ERR_BADOVERLAY;
+	if (record)
+		overlay_patch_sort(overlay_patches(ovi), hdr->num_patches);
 
-		/* get the target of the fragment */
-		ret = overlay_get_target(fdt, fdto, fragment, &target_path);
-		if (ret < 0)
-			return ret;
-		target = ret;
+	return 0;
+}
 
-		/* if we have a target path use */
-		if (!target_path) {
-			ret = get_path_len(fdt, target);
-			if (ret < 0)
-				return ret;
-			len = ret;
-		} else {
-			len = strlen(target_path);
-		}
+/**
+ * overlay_merge_into - Writes out the merge of a prepared overlay
+ * @fdt: Base Device Tree blob
+ * @fdto: Device tree overlay blob
+ * @ovi: Overlay index, holding the changes to the overlay's values
+ * @buf: Buffer to write the merged tree to
+ * @bufsize: Size of the buffer at buf
+ *
+ * overlay_merge_into() rebuilds the merged tree into @buf, unless a
+ * fragment targets a node added by an earlier one. It then applies
+ * the fragments one at a time to a copy in @buf instead, and the copy
+ * is left unpacked.
+ *
+ * returns:
+ *      0 if the merged tree was rebuilt
+ *      1 if it was applied to a copy
+ *      Negative error code on failure
+ */
+static int overlay_merge_into(const void *fdt, const void *fdto, void *ovi,
+			      void *buf, int bufsize)
+{
+	int ret;
 
-		ret = fdt_setprop_placeholder(fdt, root_sym, name,
-				len + (len > 1) + rel_path_len + 1, &p);
-		if (ret < 0)
+	ret = overlay_fragments_build(fdt, fdto, ovi);
+	if (ret == -FDT_ERR_NOTFOUND) {
+		ret = fdt_open_into(fdt, buf, bufsize);
+		if (ret)
 			return ret;
 
-		if (!target_path) {
-			/* again in case setprop_placeholder changed it */
-			ret = overlay_get_target(fdt, fdto, fragment, &target_path);
-			if (ret < 0)
-				return ret;
-			target = ret;
-		}
-
-		buf = p;
-		if (len > 1) { /* target is not root */
-			if (!target_path) {
-				ret = fdt_get_path(fdt, target, buf, len + 1);
-				if (ret < 0)
-					return ret;
-			} else
-				memcpy(buf, target_path, len + 1);
+		ret = overlay_merge(buf, fdto, ovi);
+		if (ret)
+			return ret;
 
-		} else
-			len--;
+		ret = overlay_symbol_update(buf, fdto, ovi);
+		if (ret)
+			return ret;
 
-		buf[len] = '/';
-		memcpy(buf + len + 1, rel_path, rel_path_len);
-		buf[len + 1 + rel_path_len] = '\0';
+		return 1;
 	}
+	if (ret)
+		return ret;
 
-	return 0;
+	return overlay_rebuild(fdt, fdto, ovi, buf, bufsize);
 }
 
-int fdt_overlay_apply(void *fdt, void *fdto)
+static int overlay_apply(void *fdt, void *fdto, void *ovi)
 {
-	uint32_t delta = fdt_get_max_phandle(fdt);
 	int ret;
 
 	FDT_CHECK_HEADER(fdt);
 	FDT_CHECK_HEADER(fdto);
 
-	ret = overlay_adjust_local_phandles(fdto, delta);
-	if (ret)
-		goto err;
-
-	ret = overlay_update_local_references(fdto, delta);
-	if (ret)
-		goto err;
-
-	ret = overlay_fixup_phandles(fdt, fdto);
+	ret = overlay_prepare(fdt, fdto, ovi, fdt_get_max_phandle(fdt), 0);
 	if (ret)
 		goto err;
 
-	ret = overlay_merge(fdt, fdto);
+	ret = overlay_merge(fdt, fdto, ovi);
 	if (ret)
 		goto err;
 
-	ret = overlay_symbol_update(fdt, fdto);
+	ret = overlay_symbol_update(fdt, fdto, ovi);
 	if (ret)
 		goto err;
 
@@ -859,3 +2497,387 @@ err:
 
 	return ret;
 }
+
+int fdt_overlay_apply(void *fdt, void *fdto)
+{
+	return overlay_apply(fdt, fdto, NULL);
+}
+
+int fdt_overlay_apply_indexed(void *fdt, void *fdto, void *idx, int idxsize)
+{
+	int ret;
+
+	FDT_CHECK_HEADER(fdt);
+	FDT_CHECK_HEADER(fdto);
+
+	ret = overlay_index_build(fdt, fdto, idx, idxsize);
+	if (ret)
+		return ret;
+
+	return overlay_apply(fdt, fdto, idx);
+}
+
+int fdt_overlay_apply_into(const void *fdt, const void *fdto,
+			   void *idx, int idxsize, void *buf, int bufsize)
+{
+	int ret;
+
+	FDT_CHECK_HEADER(fdt);
+	FDT_CHECK_HEADER(fdto);
+
+	ret = overlay_index_build(fdt, fdto, idx, idxsize);
+	if (ret)
+		return ret;
+
+	ret = overlay_prepare(fdt, fdto, idx, fdt_get_max_phandle(fdt), 1);
+	if (ret)
+		goto err;
+
+	ret = overlay_merge_into(fdt, fdto, idx, buf, bufsize);
+	if (ret == 1)
+		ret = fdt_pack(buf);
+	if (ret)
+		goto err;
+
+	return 0;
+
+err:
+	/*
+	 * The merged tree is incomplete, erase its magic.
+	 */
+	if (bufsize >= (int)sizeof(struct fdt_header))
+		fdt_set_magic(buf, ~0);
+
+	return ret;
+}
+
+/**
+ * overlay_count_new_symbols - Bounds the symbols an overlay may add
+ * @fdto: Device tree overlay blob
+ *
+ * returns:
+ *      the number of properties of the overlay's /__symbols__ node,
+ *      plus those a fragment might set in the base tree's
+ *      Negative error code on failure
+ */
+static int overlay_count_new_symbols(const void *fdto)
+{
+	int fragment, overlay, symbols, prop, count, ret;
+
+	count = overlay_count_symbols(fdto);
+	if (count < 0)
+		return count;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+
+		/* Either the fragment targets /__symbols__ ... */
+		fdt_for_each_property_offset(prop, fdto, overlay) {
+			ret = overlay_add_bound(&count, 1);
+			if (ret)
+				return ret;
+		}
+		if (prop != -FDT_ERR_NOTFOUND)
+			return prop;
+
+		/* ... or the root */
+		symbols = fdt_subnode_offset(fdto, overlay, "__symbols__");
+		if (symbols == -FDT_ERR_NOTFOUND)
+			continue;
+		if (symbols < 0)
+			return symbols;
+
+		fdt_for_each_property_offset(prop, fdto, symbols) {
+			ret = overlay_add_bound(&count, 1);
+			if (ret)
+				return ret;
+		}
+		if (prop != -FDT_ERR_NOTFOUND)
+			return prop;
+	}
+
+	return count;
+}
+
+/**
+ * overlay_batch_layout - Lays out the workspace of a batch of overlays
+ * @fdt: Base Device Tree blob
+ * @fdtos: Device tree overlay blobs
+ * @count: Number of overlays
+ * @hdr: header which receives the layout of the overlay index
+ * @tree_size: pointer which receives the size of the scratch tree
+ *
+ * overlay_batch_layout() sizes the parts of the overlay index for
+ * the largest tree and overlay of the batch. The merged trees cannot
+ * grow by more nodes, symbols or levels than the overlays hold, nor
+ * by more bytes than the overlays hold plus the growth of the paths
+ * of their symbols.
+ *
+ * returns:
+ *      the size of the workspace in bytes, on success
+ *      Negative error code on failure
+ */
+static int overlay_batch_layout(const void *fdt, const void *const fdtos[],
+				int count,
+				struct fdt_overlay_index_header *hdr,
+				int *tree_size)
+{
+	int fdt_depth, fdto_depth = 0, fdto_size = 0, path_len;
+	int i, size, ret;
+
+	hdr->fdt_index_size = fdt_index_size(fdt);
+	if (hdr->fdt_index_size < 0)
+		return hdr->fdt_index_size;
+
+	hdr->max_symbols = overlay_count_symbols(fdt);
+	if (hdr->max_symbols < 0)
+		return hdr->max_symbols;
+
+	fdt_depth = overlay_max_depth(fdt);
+	if (fdt_depth < 0)
+		return fdt_depth;
+
+	path_len = overlay_max_path_len(fdt, 0, 0);
+	if (path_len < 0)
+		return path_len;
+
+	hdr->max_fragments = 0;
+	hdr->max_patches = 0;
+	*tree_size = fdt_totalsize(fdt);
+
+	for (i = 0; i < count; i++) {
+		const void *fdto = fdtos[i];
+
+		ret = fdt_index_size(fdto);
+		if (ret < 0)
+			return ret;
+		if (ret > fdto_size)
+			fdto_size = ret;
+
+		ret = overlay_add_bound(&hdr->fdt_index_size,
+				ret - sizeof(struct fdt_index_header));
+		if (ret)
+			return ret;
+
+		ret = overlay_count_new_symbols(fdto);
+		if (ret < 0)
+			return ret;
+
+		ret = overlay_add_bound(&hdr->max_symbols, ret);
+		if (ret)
+			return ret;
+
+		ret = overlay_count_fragments(fdto);
+		if (ret < 0)
+			return ret;
+		if (ret > hdr->max_fragments)
+			hdr->max_fragments = ret;
+
+		ret = overlay_count_patches(fdto);
+		if (ret < 0)
+			return ret;
+		if (ret > hdr->max_patches)
+			hdr->max_patches = ret;
+
+		ret = overlay_max_depth(fdto);
+		if (ret < 0)
+			return ret;
+		if (ret > fdto_depth)
+			fdto_depth = ret;
+
+		ret = overlay_add_bound(&fdt_depth, ret);
+		if (ret)
+			return ret;
+
+		ret = overlay_add_bound(tree_size, fdt_totalsize(fdto));
+		if (ret)
+			return ret;
+
+		/*
+		 * Each of the overlay's symbols grows by at most the path
+		 * of its fragment's target, which is no longer than the
+		 * longest path in the tree so far.  The overlay's nodes then
+		 * lengthen that by at most its own longest path.
+		 */
+		ret = overlay_count_symbols(fdto);
+		if (ret < 0)
+			return ret;
+		if (ret && (path_len > (INT32_MAX / ret)))
+			return -FDT_ERR_NOSPACE;
+
+		ret = overlay_add_bound(tree_size, ret * path_len);
+		if (ret)
+			return ret;
+
+		ret = overlay_max_path_len(fdto, 0, 0);
+		if (ret < 0)
+			return ret;
+
+		ret = overlay_add_bound(&path_len, ret);
+		if (ret)
+			return ret;
+	}
+
+	hdr->stack_size = overlay_stack_size(hdr->max_fragments,
+					     fdt_depth, fdto_depth);
+	if (hdr->stack_size < 0)
+		return hdr->stack_size;
+
+	size = overlay_index_place(hdr, fdto_size, 1);
+	if (size < 0)
+		return size;
+
+	/* The scratch tree follows the index */
+	if (size > (INT32_MAX - 7))
+		return -FDT_ERR_NOSPACE;
+	size = FDT_ALIGN(size, 8);
+
+	ret = overlay_add_bound(&size, *tree_size);
+	if (ret)
+		return ret;
+
+	return size;
+}
+
+int fdt_overlay_apply_many_size(const void *fdt, const void *const fdtos[],
+				int count)
+{
+	struct fdt_overlay_index_header hdr;
+	int tree_size, i;
+
+	FDT_CHECK_HEADER(fdt);
+	for (i = 0; i < count; i++)
+		FDT_CHECK_HEADER(fdtos[i]);
+
+	return overlay_batch_layout(fdt, fdtos, count, &hdr, &tree_size);
+}
+
+int fdt_overlay_merged_size(const void *fdt, const void *const fdtos[],
+			    int count)
+{
+	struct fdt_overlay_index_header hdr;
+	int tree_size, i, ret;
+
+	FDT_CHECK_HEADER(fdt);
+	for (i = 0; i < count; i++)
+		FDT_CHECK_HEADER(fdtos[i]);
+
+	ret = overlay_batch_layout(fdt, fdtos, count, &hdr, &tree_size);
+	if (ret < 0)
+		return ret;
+
+	return tree_size;
+}
+
+int fdt_overlay_apply_many(const void *fdt, const void *const fdtos[],
+			   int count, void *ws, int wssize, void *buf, int bufsize,
+			   int *failedp)
+{
+	struct fdt_overlay_index_header *hdr = ws;
+	struct fdt_overlay_index_header layout;
+	const void *src = fdt;
+	uint32_t max_phandle, phandle;
+	int size, tree_size, dstsize;
+	int i, indexed = 0, ret;
+	void *tree, *dst;
+
+	if (failedp)
+		*failedp = -1;
+
+	FDT_CHECK_HEADER(fdt);
+	for (i = 0; i < count; i++) {
+		ret = fdt_check_header(fdtos[i]);
+		if (ret) {
+			if (failedp)
+				*failedp = i;
+			return ret;
+		}
+	}
+
+	size = overlay_batch_layout(fdt, fdtos, count, &layout, &tree_size);
+	if (size < 0)
+		return size;
+	if (size > wssize)
+		return -FDT_ERR_NOSPACE;
+
+	*hdr = layout;
+	hdr->magic = 0;
+	tree = (char *)ws + (size - tree_size);
+
+	max_phandle = fdt_get_max_phandle(fdt);
+
+	for (i = 0; i < count; i++) {
+		/* Alternate between the buffers so the last tree is in buf */
+		if ((count - i) % 2) {
+			dst = buf;
+			dstsize = bufsize;
+		} else {
+			dst = tree;
+			dstsize = tree_size;
+		}
+
+		/*
+		 * The index and symbol table of the base tree are only
+		 * built once, then follow the merged trees as they are
+		 * written, unless an overlay had to be applied in place.
+		 */
+		if (!indexed) {
+			ret = overlay_index_build_base(src, ws);
+			if (ret)
+				goto err;
+		}
+
+		ret = fdt_index_build(fdtos[i], (char *)ws + hdr->fdto_index,
+				      hdr->symbols - hdr->fdto_index);
+		if (ret)
+			goto err;
+		hdr->magic = FDT_OVERLAY_INDEX_MAGIC;
+
+		ret = overlay_prepare(src, fdtos[i], ws, max_phandle, 1);
+		if (ret)
+			goto err;
+
+		/* The overlay's phandles will follow the base tree's */
+		phandle = fdt_get_max_phandle(fdtos[i]);
+		if (phandle)
+			max_phandle += phandle;
+
+		ret = overlay_merge_into(src, fdtos[i], ws, dst, dstsize);
+		if (ret < 0)
+			goto err;
+
+		indexed = !ret;
+		if (indexed) {
+			int32_t next = hdr->next_fdt_index;
+
+			hdr->next_fdt_index = hdr->fdt_index;
+			hdr->fdt_index = next;
+		}
+
+		src = dst;
+	}
+
+	if (count)
+		return fdt_pack(buf);
+
+	ret = fdt_open_into(fdt, buf, bufsize);
+	if (ret)
+		goto err;
+
+	return fdt_pack(buf);
+
+err:
+	/*
+	 * The merged tree is incomplete, erase its magic.
+	 */
+	if (bufsize >= (int)sizeof(struct fdt_header))
+		fdt_set_magic(buf, ~0);
+
+	if (failedp && (i < count))
+		*failedp = i;
+	return ret;
+}
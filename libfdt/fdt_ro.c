@@ -55,8 +55,7 @@
 
 #include "libfdt_internal.h"
 
-static int _fdt_nodename_eq(const void *fdt, int offset,
-			    const char *s, int len)
+int _fdt_nodename_eq(const void *fdt, int offset, const char *s, int len)
 {
 	const char *p = fdt_offset_ptr(fdt, offset + FDT_TAGSIZE, len+1);
 
@@ -180,6 +179,44 @@ int fdt_subnode_offset(const void *fdt, int parentoffset,
 	return fdt_subnode_offset_namelen(fdt, parentoffset, name, strlen(name));
 }
 
+static int _fdt_nodename_eq_trusted(const void *fdt, int offset,
+				    const char *s, int len)
+{
+	const char *p = _fdt_offset_ptr(fdt, offset + FDT_TAGSIZE);
+	int i;
+
+	/* don't run off the end of a name shorter than s */
+	for (i = 0; i < len; i++)
+		if ((p[i] == '\0') || (p[i] != s[i]))
+			return 0;
+
+	if (p[len] == '\0')
+		return 1;
+	else if (!memchr(s, '@', len) && (p[len] == '@'))
+		return 1;
+	else
+		return 0;
+}
+
+int fdt_subnode_offset_namelen_trusted(const void *fdt, int offset,
+				       const char *name, int namelen)
+{
+	for (offset = fdt_first_subnode_trusted(fdt, offset);
+	     offset >= 0;
+	     offset = fdt_next_subnode_trusted(fdt, offset))
+		if (_fdt_nodename_eq_trusted(fdt, offset, name, namelen))
+			return offset;
+
+	return offset;
+}
+
+int fdt_subnode_offset_trusted(const void *fdt, int parentoffset,
+			       const char *name)
+{
+	return fdt_subnode_offset_namelen_trusted(fdt, parentoffset,
+						  name, strlen(name));
+}
+
 int fdt_path_offset_namelen(const void *fdt, const char *path, int namelen)
 {
 	const char *end = path + namelen;
@@ -352,6 +389,151 @@ const void *fdt_getprop(const void *fdt, int nodeoffset,
 	return fdt_getprop_namelen(fdt, nodeoffset, name, strlen(name), lenp);
 }
 
+int fdt_string_offset_namelen(const void *fdt, const char *s, int len)
+{
+	const char *strtab, *p, *q, *end;
+	int stroffset = -FDT_ERR_NOTFOUND;
+
+	FDT_CHECK_HEADER(fdt);
+
+	/* Unfinished trees use negative string offsets */
+	if (fdt_magic(fdt) != FDT_MAGIC)
+		return -FDT_ERR_BADSTATE;
+
+	strtab = fdt_string(fdt, 0);
+	end = strtab + fdt_size_dt_strings(fdt);
+
+	/*
+	 * dtc and libfdt both name every property after the first
+	 * place the name is stored, which may be the tail of a longer
+	 * string.  A later tail is only ever a stale alias, but the
+	 * name stored again in full may be referred to in its own
+	 * right, and then no single offset matches every property.
+	 */
+	for (p = strtab; (len >= 0) && ((end - p) > len); p = q + 1) {
+		q = memchr(p, '\0', end - p);
+		if (!q)
+			break;
+		if (((q - p) < len) || (memcmp(q - len, s, len) != 0))
+			continue;
+		if (stroffset < 0)
+			stroffset = q - len - strtab;
+		else if ((q - len) == p)
+			return -FDT_ERR_EXISTS;
+	}
+
+	return stroffset;
+}
+
+int fdt_string_offset(const void *fdt, const char *s)
+{
+	return fdt_string_offset_namelen(fdt, s, strlen(s));
+}
+
+const struct fdt_property *fdt_get_property_by_stroff(const void *fdt,
+						      int nodeoffset,
+						      int stroffset,
+						      int *lenp)
+{
+	int offset;
+
+	for (offset = fdt_first_property_offset(fdt, nodeoffset);
+	     (offset >= 0);
+	     (offset = fdt_next_property_offset(fdt, offset))) {
+		const struct fdt_property *prop = _fdt_offset_ptr(fdt, offset);
+
+		if ((int)fdt32_to_cpu(prop->nameoff) == stroffset) {
+			if (lenp)
+				*lenp = fdt32_to_cpu(prop->len);
+			return prop;
+		}
+	}
+
+	if (lenp)
+		*lenp = offset;
+	return NULL;
+}
+
+const void *fdt_getprop_by_stroff(const void *fdt, int nodeoffset,
+				  int stroffset, int *lenp)
+{
+	const struct fdt_property *prop;
+
+	prop = fdt_get_property_by_stroff(fdt, nodeoffset, stroffset, lenp);
+	if (!prop)
+		return NULL;
+
+	return prop->data;
+}
+
+int fdt_getprops_by_stroff(const void *fdt, int nodeoffset, int count,
+			   const int *stroffsets, const void **vals,
+			   int *lens)
+{
+	int offset, i, found = 0;
+
+	for (i = 0; i < count; i++) {
+		vals[i] = NULL;
+		if (lens)
+			lens[i] = -FDT_ERR_NOTFOUND;
+	}
+
+	for (offset = fdt_first_property_offset(fdt, nodeoffset);
+	     (offset >= 0) && (found < count);
+	     (offset = fdt_next_property_offset(fdt, offset))) {
+		const struct fdt_property *prop = _fdt_offset_ptr(fdt, offset);
+		int nameoff = fdt32_to_cpu(prop->nameoff);
+
+		for (i = 0; i < count; i++)
+			if ((stroffsets[i] == nameoff) && !vals[i]) {
+				vals[i] = prop->data;
+				if (lens)
+					lens[i] = fdt32_to_cpu(prop->len);
+				found++;
+			}
+	}
+
+	if ((offset < 0) && (offset != -FDT_ERR_NOTFOUND))
+		return offset;
+	return found;
+}
+
+const void *fdt_getprop_namelen_trusted(const void *fdt, int nodeoffset,
+					const char *name, int namelen,
+					int *lenp)
+{
+	int offset, nextoffset;
+	uint32_t tag;
+
+	fdt_next_tag_trusted(fdt, nodeoffset, &nextoffset);
+	do {
+		offset = nextoffset;
+		tag = fdt_next_tag_trusted(fdt, offset, &nextoffset);
+		if (tag == FDT_PROP) {
+			const struct fdt_property *prop =
+				_fdt_offset_ptr(fdt, offset);
+
+			if (_fdt_string_eq(fdt, fdt32_to_cpu(prop->nameoff),
+					   name, namelen)) {
+				if (lenp)
+					*lenp = fdt32_to_cpu(prop->len);
+				return prop->data;
+			}
+		}
+	} while ((tag == FDT_PROP) || (tag == FDT_NOP));
+
+	if (lenp)
+		*lenp = -FDT_ERR_NOTFOUND;
+	return NULL;
+}
+
+const void *fdt_getprop_trusted(const void *fdt, int nodeoffset,
+				const char *name, int *lenp)
+{
+	return fdt_getprop_namelen_trusted(fdt, nodeoffset, name,
+					   strlen(name), lenp);
+}
+
 uint32_t fdt_get_phandle(const void *fdt, int nodeoffset)
 {
 	const fdt32_t *php;
@@ -197,19 +197,13 @@ int fdt_end_node(void *fdt)
 	return 0;
 }
 
-static int _fdt_find_add_string(void *fdt, const char *s)
+static int _fdt_add_string(void *fdt, const char *s)
 {
 	char *strtab = (char *)fdt + fdt_totalsize(fdt);
-	const char *p;
 	int strtabsize = fdt_size_dt_strings(fdt);
 	int len = strlen(s) + 1;
 	int struct_top, offset;
 
-	p = _fdt_find_string(strtab - strtabsize, strtabsize, s);
-	if (p)
-		return p - strtab;
-
-	/* Add it */
 	offset = -strtabsize - len;
 	struct_top = fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt);
 	if (fdt_totalsize(fdt) + offset < struct_top)
@@ -220,16 +214,22 @@ static int _fdt_find_add_string(void *fdt, const char *s)
 	return offset;
 }
 
-int fdt_property_placeholder(void *fdt, const char *name, int len, void **valp)
+static int _fdt_find_add_string(void *fdt, const char *s)
 {
-	struct fdt_property *prop;
-	int nameoff;
+	char *strtab = (char *)fdt + fdt_totalsize(fdt);
+	const char *p;
+	int strtabsize = fdt_size_dt_strings(fdt);
 
-	FDT_SW_CHECK_HEADER(fdt);
+	p = _fdt_find_string(strtab - strtabsize, strtabsize, s);
+	if (p)
+		return p - strtab;
 
-	nameoff = _fdt_find_add_string(fdt, name);
-	if (nameoff == 0)
-		return -FDT_ERR_NOSPACE;
+	return _fdt_add_string(fdt, s);
+}
+
+static int _fdt_add_property(void *fdt, int nameoff, int len, void **valp)
+{
+	struct fdt_property *prop;
 
 	prop = _fdt_grab_space(fdt, sizeof(*prop) + FDT_TAGALIGN(len));
 	if (! prop)
@@ -242,6 +242,19 @@ int fdt_property_placeholder(void *fdt, const char *name, int len, void **valp)
 	return 0;
 }
 
+int fdt_property_placeholder(void *fdt, const char *name, int len, void **valp)
+{
+	int nameoff;
+
+	FDT_SW_CHECK_HEADER(fdt);
+
+	nameoff = _fdt_find_add_string(fdt, name);
+	if (nameoff == 0)
+		return -FDT_ERR_NOSPACE;
+
+	return _fdt_add_property(fdt, nameoff, len, valp);
+}
+
 int fdt_property(void *fdt, const char *name, const void *val, int len)
 {
 	void *ptr;
@@ -254,6 +267,68 @@ int fdt_property(void *fdt, const char *name, const void *val, int len)
 	return 0;
 }
 
+int _fdt_sw_copy_strings(void *fdt, const void *src)
+{
+	char *strtab = (char *)fdt + fdt_totalsize(fdt);
+	int len = fdt_size_dt_strings(src);
+	int struct_top;
+
+	FDT_SW_CHECK_HEADER(fdt);
+
+	if (fdt_size_dt_strings(fdt) != 0)
+		return -FDT_ERR_BADSTATE;
+
+	struct_top = fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt);
+	if ((int)fdt_totalsize(fdt) - len < struct_top)
+		return -FDT_ERR_NOSPACE;
+
+	memcpy(strtab - len, (const char *)src + fdt_off_dt_strings(src), len);
+	fdt_set_size_dt_strings(fdt, len);
+	return 0;
+}
+
+int _fdt_sw_property_copied(void *fdt, const void *src, int stroffset,
+			    int len, void **valp)
+{
+	int strtabsize = fdt_size_dt_strings(src);
+
+	FDT_SW_CHECK_HEADER(fdt);
+
+	if ((stroffset < 0) || (stroffset >= strtabsize))
+		return -FDT_ERR_BADOFFSET;
+
+	/* The copy sits where the first strings added would have */
+	return _fdt_add_property(fdt, stroffset - strtabsize, len, valp);
+}
+
+int _fdt_sw_add_string(void *fdt, const void *src, const char *s,
+		       int *nameoffp)
+{
+	const char *strtab = (const char *)src + fdt_off_dt_strings(src);
+	int strtabsize = fdt_size_dt_strings(src);
+	const char *p;
+
+	FDT_SW_CHECK_HEADER(fdt);
+
+	p = _fdt_find_string(strtab, strtabsize, s);
+	if (p) {
+		*nameoffp = (p - strtab) - strtabsize;
+		return 0;
+	}
+
+	*nameoffp = _fdt_add_string(fdt, s);
+	if (*nameoffp == 0)
+		return -FDT_ERR_NOSPACE;
+	return 0;
+}
+
+int _fdt_sw_property_at(void *fdt, int nameoff, int len, void **valp)
+{
+	FDT_SW_CHECK_HEADER(fdt);
+
+	return _fdt_add_property(fdt, nameoff, len, valp);
+}
+
 int fdt_finish(void *fdt)
 {
 	char *p = (char *)fdt;
@@ -0,0 +1,589 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *
+ * libfdt is dual licensed: you can use it either under the terms of
+ * the GPL, or the BSD license, at your option.
+ *
+ *  a) This library is free software; you can redistribute it and/or
+ *     modify it under the terms of the GNU General Public License as
+ *     published by the Free Software Foundation; either version 2 of the
+ *     License, or (at your option) any later version.
+ *
+ *     This library is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public
+ *     License along with this library; if not, write to the Free
+ *     Software Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,
+ *     MA 02110-1301 USA
+ *
+ * Alternatively,
+ *
+ *  b) Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ *     THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *     CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *     INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *     MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *     DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *     CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *     SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *     NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *     LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *     HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *     CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ *     OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ *     EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "libfdt_env.h"
+
+#include <fdt.h>
+#include <libfdt.h>
+
+#include "libfdt_internal.h"
+
+static int _fdt_txn_check(const void *fdt, const void *txn)
+{
+	const struct fdt_txn_header *hdr = txn;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (!hdr || (hdr->magic != FDT_TXN_MAGIC)
+	    || (hdr->totalsize != fdt_totalsize(fdt))
+	    || (hdr->size_dt_struct != fdt_size_dt_struct(fdt)))
+		return -FDT_ERR_BADVALUE;
+
+	return 0;
+}
+
+/* Handles for added nodes lie beyond the end of the blob */
+static int _fdt_txn_handle(const struct fdt_txn_header *hdr, int seq)
+{
+	return hdr->totalsize + (seq + 1) * FDT_TAGSIZE;
+}
+
+static int _fdt_txn_check_target(const void *fdt, void *txn, int offset)
+{
+	struct fdt_txn_header *hdr = txn;
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	int seq;
+
+	if (offset < (int)hdr->totalsize)
+		return _fdt_check_node_offset(fdt, offset);
+
+	seq = (offset - hdr->totalsize) / FDT_TAGSIZE - 1;
+	if ((offset % FDT_TAGSIZE) || (seq < 0) || (seq >= hdr->count)
+	    || (e[seq].type != FDT_TXN_ADD_SUBNODE))
+		return -FDT_ERR_BADOFFSET;
+
+	return 0;
+}
+
+static const char *_fdt_txn_data(const void *txn, int offset)
+{
+	return (const char *)txn + offset;
+}
+
+static int _fdt_txn_name_eq(const void *txn, const struct fdt_txn_entry *e,
+			    const char *name, int namelen)
+{
+	return (e->namelen == namelen)
+		&& (memcmp(_fdt_txn_data(txn, e->name), name, namelen) == 0);
+}
+
+static uint32_t _fdt_txn_hash(int target, const char *name, int namelen)
+{
+	uint32_t h = 2166136261U ^ ((uint32_t)target * 0x9e3779b9U);
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < namelen; i++)
+		h = (h ^ (unsigned char)name[i]) * 16777619U;
+	return h;
+}
+
+/* Most recent entry with the same target and name hash, or -1 */
+static int _fdt_txn_chain(void *txn, int target, const char *name,
+			  int namelen)
+{
+	struct fdt_txn_header *hdr = txn;
+
+	return _fdt_txn_buckets(txn)[_fdt_txn_hash(target, name, namelen)
+				     & (hdr->nbuckets - 1)];
+}
+
+/* Most recent entry with the same target hash, or -1 */
+static int _fdt_txn_target_chain(void *txn, int target)
+{
+	struct fdt_txn_header *hdr = txn;
+
+	return _fdt_txn_buckets(txn)[hdr->nbuckets
+				     + (_fdt_txn_hash(target, "", 0)
+					& (hdr->nbuckets - 1))];
+}
+
+/* Most recent setprop or delprop of the named property, or -1 */
+static int _fdt_txn_latest(void *txn, int nodeoffset, const char *name,
+			   int namelen)
+{
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	int i;
+
+	/* The chain runs from the most recent edit backwards */
+	for (i = _fdt_txn_chain(txn, nodeoffset, name, namelen); i >= 0;
+	     i = e[i].next)
+		if ((e[i].target == nodeoffset)
+		    && ((e[i].type == FDT_TXN_SETPROP)
+			|| (e[i].type == FDT_TXN_DELPROP))
+		    && _fdt_txn_name_eq(txn, &e[i], name, namelen))
+			return i;
+	return -1;
+}
+
+static struct fdt_txn_entry *_fdt_txn_add(void *txn, int type, int target,
+					  const char *name, int namelen,
+					  const void *val, int len)
+{
+	struct fdt_txn_header *hdr = txn;
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn) + hdr->count;
+	int need = namelen + 1 + len;
+	int32_t *bucket;
+	char *p;
+
+	if ((len < 0) || (namelen < 0)
+	    || ((char *)(e + 1) + need > (char *)txn + hdr->data))
+		return NULL;
+
+	hdr->data -= need;
+	p = (char *)txn + hdr->data;
+	memcpy(p, name, namelen);
+	p[namelen] = '\0';
+	if (len)
+		memcpy(p + namelen + 1, val, len);
+
+	e->target = target;
+	e->seq = hdr->count++;
+	e->type = type;
+	e->name = hdr->data;
+	e->namelen = namelen;
+	e->val = hdr->data + namelen + 1;
+	e->len = len;
+	e->first = e->last = -1;
+	e->flags = 0;
+	e->nnext = e->strent = -1;
+	e->stroff = 0;
+
+	bucket = _fdt_txn_buckets(txn)
+		+ (_fdt_txn_hash(target, name, namelen) & (hdr->nbuckets - 1));
+	e->next = *bucket;
+	*bucket = e->seq;
+
+	bucket = _fdt_txn_buckets(txn) + hdr->nbuckets
+		+ (_fdt_txn_hash(target, "", 0) & (hdr->nbuckets - 1));
+	e->tnext = *bucket;
+	*bucket = e->seq;
+	return e;
+}
+
+/*
+ * Indexes a setprop by its name alone, so that each distinct name the
+ * transaction adds is only interned once at commit time.
+ */
+static void _fdt_txn_add_name(void *txn, struct fdt_txn_entry *new)
+{
+	struct fdt_txn_header *hdr = txn;
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	const char *name = _fdt_txn_data(txn, new->name);
+	int32_t *bucket;
+	int i;
+
+	bucket = _fdt_txn_buckets(txn) + 2 * hdr->nbuckets
+		+ (_fdt_txn_hash(0, name, new->namelen) & (hdr->nbuckets - 1));
+	for (i = *bucket; i >= 0; i = e[i].nnext)
+		if (_fdt_txn_name_eq(txn, &e[i], name, new->namelen))
+			break;
+
+	new->strent = (i >= 0) ? e[i].strent : new->seq;
+	new->nnext = *bucket;
+	*bucket = new->seq;
+}
+
+/* Is the named property in the tree as it was before the transaction? */
+static int _fdt_txn_prop_original(const void *fdt, void *txn, int nodeoffset,
+				  const char *name, int namelen)
+{
+	struct fdt_txn_header *hdr = txn;
+
+	if (nodeoffset < (int)hdr->totalsize)
+		return !!fdt_get_property_namelen(fdt, nodeoffset,
+						  name, namelen, NULL);
+	return 0;
+}
+
+static int _fdt_txn_deleted(void *txn, int nodeoffset)
+{
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	int i;
+
+	/* Deletions are recorded with an empty name */
+	for (i = _fdt_txn_chain(txn, nodeoffset, "", 0); i >= 0; i = e[i].next)
+		if ((e[i].target == nodeoffset) && (e[i].type == FDT_TXN_DEL_NODE))
+			return 1;
+	return 0;
+}
+
+static void _fdt_txn_clear_buckets(void *txn)
+{
+	struct fdt_txn_header *hdr = txn;
+	int32_t *bucket = _fdt_txn_buckets(txn);
+	int i;
+
+	for (i = 0; i < 3 * hdr->nbuckets; i++)
+		bucket[i] = -1;
+}
+
+int fdt_txn_init(const void *fdt, void *txn, int txnsize)
+{
+	struct fdt_txn_header *hdr = txn;
+	int nbuckets = 1, nentries;
+
+	FDT_CHECK_HEADER(fdt);
+
+	if (fdt_magic(fdt) != FDT_MAGIC)
+		return -FDT_ERR_BADSTATE;
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+
+	/* About a bucket for every four entries the journal could hold */
+	nentries = txnsize / (int)sizeof(struct fdt_txn_entry);
+	while ((nbuckets * 2) <= (nentries / 4))
+		nbuckets *= 2;
+	if (txnsize < (int)(sizeof(*hdr) + 3 * nbuckets * sizeof(int32_t)))
+		return -FDT_ERR_NOSPACE;
+
+	hdr->magic = FDT_TXN_MAGIC;
+	hdr->totalsize = fdt_totalsize(fdt);
+	hdr->size_dt_struct = fdt_size_dt_struct(fdt);
+	hdr->count = 0;
+	hdr->data = txnsize;
+	hdr->size = txnsize;
+	hdr->nbuckets = nbuckets;
+	_fdt_txn_clear_buckets(txn);
+	return 0;
+}
+
+int fdt_txn_rollback(void *txn)
+{
+	struct fdt_txn_header *hdr = txn;
+
+	if (!hdr || (hdr->magic != FDT_TXN_MAGIC))
+		return -FDT_ERR_BADVALUE;
+
+	hdr->count = 0;
+	hdr->data = hdr->size;
+	_fdt_txn_clear_buckets(txn);
+	return 0;
+}
+
+int fdt_txn_setprop(const void *fdt, void *txn, int nodeoffset,
+		    const char *name, const void *val, int len)
+{
+	struct fdt_txn_entry *e, *new;
+	int namelen = strlen(name);
+	int latest, err;
+
+	if ((err = _fdt_txn_check(fdt, txn)) < 0)
+		return err;
+	if ((err = _fdt_txn_check_target(fdt, txn, nodeoffset)) < 0)
+		return err;
+
+	e = _fdt_txn_entries(txn);
+	latest = _fdt_txn_latest(txn, nodeoffset, name, namelen);
+
+	new = _fdt_txn_add(txn, FDT_TXN_SETPROP, nodeoffset,
+			   name, namelen, val, len);
+	if (!new)
+		return -FDT_ERR_NOSPACE;
+	_fdt_txn_add_name(txn, new);
+
+	/*
+	 * Track, on the setprop which created the property, the one
+	 * that gives its final value, so the commit needn't search.
+	 */
+	if ((latest >= 0) && (e[latest].type == FDT_TXN_SETPROP)) {
+		new->first = e[latest].first;
+	} else {
+		new->first = new->seq;
+		if ((latest < 0)
+		    && _fdt_txn_prop_original(fdt, txn, nodeoffset,
+					      name, namelen))
+			new->flags = FDT_TXN_REPLACES;
+	}
+	e[new->first].last = new->seq;
+	return 0;
+}
+
+int fdt_txn_delprop(const void *fdt, void *txn, int nodeoffset,
+		    const char *name)
+{
+	struct fdt_txn_entry *e;
+	int namelen = strlen(name);
+	int latest, err;
+
+	if ((err = _fdt_txn_check(fdt, txn)) < 0)
+		return err;
+	if ((err = _fdt_txn_check_target(fdt, txn, nodeoffset)) < 0)
+		return err;
+
+	e = _fdt_txn_entries(txn);
+	latest = _fdt_txn_latest(txn, nodeoffset, name, namelen);
+	if ((latest >= 0) ? (e[latest].type != FDT_TXN_SETPROP)
+	    : !_fdt_txn_prop_original(fdt, txn, nodeoffset, name, namelen))
+		return -FDT_ERR_NOTFOUND;
+
+	if (!_fdt_txn_add(txn, FDT_TXN_DELPROP, nodeoffset,
+			  name, namelen, NULL, 0))
+		return -FDT_ERR_NOSPACE;
+
+	if (latest >= 0)
+		e[e[latest].first].last = -1;
+	return 0;
+}
+
+int fdt_txn_add_subnode(const void *fdt, void *txn, int parentoffset,
+			const char *name)
+{
+	struct fdt_txn_header *hdr = txn;
+	struct fdt_txn_entry *e;
+	int namelen = strlen(name);
+	int offset, i, err;
+
+	if ((err = _fdt_txn_check(fdt, txn)) < 0)
+		return err;
+	if ((err = _fdt_txn_check_target(fdt, txn, parentoffset)) < 0)
+		return err;
+
+	if (parentoffset < (int)hdr->totalsize) {
+		offset = fdt_subnode_offset_namelen(fdt, parentoffset,
+						    name, namelen);
+		if ((offset >= 0) && !_fdt_txn_deleted(txn, offset))
+			return -FDT_ERR_EXISTS;
+		else if ((offset < 0) && (offset != -FDT_ERR_NOTFOUND))
+			return offset;
+	}
+
+	e = _fdt_txn_entries(txn);
+	for (i = _fdt_txn_chain(txn, parentoffset, name, namelen); i >= 0;
+	     i = e[i].next)
+		if ((e[i].target == parentoffset)
+		    && (e[i].type == FDT_TXN_ADD_SUBNODE)
+		    && _fdt_txn_name_eq(txn, &e[i], name, namelen)
+		    && !_fdt_txn_deleted(txn, _fdt_txn_handle(hdr, i)))
+			return -FDT_ERR_EXISTS;
+
+	e = _fdt_txn_add(txn, FDT_TXN_ADD_SUBNODE, parentoffset,
+			 name, namelen, NULL, 0);
+	if (!e)
+		return -FDT_ERR_NOSPACE;
+	return _fdt_txn_handle(hdr, e->seq);
+}
+
+int fdt_txn_del_node(const void *fdt, void *txn, int nodeoffset)
+{
+	int err;
+
+	if ((err = _fdt_txn_check(fdt, txn)) < 0)
+		return err;
+	if ((err = _fdt_txn_check_target(fdt, txn, nodeoffset)) < 0)
+		return err;
+
+	if (_fdt_txn_deleted(txn, nodeoffset))
+		return -FDT_ERR_NOTFOUND;
+
+	if (!_fdt_txn_add(txn, FDT_TXN_DEL_NODE, nodeoffset, "", 0, NULL, 0))
+		return -FDT_ERR_NOSPACE;
+	return 0;
+}
+
+/*
+ * Commit.  Each node's edits are found through the index by target,
+ * most recent first, and each original property's through the index
+ * by name, so the tree and the journal are each walked once.
+ */
+static int _fdt_txn_emit_props(const void *fdt, void *txn, void *buf,
+			       int target, int edited)
+{
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	const struct fdt_property *prop;
+	const char *pname, *val;
+	void *p;
+	int offset, nameoff, len, i, err;
+
+	fdt_for_each_property_offset(offset, fdt, target) {
+		prop = fdt_get_property_by_offset(fdt, offset, &len);
+		nameoff = fdt32_to_cpu(prop->nameoff);
+		val = prop->data;
+
+		if (edited) {
+			pname = fdt_string(fdt, nameoff);
+			i = _fdt_txn_latest(txn, target, pname, strlen(pname));
+			if ((i >= 0)
+			    && ((e[i].type != FDT_TXN_SETPROP)
+				|| !(e[e[i].first].flags & FDT_TXN_REPLACES)))
+				continue; /* deleted, and perhaps re-added */
+			if (i >= 0) {
+				val = _fdt_txn_data(txn, e[i].val);
+				len = e[i].len;
+			}
+		}
+
+		/* The name is already in the copied strings block */
+		err = _fdt_sw_property_copied(buf, fdt, nameoff, len, &p);
+		if (err)
+			return err;
+		memcpy(p, val, len);
+	}
+	if ((offset < 0) && (offset != -FDT_ERR_NOTFOUND))
+		return offset;
+	return 0;
+}
+
+/* A property the transaction adds, with the value it was last set to */
+static int _fdt_txn_emit_added(const void *fdt, void *txn, void *buf,
+			       const struct fdt_txn_entry *added)
+{
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	struct fdt_txn_entry *str = &e[added->strent];
+	const struct fdt_txn_entry *val = &e[added->last];
+	void *p;
+	int err;
+
+	if (!str->stroff) {
+		err = _fdt_sw_add_string(buf, fdt,
+					 _fdt_txn_data(txn, str->name),
+					 &str->stroff);
+		if (err)
+			return err;
+	}
+
+	err = _fdt_sw_property_at(buf, str->stroff, val->len, &p);
+	if (err)
+		return err;
+	memcpy(p, _fdt_txn_data(txn, val->val), val->len);
+	return 0;
+}
+
+static int _fdt_txn_emit_node(const void *fdt, void *txn, void *buf,
+			      int target, const char *name)
+{
+	struct fdt_txn_header *hdr = txn;
+	struct fdt_txn_entry *e = _fdt_txn_entries(txn);
+	int old = target < (int)hdr->totalsize;
+	int head, edited = 0;
+	int i, offset, err;
+
+	if (_fdt_txn_deleted(txn, target))
+		return 0;
+
+	err = fdt_begin_node(buf, name);
+	if (err)
+		return err;
+
+	/*
+	 * Properties added by the transaction come first, most recent
+	 * first, as they would if added one at a time by fdt_setprop().
+	 */
+	head = _fdt_txn_target_chain(txn, target);
+	for (i = head; i >= 0; i = e[i].tnext) {
+		if (e[i].target != target)
+			continue;
+		edited = 1;
+		if ((e[i].type != FDT_TXN_SETPROP) || (e[i].first != i)
+		    || (e[i].last < 0) || (e[i].flags & FDT_TXN_REPLACES))
+			continue;
+		err = _fdt_txn_emit_added(fdt, txn, buf, &e[i]);
+		if (err)
+			return err;
+	}
+
+	/* Then the original properties, minus deletions */
+	if (old) {
+		err = _fdt_txn_emit_props(fdt, txn, buf, target, edited);
+		if (err)
+			return err;
+	}
+
+	/* Likewise new subnodes, most recent first, then the originals */
+	for (i = edited ? head : -1; i >= 0; i = e[i].tnext) {
+		if ((e[i].target != target)
+		    || (e[i].type != FDT_TXN_ADD_SUBNODE))
+			continue;
+		err = _fdt_txn_emit_node(fdt, txn, buf,
+					 _fdt_txn_handle(hdr, e[i].seq),
+					 _fdt_txn_data(txn, e[i].name));
+		if (err)
+			return err;
+	}
+
+	if (old) {
+		fdt_for_each_subnode(offset, fdt, target) {
+			err = _fdt_txn_emit_node(fdt, txn, buf, offset,
+						 fdt_get_name(fdt, offset, NULL));
+			if (err)
+				return err;
+		}
+		if ((offset < 0) && (offset != -FDT_ERR_NOTFOUND))
+			return offset;
+	}
+
+	return fdt_end_node(buf);
+}
+
+int fdt_txn_commit(const void *fdt, void *txn, void *buf, int bufsize)
+{
+	struct fdt_txn_header *hdr = txn;
+	uint64_t address, size;
+	int i, n, err;
+
+	if ((err = _fdt_txn_check(fdt, txn)) < 0)
+		return err;
+
+	/* Forget the string offsets of any earlier, failed, attempt */
+	for (i = 0; i < hdr->count; i++)
+		_fdt_txn_entries(txn)[i].stroff = 0;
+
+	err = fdt_create(buf, bufsize);
+	n = fdt_num_mem_rsv(fdt);
+	for (i = 0; !err && (i < n); i++) {
+		err = fdt_get_mem_rsv(fdt, i, &address, &size);
+		if (!err)
+			err = fdt_add_reservemap_entry(buf, address, size);
+	}
+	if (!err)
+		err = fdt_finish_reservemap(buf);
+	/* Only the names the transaction adds need interning */
+	if (!err)
+		err = _fdt_sw_copy_strings(buf, fdt);
+	if (!err)
+		err = _fdt_txn_emit_node(fdt, txn, buf, 0, "");
+	if (!err)
+		err = fdt_finish(buf);
+	if (err)
+		return err;
+
+	fdt_set_boot_cpuid_phys(buf, fdt_boot_cpuid_phys(fdt));
+	hdr->magic = 0;
+	return 0;
+}
@@ -259,6 +259,33 @@ __fdt_set_hdr(size_dt_struct);
  */
 int fdt_check_header(const void *fdt);
 
+/**
+ * fdt_check_full - check that a device tree blob is entirely well-formed
+ * @fdt: pointer to data which might be a flattened device tree
+ * @bufsize: size of the buffer at fdt
+ *
+ * fdt_check_full() goes well beyond fdt_check_header(): it checks
+ * that the whole blob lies within bufsize, that every block lies
+ * within the blob, that the memory reservation map is terminated and
+ * that the structure block consists of exactly one properly nested
+ * root node (followed only by NOPs and FDT_END), with every node name
+ * and property name terminated within its block.
+ *
+ * A blob which passes this check may be read with the *_trusted()
+ * functions, which omit the per-tag bounds checks of their ordinary
+ * equivalents.  Unfinished sequential-write trees are rejected.
+ *
+ * returns:
+ *     0, if the buffer contains a well-formed device tree
+ *     -FDT_ERR_BADMAGIC,
+ *     -FDT_ERR_BADVERSION,
+ *     -FDT_ERR_BADSTATE,
+ *     -FDT_ERR_BADOFFSET,
+ *     -FDT_ERR_BADSTRUCTURE,
+ *     -FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_check_full(const void *fdt, size_t bufsize);
+
 /**
  * fdt_move - move a device tree around in memory
  * @fdt: pointer to the device tree to move
@@ -695,6 +722,105 @@ static inline void *fdt_getprop_w(void *fdt, int nodeoffset,
 	return (void *)(uintptr_t)fdt_getprop(fdt, nodeoffset, name, lenp);
 }
 
+/**
+ * fdt_string_offset_namelen - find a name's offset in the strings block
+ * @fdt: pointer to the device tree blob
+ * @s: string to look for
+ * @len: number of characters of s to consider
+ *
+ * fdt_string_offset_namelen() resolves a property name, once, to the
+ * strings block offset used by the properties which have that name.
+ * The result can then be passed to fdt_getprop_by_stroff() and
+ * friends, which compare each property's name offset as an integer
+ * rather than comparing the strings.
+ *
+ * dtc and the libfdt write functions reuse the first place a name
+ * is stored in the strings block, which may be the tail of a longer
+ * string (e.g. "ranges" within "dma-ranges"), so that is the offset
+ * returned.  Later copies of the name as the tail of another string
+ * are never referred to and are ignored.  If the name is also stored
+ * again as a whole string, as other tools (and fdt_property(), when
+ * the shorter name is added first) can produce, properties may refer
+ * to either copy and the caller must fall back to
+ * fdt_getprop_namelen().
+ *
+ * returns:
+ *	the offset of the name within the strings block, on success
+ *	-FDT_ERR_NOTFOUND, no property in the tree has this name
+ *	-FDT_ERR_EXISTS, the name is stored in full more than once, so
+ *		must be looked up with fdt_getprop_namelen() instead
+ *	-FDT_ERR_BADSTATE, fdt is an unfinished sequential-write tree,
+ *		whose string offsets are negative
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION, standard meanings
+ */
+int fdt_string_offset_namelen(const void *fdt, const char *s, int len);
+
+/**
+ * fdt_string_offset - find a name's offset in the strings block
+ * @fdt: pointer to the device tree blob
+ * @s: NUL-terminated string to look for
+ *
+ * Identical to fdt_string_offset_namelen(), but for a NUL-terminated
+ * string.
+ */
+int fdt_string_offset(const void *fdt, const char *s);
+
+/**
+ * fdt_get_property_by_stroff - find a property by its name's offset
+ * @fdt: pointer to the device tree blob
+ * @nodeoffset: offset of the node whose property to find
+ * @stroffset: name offset, from fdt_string_offset()
+ * @lenp: pointer to an integer variable (will be overwritten) or NULL
+ *
+ * Identical to fdt_get_property(), but the property is identified by
+ * the strings block offset of its name.
+ */
+const struct fdt_property *fdt_get_property_by_stroff(const void *fdt,
+						      int nodeoffset,
+						      int stroffset,
+						      int *lenp);
+
+/**
+ * fdt_getprop_by_stroff - retrieve a property value by its name's offset
+ * @fdt: pointer to the device tree blob
+ * @nodeoffset: offset of the node whose property to find
+ * @stroffset: name offset, from fdt_string_offset()
+ * @lenp: pointer to an integer variable (will be overwritten) or NULL
+ *
+ * Identical to fdt_getprop(), but the property is identified by the
+ * strings block offset of its name.
+ */
+const void *fdt_getprop_by_stroff(const void *fdt, int nodeoffset,
+				  int stroffset, int *lenp);
+
+/**
+ * fdt_getprops_by_stroff - retrieve several property values at once
+ * @fdt: pointer to the device tree blob
+ * @nodeoffset: offset of the node whose properties to find
+ * @count: number of properties to look for
+ * @stroffsets: array of count name offsets, from fdt_string_offset()
+ * @vals: array of count pointers, filled in with the values found
+ * @lens: array of count integers, filled in with the lengths, or NULL
+ *
+ * fdt_getprops_by_stroff() retrieves the values of several properties
+ * of one node in a single pass over its properties.  For each
+ * property not present, vals[i] is set to NULL and lens[i] to
+ * -FDT_ERR_NOTFOUND.
+ *
+ * returns:
+ *	the number of properties found (>=0), on success
+ *	-FDT_ERR_BADOFFSET, nodeoffset did not point to FDT_BEGIN_NODE tag
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_getprops_by_stroff(const void *fdt, int nodeoffset, int count,
+			   const int *stroffsets, const void **vals,
+			   int *lens);
+
 /**
  * fdt_get_phandle - retrieve the phandle of a given node
  * @fdt: pointer to the device tree blob
@@ -1042,6 +1168,564 @@ const char *fdt_stringlist_get(const void *fdt, int nodeoffset,
 			       const char *property, int index,
 			       int *lenp);
 
+/**********************************************************************/
+/* Indexed read-only functions                                        */
+/**********************************************************************/
+
+/**
+ * fdt_index_size - determine the buffer size needed for a lookup index
+ * @fdt: pointer to the device tree blob
+ *
+ * fdt_index_size() scans the structure block once and returns the
+ * number of bytes which must be passed to fdt_index_build() to index
+ * the given tree.
+ *
+ * returns:
+ *	size of the index in bytes (>0), on success
+ *	-FDT_ERR_NOSPACE, the index would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_index_size(const void *fdt);
+
+/**
+ * fdt_index_build - build a read-only lookup index for a tree
+ * @fdt: pointer to the device tree blob
+ * @idx: pointer to a 32-bit aligned buffer to hold the index
+ * @idxsize: size of the buffer at idx
+ *
+ * fdt_index_build() records, for each node in the tree, its offset,
+ * depth, parent, first subnode, next sibling and the end of its
+ * subtree.  The resulting index can be passed to the fdt_index_*()
+ * functions below, which then answer in constant or logarithmic time
+ * queries that otherwise require a scan of the structure block.
+ *
+ * The index is only valid for as long as the tree is not modified
+ * (including by fdt_nop_node() and friends).  Rebuild it after any
+ * change.  The fdt_index_*() functions ignore an index which is
+ * recognisably stale (and a NULL idx), falling back to their scanning
+ * equivalents.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, idxsize is smaller than fdt_index_size(fdt)
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_index_build(const void *fdt, void *idx, int idxsize);
+
+/**
+ * fdt_index_subnode_offset_namelen - indexed fdt_subnode_offset_namelen()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @parentoffset: structure block offset of a node
+ * @name: name of the subnode to locate
+ * @namelen: number of characters of name to consider
+ *
+ * Identical to fdt_subnode_offset_namelen(), but only the direct
+ * subnodes of the parent are examined, rather than its whole subtree.
+ */
+int fdt_index_subnode_offset_namelen(const void *fdt, const void *idx,
+				     int parentoffset,
+				     const char *name, int namelen);
+
+/**
+ * fdt_index_subnode_offset - indexed fdt_subnode_offset()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @parentoffset: structure block offset of a node
+ * @name: name of the subnode to locate
+ *
+ * Identical to fdt_index_subnode_offset_namelen(), but for a
+ * NUL-terminated name.
+ */
+int fdt_index_subnode_offset(const void *fdt, const void *idx,
+			     int parentoffset, const char *name);
+
+/**
+ * fdt_index_path_offset_namelen - indexed fdt_path_offset_namelen()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @path: full path of the node to locate
+ * @namelen: number of characters of path to consider
+ *
+ * Identical to fdt_path_offset_namelen(), including alias handling.
+ */
+int fdt_index_path_offset_namelen(const void *fdt, const void *idx,
+				  const char *path, int namelen);
+
+/**
+ * fdt_index_path_offset - indexed fdt_path_offset()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @path: full path of the node to locate
+ *
+ * Identical to fdt_path_offset(), including alias handling.
+ */
+int fdt_index_path_offset(const void *fdt, const void *idx, const char *path);
+
+/**
+ * fdt_index_first_subnode - indexed fdt_first_subnode()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @offset: structure block offset of a node
+ *
+ * returns:
+ *	offset of the first subnode of the node at offset, on success
+ *	-FDT_ERR_NOTFOUND, if the node has no subnodes
+ *	-FDT_ERR_BADOFFSET, offset does not refer to a BEGIN_NODE tag
+ */
+int fdt_index_first_subnode(const void *fdt, const void *idx, int offset);
+
+/**
+ * fdt_index_next_subnode - indexed fdt_next_subnode()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @offset: structure block offset of the previous subnode
+ *
+ * returns:
+ *	offset of the next sibling of the node at offset, on success
+ *	-FDT_ERR_NOTFOUND, if there are no more subnodes
+ *	-FDT_ERR_BADOFFSET, offset does not refer to a BEGIN_NODE tag
+ */
+int fdt_index_next_subnode(const void *fdt, const void *idx, int offset);
+
+/**
+ * fdt_index_for_each_subnode - iterate over all subnodes of a parent
+ *
+ * As fdt_for_each_subnode(), but using fdt_index_first_subnode() and
+ * fdt_index_next_subnode().
+ */
+#define fdt_index_for_each_subnode(node, fdt, idx, parent)	\
+	for (node = fdt_index_first_subnode(fdt, idx, parent);	\
+	     node >= 0;						\
+	     node = fdt_index_next_subnode(fdt, idx, node))
+
+/**
+ * fdt_index_get_path - indexed fdt_get_path()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @nodeoffset: offset of the node whose path to find
+ * @buf: character buffer to contain the returned path (will be overwritten)
+ * @buflen: size of the character buffer at buf
+ *
+ * Identical to fdt_get_path(), except that the path is assembled by
+ * following parent links rather than by scanning from the start of
+ * the structure block.  Unlike fdt_get_path(), buf is left untouched
+ * if it is too small.
+ */
+int fdt_index_get_path(const void *fdt, const void *idx, int nodeoffset,
+		       char *buf, int buflen);
+
+/**
+ * fdt_index_supernode_atdepth_offset - indexed fdt_supernode_atdepth_offset()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @nodeoffset: offset of the node whose parent to find
+ * @supernodedepth: depth of the ancestor to find
+ * @nodedepth: pointer to an integer variable (will be overwritten) or NULL
+ *
+ * Identical to fdt_supernode_atdepth_offset().
+ */
+int fdt_index_supernode_atdepth_offset(const void *fdt, const void *idx,
+				       int nodeoffset, int supernodedepth,
+				       int *nodedepth);
+
+/**
+ * fdt_index_node_depth - indexed fdt_node_depth()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @nodeoffset: offset of the node whose depth to find
+ *
+ * Identical to fdt_node_depth().
+ */
+int fdt_index_node_depth(const void *fdt, const void *idx, int nodeoffset);
+
+/**
+ * fdt_index_parent_offset - indexed fdt_parent_offset()
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @nodeoffset: offset of the node whose parent to find
+ *
+ * Identical to fdt_parent_offset().
+ */
+int fdt_index_parent_offset(const void *fdt, const void *idx, int nodeoffset);
+
+/**
+ * fdt_index_node_end_offset - find the end of a node's subtree
+ * @fdt: pointer to the device tree blob
+ * @idx: index built by fdt_index_build(), or NULL
+ * @nodeoffset: offset of a node
+ *
+ * returns:
+ *	structure block offset just past the END_NODE tag matching the
+ *		node at nodeoffset (>= 0), on success
+ *	-FDT_ERR_BADOFFSET, nodeoffset does not refer to a BEGIN_NODE tag
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE, standard meanings
+ */
+int fdt_index_node_end_offset(const void *fdt, const void *idx,
+			      int nodeoffset);
+
+/**
+ * fdt_phandle_map_size - determine the buffer size needed for a phandle map
+ * @fdt: pointer to the device tree blob
+ * @extra: number of additional phandles the map should have room for
+ *
+ * fdt_phandle_map_size() scans the structure block once and returns
+ * the number of bytes which must be passed to fdt_phandle_map_build()
+ * to map every phandle in the tree, plus @extra more added later with
+ * fdt_phandle_map_set().
+ *
+ * returns:
+ *	size of the map in bytes (>0), on success
+ *	-FDT_ERR_BADVALUE, extra is negative
+ *	-FDT_ERR_NOSPACE, the map would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_phandle_map_size(const void *fdt, int extra);
+
+/**
+ * fdt_phandle_map_build - build a phandle to node offset map
+ * @fdt: pointer to the device tree blob
+ * @map: pointer to a 32-bit aligned buffer to hold the map
+ * @mapsize: size of the buffer at map
+ *
+ * fdt_phandle_map_build() records the offset of every node with a
+ * valid phandle (or linux,phandle) property in a hash table in a
+ * single pass over the structure block, and notes the largest
+ * phandle seen.  fdt_phandle_map_node_offset() and
+ * fdt_phandle_map_get_max_phandle() then answer in constant time.
+ *
+ * Unlike the lookup index, the map can be kept up to date while the
+ * tree is edited, without rescanning it:
+ *	- after changing a node's properties or name, or adding a
+ *	  subnode to it, call fdt_phandle_map_shift() with the node's
+ *	  offset and the change in fdt_size_dt_struct()
+ *	- after fdt_del_node(), call fdt_phandle_map_del_node() with
+ *	  the node's old offset and the length of its subtree
+ *	- after giving a node a phandle, call fdt_phandle_map_set()
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, mapsize is too small for the phandles in the tree
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_phandle_map_build(const void *fdt, void *map, int mapsize);
+
+/**
+ * fdt_phandle_map_node_offset - mapped fdt_node_offset_by_phandle()
+ * @fdt: pointer to the device tree blob
+ * @map: map built by fdt_phandle_map_build(), or NULL
+ * @phandle: phandle value
+ *
+ * Identical to fdt_node_offset_by_phandle(), but answered from the
+ * map.  If map is NULL, or the node it records turns out not to carry
+ * the requested phandle, this falls back to scanning the tree.
+ */
+int fdt_phandle_map_node_offset(const void *fdt, const void *map,
+				uint32_t phandle);
+
+/**
+ * fdt_phandle_map_get_max_phandle - mapped fdt_get_max_phandle()
+ * @fdt: pointer to the device tree blob
+ * @map: map built by fdt_phandle_map_build(), or NULL
+ *
+ * Identical to fdt_get_max_phandle(), but answered from the map.
+ */
+uint32_t fdt_phandle_map_get_max_phandle(const void *fdt, const void *map);
+
+/**
+ * fdt_phandle_map_set - record a node's phandle in a phandle map
+ * @map: map built by fdt_phandle_map_build()
+ * @phandle: phandle value
+ * @nodeoffset: structure block offset of the node with that phandle
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, the map is full (see fdt_phandle_map_size())
+ *	-FDT_ERR_BADPHANDLE, phandle is 0 or -1
+ *	-FDT_ERR_BADOFFSET, nodeoffset is negative
+ *	-FDT_ERR_BADVALUE, map is not a phandle map
+ */
+int fdt_phandle_map_set(void *map, uint32_t phandle, int nodeoffset);
+
+/**
+ * fdt_phandle_map_shift - adjust a phandle map after a node changed size
+ * @map: map built by fdt_phandle_map_build()
+ * @nodeoffset: structure block offset of the node which was changed
+ * @delta: change in size of the structure block
+ *
+ * Moves every node recorded after nodeoffset by delta bytes.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_BADVALUE, map is not a phandle map
+ */
+int fdt_phandle_map_shift(void *map, int nodeoffset, int delta);
+
+/**
+ * fdt_phandle_map_del_node - adjust a phandle map after a node was deleted
+ * @map: map built by fdt_phandle_map_build()
+ * @nodeoffset: structure block offset the node had
+ * @len: length of the deleted subtree in the structure block
+ *
+ * Forgets every node recorded within the deleted subtree and moves
+ * every node after it down by len bytes.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_BADOFFSET, nodeoffset or len is negative
+ *	-FDT_ERR_BADVALUE, map is not a phandle map
+ */
+int fdt_phandle_map_del_node(void *map, int nodeoffset, int len);
+
+/**
+ * struct fdt_compatible_match - one result of fdt_match_compatible()
+ * @nodeoffset: structure block offset of the matching node
+ * @entry: index in the match table of the matching string
+ * @priority: position of the string in the node's compatible list,
+ *	0 being the most specific
+ */
+struct fdt_compatible_match {
+	int nodeoffset;
+	int entry;
+	int priority;
+};
+
+/**
+ * fdt_match_compatible_size - determine the workspace size for matching
+ * @tablelen: number of entries in the match table
+ *
+ * returns:
+ *	number of bytes of workspace fdt_match_compatible() needs (>= 0),
+ *		on success
+ *	-FDT_ERR_NOSPACE, the workspace would not fit in an int
+ */
+int fdt_match_compatible_size(int tablelen);
+
+/**
+ * fdt_match_compatible - match a whole table of compatible strings
+ * @fdt: pointer to the device tree blob
+ * @table: array of compatible strings to look for (NULL entries are
+ *	skipped)
+ * @tablelen: number of entries in table
+ * @ws: pointer to a 32-bit aligned buffer to use as workspace
+ * @wssize: size of the buffer at ws
+ * @matches: array to receive the matches, or NULL
+ * @maxmatches: number of entries available at matches
+ *
+ * fdt_match_compatible() finds every node whose compatible property
+ * lists any of the strings in table, in a single pass over the
+ * structure block, rather than the pass per string (and per node)
+ * that repeated fdt_node_offset_by_compatible() calls need.  The
+ * table is first sorted into the workspace, so each compatible string
+ * in the tree is looked up by bisection.
+ *
+ * Matches are reported in tree order and, within a node, in order of
+ * priority then table entry; a node matching several entries is
+ * reported once for each.  If there are more than maxmatches matches,
+ * only the first maxmatches are stored, but all are counted, so a
+ * caller can size its array with a first call with NULL matches.
+ *
+ * returns:
+ *	the total number of matches (>= 0), on success
+ *	-FDT_ERR_NOSPACE, wssize is smaller than
+ *		fdt_match_compatible_size(), or the number of matches
+ *		would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_match_compatible(const void *fdt, const char *const *table,
+			 int tablelen, void *ws, int wssize,
+			 struct fdt_compatible_match *matches,
+			 int maxmatches);
+
+/**
+ * fdt_compat_index_size - determine the buffer size for a compatible index
+ * @fdt: pointer to the device tree blob
+ *
+ * returns:
+ *	number of bytes fdt_compat_index_build() needs (>0), on success
+ *	-FDT_ERR_NOSPACE, the index would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_compat_index_size(const void *fdt);
+
+/**
+ * fdt_compat_index_build - build a compatible string to node index
+ * @fdt: pointer to the device tree blob
+ * @cidx: pointer to a 32-bit aligned buffer to hold the index
+ * @cidxsize: size of the buffer at cidx
+ *
+ * fdt_compat_index_build() records every string of every compatible
+ * property in the tree, sorted, so that
+ * fdt_compat_index_node_offset() can find the nodes listing a given
+ * string in logarithmic time.  As with fdt_index_build(), the index
+ * must be rebuilt whenever the tree is modified.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, cidxsize is smaller than fdt_compat_index_size()
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_compat_index_build(const void *fdt, void *cidx, int cidxsize);
+
+/**
+ * fdt_compat_index_node_offset - indexed fdt_node_offset_by_compatible()
+ * @fdt: pointer to the device tree blob
+ * @cidx: index built by fdt_compat_index_build(), or NULL
+ * @startoffset: only find nodes after this offset
+ * @compatible: 'compatible' string to match against
+ *
+ * Identical to fdt_node_offset_by_compatible(), including the idiom
+ * for iterating over all matching nodes.  A NULL or recognisably
+ * stale index falls back to fdt_node_offset_by_compatible().
+ */
+int fdt_compat_index_node_offset(const void *fdt, const void *cidx,
+				 int startoffset, const char *compatible);
+
+/**********************************************************************/
+/* Trusted-blob functions                                             */
+/**********************************************************************/
+
+/*
+ * The functions in this section perform no bounds or consistency
+ * checking of the blob at all: they must only be used on a tree
+ * which has passed fdt_check_full() and has not been modified since,
+ * and only with offsets obtained from that tree.  On anything else
+ * their behaviour is undefined.  In exchange they are considerably
+ * cheaper than their checked equivalents on large trees.
+ */
+
+/**
+ * fdt_next_tag_trusted - unchecked fdt_next_tag()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @offset: offset of a tag in the structure block
+ * @nextoffset: set to the offset of the following tag
+ *
+ * returns:
+ *	the tag at offset
+ */
+uint32_t fdt_next_tag_trusted(const void *fdt, int offset, int *nextoffset);
+
+/**
+ * fdt_next_node_trusted - unchecked fdt_next_node()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @offset: offset of a node, or -1 to start at the root
+ * @depth: depth counter, updated as for fdt_next_node(), or NULL
+ *
+ * returns:
+ *	offset of the next node, or a negative value as for
+ *	fdt_next_node() at the end of the tree or of the subtree
+ */
+int fdt_next_node_trusted(const void *fdt, int offset, int *depth);
+
+/**
+ * fdt_first_subnode_trusted - unchecked fdt_first_subnode()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @offset: offset of a node
+ *
+ * returns:
+ *	offset of the first subnode, or -FDT_ERR_NOTFOUND if there is none
+ */
+int fdt_first_subnode_trusted(const void *fdt, int offset);
+
+/**
+ * fdt_next_subnode_trusted - unchecked fdt_next_subnode()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @offset: offset of the previous subnode
+ *
+ * returns:
+ *	offset of the next subnode, or -FDT_ERR_NOTFOUND if there are no
+ *	more subnodes
+ */
+int fdt_next_subnode_trusted(const void *fdt, int offset);
+
+/**
+ * fdt_subnode_offset_namelen_trusted - unchecked fdt_subnode_offset_namelen()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @parentoffset: offset of a node
+ * @name: name of the subnode to locate
+ * @namelen: number of characters of name to consider
+ *
+ * As fdt_subnode_offset_namelen(), but only direct subnodes are
+ * visited.
+ *
+ * returns:
+ *	offset of the subnode, or -FDT_ERR_NOTFOUND if there is none
+ */
+int fdt_subnode_offset_namelen_trusted(const void *fdt, int parentoffset,
+				       const char *name, int namelen);
+
+/**
+ * fdt_subnode_offset_trusted - unchecked fdt_subnode_offset()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @parentoffset: offset of a node
+ * @name: name of the subnode to locate
+ *
+ * returns:
+ *	offset of the subnode, or -FDT_ERR_NOTFOUND if there is none
+ */
+int fdt_subnode_offset_trusted(const void *fdt, int parentoffset,
+			       const char *name);
+
+/**
+ * fdt_getprop_namelen_trusted - unchecked fdt_getprop_namelen()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @nodeoffset: offset of a node
+ * @name: name of the property to find
+ * @namelen: number of characters of name to consider
+ * @lenp: pointer to an integer variable (will be overwritten) or NULL
+ *
+ * returns:
+ *	pointer to the property's value, with *lenp set to its length,
+ *	or NULL with *lenp set to -FDT_ERR_NOTFOUND
+ */
+const void *fdt_getprop_namelen_trusted(const void *fdt, int nodeoffset,
+					const char *name, int namelen,
+					int *lenp);
+
+/**
+ * fdt_getprop_trusted - unchecked fdt_getprop()
+ * @fdt: pointer to a device tree blob accepted by fdt_check_full()
+ * @nodeoffset: offset of a node
+ * @name: name of the property to find
+ * @lenp: pointer to an integer variable (will be overwritten) or NULL
+ *
+ * returns:
+ *	as fdt_getprop_namelen_trusted()
+ */
+const void *fdt_getprop_trusted(const void *fdt, int nodeoffset,
+				const char *name, int *lenp);
+
 /**********************************************************************/
 /* Read-only functions (addressing related)                           */
 /**********************************************************************/
@@ -1890,6 +2574,344 @@ int fdt_del_node(void *fdt, int nodeoffset);
  */
 int fdt_overlay_apply(void *fdt, void *fdto);
 
+/**
+ * fdt_overlay_index_size - determine the buffer size for an overlay index
+ * @fdt: pointer to the base device tree blob
+ * @fdto: pointer to the device tree overlay blob
+ *
+ * fdt_overlay_index_size() returns the number of bytes which must be
+ * passed to fdt_overlay_apply_indexed() or fdt_overlay_apply_into()
+ * to apply @fdto to @fdt.
+ *
+ * returns:
+ *	size of the index in bytes (>0), on success
+ *	-FDT_ERR_NOSPACE, the index would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_overlay_index_size(const void *fdt, const void *fdto);
+
+/**
+ * fdt_overlay_apply_indexed - Applies a DT overlay using lookup indexes
+ * @fdt: pointer to the base device tree blob
+ * @fdto: pointer to the device tree overlay blob
+ * @idx: pointer to a 32-bit aligned buffer to hold the index
+ * @idxsize: size of the buffer at idx
+ *
+ * fdt_overlay_apply_indexed() applies the overlay as
+ * fdt_overlay_apply() does, but first indexes both trees and sorts
+ * the base tree's symbols by label in the buffer at @idx.  Each
+ * label named in the overlay's __fixups__ node is then resolved once,
+ * and each fixup costs a bisection and an index lookup instead of
+ * scans of /__symbols__ and of both trees.
+ *
+ * If @idxsize is smaller than fdt_overlay_index_size() returns,
+ * neither tree is modified.  Otherwise, as with fdt_overlay_apply(),
+ * expect the base device tree to be modified even if the function
+ * returns an error.  The index is of no use once the function has
+ * returned.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, idxsize is too small, or there's not enough
+ *		space in the base device tree
+ *	any other error returned by fdt_overlay_apply()
+ */
+int fdt_overlay_apply_indexed(void *fdt, void *fdto, void *idx, int idxsize);
+
+/**
+ * fdt_overlay_apply_into - Writes out a DT with an overlay applied
+ * @fdt: pointer to the base device tree blob
+ * @fdto: pointer to the device tree overlay blob
+ * @idx: pointer to a 32-bit aligned buffer to hold the index
+ * @idxsize: size of the buffer at idx
+ * @buf: pointer to the buffer to hold the merged device tree
+ * @bufsize: size of the buffer at buf
+ *
+ * fdt_overlay_apply_into() resolves the overlay as
+ * fdt_overlay_apply_indexed() does, but rather than inserting the
+ * overlay's nodes and properties into @fdt one at a time, it writes
+ * the merged tree into @buf in a single walk of @fdt, which is left
+ * untouched.  The merged tree is packed, and @buf must not overlap
+ * @fdt.
+ *
+ * The merged tree holds the same nodes and properties as
+ * fdt_overlay_apply() gives, but the nodes and properties the overlay
+ * adds follow the existing ones in the order they appear in the
+ * overlay, as dtc lays them out, instead of in reverse.  If a fragment
+ * targets a node added by an earlier fragment, the overlay is instead
+ * applied in place to a copy of @fdt in @buf, in the same order as
+ * fdt_overlay_apply().
+ *
+ * Unlike fdt_overlay_apply(), fdt_overlay_apply_into() leaves the
+ * overlay untouched, so it may be applied straight from read-only
+ * memory, such as a mapped file or flash.  The changes to the
+ * overlay's phandles and references are recorded in the index
+ * instead, and made to the copies of its property values written to
+ * @buf.  On failure the magic of @buf is erased.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, idxsize or bufsize is too small
+ *	any other error returned by fdt_overlay_apply()
+ */
+int fdt_overlay_apply_into(const void *fdt, const void *fdto,
+			   void *idx, int idxsize, void *buf, int bufsize);
+
+/**
+ * fdt_overlay_apply_many_size - determine the workspace size for a batch
+ * @fdt: pointer to the base device tree blob
+ * @fdtos: pointers to the device tree overlay blobs
+ * @count: number of overlays
+ *
+ * fdt_overlay_apply_many_size() returns the number of bytes of
+ * workspace which must be passed to fdt_overlay_apply_many() to apply
+ * the overlays at @fdtos to @fdt.
+ *
+ * returns:
+ *	size of the workspace in bytes (>0), on success
+ *	-FDT_ERR_NOSPACE, the workspace would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_overlay_apply_many_size(const void *fdt, const void *const fdtos[],
+				int count);
+
+/**
+ * fdt_overlay_merged_size - bound the size of a batch's merged trees
+ * @fdt: pointer to the base device tree blob
+ * @fdtos: pointers to the device tree overlay blobs
+ * @count: number of overlays
+ *
+ * fdt_overlay_merged_size() returns a size which neither the final
+ * tree fdt_overlay_apply_many() writes nor any of those before it can
+ * exceed: the size of @fdt and of each overlay, plus the growth of the
+ * paths of the overlays' symbols, each of which may grow by as much as
+ * the longest path of the tree its overlay is applied to.
+ *
+ * returns:
+ *	size of the tree in bytes (>0), on success
+ *	-FDT_ERR_NOSPACE, the size would not fit in an int
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_overlay_merged_size(const void *fdt, const void *const fdtos[],
+			    int count);
+
+/**
+ * fdt_overlay_apply_many - Applies a sequence of DT overlays
+ * @fdt: pointer to the base device tree blob
+ * @fdtos: pointers to the device tree overlay blobs
+ * @count: number of overlays
+ * @ws: pointer to a 64-bit aligned buffer to use as workspace
+ * @wssize: size of the buffer at ws
+ * @buf: pointer to the buffer to hold the merged device tree
+ * @bufsize: size of the buffer at buf
+ * @failedp: pointer to an integer to hold the index of the overlay
+ *	which could not be applied, or -1 if the failure was not down
+ *	to any one overlay (may be NULL)
+ *
+ * fdt_overlay_apply_many() applies the overlays at @fdtos to @fdt in
+ * order, as a sequence of calls to fdt_overlay_apply_into() would,
+ * and leaves the packed result in @buf.  @fdt is left untouched, and
+ * neither it nor the overlays may overlap @ws or @buf.
+ *
+ * The base tree's lookup index and sorted symbols are built once.
+ * Each merged tree's index is then written as the tree is, the symbol
+ * table is brought up to date with the symbols each overlay adds, and
+ * the highest phandle is carried from one overlay to the next, so no
+ * merged tree needs to be scanned again before applying the next
+ * overlay.  The merged trees alternate between @buf and the end of the
+ * workspace.
+ *
+ * A @bufsize of fdt_overlay_merged_size() is always enough.
+ *
+ * As with fdt_overlay_apply_into(), the overlays are left untouched.
+ * On failure the magic of @buf is erased.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, wssize or bufsize is too small
+ *	any other error returned by fdt_overlay_apply()
+ */
+int fdt_overlay_apply_many(const void *fdt, const void *const fdtos[],
+			   int count, void *ws, int wssize, void *buf, int bufsize,
+			   int *failedp);
+
+/**********************************************************************/
+/* Transactional read-write functions                                 */
+/**********************************************************************/
+
+/*
+ * Each fdt_setprop(), fdt_add_subnode() and similar call moves the
+ * whole tail of the blob, so many edits to a large tree take time
+ * proportional to their number times the size of the tree.  These
+ * functions instead record the edits in a journal held in a caller
+ * supplied buffer, leaving the tree untouched, then apply them all at
+ * once while rewriting the tree into a new buffer.
+ *
+ * While a transaction is open the tree is unmodified, so every offset
+ * into it remains valid and all reads see the tree as it was before
+ * the transaction.  Nodes added by the transaction are identified by
+ * handles, which may be passed to the fdt_txn_*() functions in place
+ * of node offsets but are not offsets into the tree.  Edits to a node
+ * deleted within the transaction, or to its descendants, are
+ * discarded.
+ *
+ * The committed tree is the one the same sequence of fdt_setprop(),
+ * fdt_delprop(), fdt_add_subnode() and fdt_del_node() calls would
+ * have produced, although its strings block may be laid out
+ * differently.
+ */
+
+/**
+ * fdt_txn_init - open an edit transaction on a tree
+ * @fdt: pointer to the device tree blob to edit
+ * @txn: pointer to a 32-bit aligned buffer to hold the journal
+ * @txnsize: size of the buffer at txn
+ *
+ * The journal holds a fixed size entry per edit, plus a copy of each
+ * name and property value given, so the caller's copies need not be
+ * kept.  A small part of it, proportional to txnsize, is set aside
+ * to index the entries, so that checking each edit against the ones
+ * before it takes constant time.  The tree must not be modified while
+ * the transaction is open.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, txnsize is too small for even an empty journal
+ *	-FDT_ERR_BADVERSION, fdt is older than version 17
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADSTATE, standard meanings
+ */
+int fdt_txn_init(const void *fdt, void *txn, int txnsize);
+
+/**
+ * fdt_txn_rollback - discard every edit recorded in a transaction
+ * @txn: journal set up by fdt_txn_init()
+ *
+ * The transaction stays open, with no edits recorded.  Handles
+ * returned by fdt_txn_add_subnode() become invalid.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_BADVALUE, txn is not an open transaction
+ */
+int fdt_txn_rollback(void *txn);
+
+/**
+ * fdt_txn_setprop - record the creation or change of a property
+ * @fdt: pointer to the device tree blob
+ * @txn: journal set up by fdt_txn_init() for fdt
+ * @nodeoffset: offset, or handle, of the node whose property to set
+ * @name: name of the property
+ * @val: pointer to the new value
+ * @len: length of the value
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, the journal is full
+ *	-FDT_ERR_BADVALUE, txn is not an open transaction on fdt
+ *	-FDT_ERR_BADOFFSET, nodeoffset is neither a node nor a handle
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE, standard meanings
+ */
+int fdt_txn_setprop(const void *fdt, void *txn, int nodeoffset,
+		    const char *name, const void *val, int len);
+
+/**
+ * fdt_txn_delprop - record the deletion of a property
+ * @fdt: pointer to the device tree blob
+ * @txn: journal set up by fdt_txn_init() for fdt
+ * @nodeoffset: offset, or handle, of the node whose property to delete
+ * @name: name of the property
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOTFOUND, the node has no such property, taking into
+ *		account the edits already recorded
+ *	-FDT_ERR_NOSPACE,
+ *	-FDT_ERR_BADVALUE,
+ *	-FDT_ERR_BADOFFSET, as for fdt_txn_setprop()
+ */
+int fdt_txn_delprop(const void *fdt, void *txn, int nodeoffset,
+		    const char *name);
+
+/**
+ * fdt_txn_add_subnode - record the creation of a subnode
+ * @fdt: pointer to the device tree blob
+ * @txn: journal set up by fdt_txn_init() for fdt
+ * @parentoffset: offset, or handle, of the parent node
+ * @name: name of the new subnode
+ *
+ * returns:
+ *	a handle for the new node (>=0), on success
+ *	-FDT_ERR_EXISTS, the parent already has a subnode of this name,
+ *		taking into account the edits already recorded
+ *	-FDT_ERR_NOSPACE,
+ *	-FDT_ERR_BADVALUE,
+ *	-FDT_ERR_BADOFFSET, as for fdt_txn_setprop()
+ */
+int fdt_txn_add_subnode(const void *fdt, void *txn, int parentoffset,
+			const char *name);
+
+/**
+ * fdt_txn_del_node - record the deletion of a node and its subtree
+ * @fdt: pointer to the device tree blob
+ * @txn: journal set up by fdt_txn_init() for fdt
+ * @nodeoffset: offset, or handle, of the node to delete
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOTFOUND, the node has already been deleted
+ *	-FDT_ERR_NOSPACE,
+ *	-FDT_ERR_BADVALUE,
+ *	-FDT_ERR_BADOFFSET, as for fdt_txn_setprop()
+ */
+int fdt_txn_del_node(const void *fdt, void *txn, int nodeoffset);
+
+/**
+ * fdt_txn_commit - apply a transaction's edits
+ * @fdt: pointer to the device tree blob
+ * @txn: journal set up by fdt_txn_init() for fdt
+ * @buf: buffer to hold the edited tree, which must not overlap fdt
+ * @bufsize: size of the buffer at buf
+ *
+ * fdt_txn_commit() rewrites the tree into buf with all the recorded
+ * edits applied, in a single pass with the sequential-write
+ * functions.  The strings block is copied whole, and only names the
+ * transaction introduces are looked up in it, once each, so the cost
+ * is roughly that of copying the tree and reading the journal.  The
+ * result is a complete, packed tree; use fdt_open_into() to give it
+ * room for further edits.
+ *
+ * On success the transaction is closed, and fdt_txn_init() must be
+ * called again before the journal can be reused.  On failure the
+ * tree and the transaction are unchanged, so the commit may be
+ * retried with a larger buffer, or the transaction abandoned.
+ *
+ * returns:
+ *	0, on success
+ *	-FDT_ERR_NOSPACE, bufsize is insufficient for the edited tree
+ *	-FDT_ERR_BADVALUE, txn is not an open transaction on fdt
+ *	-FDT_ERR_BADMAGIC,
+ *	-FDT_ERR_BADVERSION,
+ *	-FDT_ERR_BADSTATE,
+ *	-FDT_ERR_BADSTRUCTURE,
+ *	-FDT_ERR_TRUNCATED, standard meanings
+ */
+int fdt_txn_commit(const void *fdt, void *txn, void *buf, int bufsize);
+
 /**********************************************************************/
 /* Debugging / informational functions                                */
 /**********************************************************************/
@@ -66,6 +66,7 @@ int _fdt_check_node_offset(const void *fdt, int offset);
 int _fdt_check_prop_offset(const void *fdt, int offset);
 const char *_fdt_find_string(const char *strtab, int tabsize, const char *s);
 int _fdt_node_end_offset(void *fdt, int nodeoffset);
+int _fdt_nodename_eq(const void *fdt, int offset, const char *s, int len);
 
 static inline const void *_fdt_offset_ptr(const void *fdt, int offset)
 {
@@ -92,4 +93,200 @@ static inline struct fdt_reserve_entry *_fdt_mem_rsv_w(void *fdt, int n)
 
 #define FDT_SW_MAGIC		(~FDT_MAGIC)
 
+/*
+ * Seeds the strings block of a tree under construction with a copy of
+ * src's, after which properties named by src's strings can be added
+ * by their offsets in src without searching the strings block.  Other
+ * names are added with _fdt_sw_add_string(), which only searches the
+ * copy (the caller must not add the same name twice), and properties
+ * then named by the offset it gives with _fdt_sw_property_at().
+ */
+int _fdt_sw_copy_strings(void *fdt, const void *src);
+int _fdt_sw_property_copied(void *fdt, const void *src, int stroffset,
+			    int len, void **valp);
+int _fdt_sw_add_string(void *fdt, const void *src, const char *s,
+		       int *nameoffp);
+int _fdt_sw_property_at(void *fdt, int nameoff, int len, void **valp);
+
+/*
+ * Read-only lookup index (see fdt_index_build()).  The index lives in
+ * a caller supplied buffer and is stored in native byte order: it is
+ * never written out, so there is no reason to pay for conversions.
+ */
+#define FDT_INDEX_MAGIC		0x1d0dfd70
+
+struct fdt_index_header {
+	uint32_t magic;
+	uint32_t size_dt_struct;	/* of the blob the index describes */
+	int32_t num_nodes;
+	int32_t reserved;
+};
+
+struct fdt_index_node {
+	int32_t offset;		/* structure offset of the BEGIN_NODE tag */
+	int32_t end;		/* structure offset just past the END_NODE */
+	int32_t depth;
+	int32_t parent;		/* entry numbers, or -1 if there is none */
+	int32_t first_child;
+	int32_t next_sibling;
+};
+
+static inline const struct fdt_index_node *_fdt_index_nodes(const void *idx)
+{
+	return (const struct fdt_index_node *)
+		((const struct fdt_index_header *)idx + 1);
+}
+
+/*
+ * Compatible index (see fdt_compat_index_build()).  Shares the lookup
+ * index header; num_nodes counts entries rather than nodes.
+ */
+#define FDT_COMPAT_INDEX_MAGIC	0x1d0dfd72
+
+struct fdt_compat_index_entry {
+	int32_t stroffset;	/* structure offset of a compatible string */
+	int32_t nodeoffset;	/* node whose compatible property holds it */
+};
+
+/*
+ * Phandle map (see fdt_phandle_map_build()).  An open addressed hash
+ * table with linear probing, keyed on phandle; a zero phandle marks
+ * an empty slot.  Also native byte order.
+ */
+#define FDT_PHANDLE_MAP_MAGIC	0x1d0dfd71
+
+struct fdt_phandle_map_header {
+	uint32_t magic;
+	uint32_t mask;		/* number of slots - 1 */
+	uint32_t count;
+	uint32_t max_phandle;
+};
+
+struct fdt_phandle_map_slot {
+	uint32_t phandle;
+	int32_t offset;
+};
+
+/*
+ * Edit transaction journal (see fdt_txn_init()).  The header is
+ * followed by three hash tables, each bucket holding the sequence
+ * number of the most recent entry hashed to it (or -1): by target and
+ * name, by target alone, and (setprops only) by name alone.  Each
+ * entry links to the previous one in its bucket of each.  Fixed size
+ * entries grow upwards after the hash tables, the names and values
+ * they refer to are copied downwards from the end of the buffer.
+ * Native byte order.
+ */
+#define FDT_TXN_MAGIC		0x1d0dfd73
+
+#define FDT_TXN_SETPROP		1
+#define FDT_TXN_DELPROP		2
+#define FDT_TXN_ADD_SUBNODE	3
+#define FDT_TXN_DEL_NODE	4
+
+/* The property already exists in the tree, and is changed in place */
+#define FDT_TXN_REPLACES	0x1
+
+struct fdt_txn_header {
+	uint32_t magic;
+	uint32_t totalsize;		/* of the blob being edited */
+	uint32_t size_dt_struct;
+	int32_t count;			/* entries */
+	int32_t data;			/* offset of lowest copied data */
+	int32_t size;			/* of the whole journal */
+	int32_t nbuckets;		/* in each hash table, a power of 2 */
+};
+
+struct fdt_txn_entry {
+	int32_t target;		/* node offset, or handle of an added node */
+	int32_t seq;		/* order in which the edit was made */
+	int32_t type;		/* FDT_TXN_* */
+	int32_t name;		/* journal offset of the NUL-terminated name */
+	int32_t namelen;
+	int32_t val;		/* journal offset of the property value */
+	int32_t len;
+	int32_t next;		/* previous entry in the same bucket, or -1 */
+	int32_t tnext;		/* previous entry for the same target, or -1 */
+	/*
+	 * Setprops only: the setprop which created the property, since
+	 * it was last deleted.  That one also records the most recent
+	 * setprop of the property (or -1 once it is deleted again).
+	 */
+	int32_t first;
+	int32_t last;
+	int32_t flags;		/* FDT_TXN_REPLACES */
+	/*
+	 * Setprops only: the previous setprop in the same bucket of the
+	 * third hash table, by name alone, and the earliest setprop of
+	 * the same name, on which the commit caches its string offset.
+	 */
+	int32_t nnext;
+	int32_t strent;
+	int32_t stroff;
+};
+
+static inline int32_t *_fdt_txn_buckets(void *txn)
+{
+	return (int32_t *)((struct fdt_txn_header *)txn + 1);
+}
+
+static inline struct fdt_txn_entry *_fdt_txn_entries(void *txn)
+{
+	struct fdt_txn_header *hdr = txn;
+
+	return (struct fdt_txn_entry *)(_fdt_txn_buckets(txn)
+					+ 3 * hdr->nbuckets);
+}
+
+/*
+ * Overlay index (see fdt_overlay_apply_indexed()).  Lookup indexes of
+ * the base tree and the overlay, then the base tree's symbols sorted
+ * by name, then room for the overlay's fragments sorted by target, for
+ * the lists of overlay nodes fdt_overlay_apply_into() merges into each
+ * node it writes, and for the changes to the overlay's property values
+ * it makes as it copies them, sorted by property, so the overlay itself
+ * is left untouched.  fdt_overlay_apply_many() adds room for a second
+ * lookup index of the base tree, which receives the index of each
+ * merged tree as it is written.  The parts are located by byte offsets
+ * from the header.  Native byte order.
+ */
+#define FDT_OVERLAY_INDEX_MAGIC	0x1d0dfd74
+
+struct fdt_overlay_index_header {
+	uint32_t magic;
+	int32_t fdt_index;	/* of the base tree's lookup index */
+	int32_t next_fdt_index;	/* of the merged tree's lookup index, or 0 */
+	int32_t fdt_index_size;	/* bytes reserved for each of those */
+	int32_t fdto_index;	/* of the overlay's lookup index */
+	int32_t symbols;	/* of the symbol table */
+	int32_t num_symbols;
+	int32_t max_symbols;
+	int32_t fragments;	/* of the fragment table */
+	int32_t num_fragments;
+	int32_t max_fragments;
+	int32_t stack;		/* of the merge lists */
+	int32_t stack_size;	/* in entries */
+	int32_t patches;	/* of the patch table */
+	int32_t num_patches;	/* or -1 to patch the overlay in place */
+	int32_t max_patches;
+};
+
+struct fdt_overlay_symbol {
+	int32_t nameoff;	/* strings block offset of the label */
+	int32_t prop;		/* structure offset of the __symbols__ property */
+	uint32_t phandle;	/* of the labelled node, or 0 if not yet known */
+};
+
+struct fdt_overlay_fragment {
+	int32_t target;		/* node offset in the base tree */
+	int32_t overlay;	/* offset of the __overlay__ node */
+	int32_t fragment;	/* offset of the fragment node */
+};
+
+struct fdt_overlay_patch {
+	int32_t prop;		/* structure offset of the overlay property */
+	int32_t offset;		/* of the phandle within its value */
+	uint32_t phandle;	/* to store there */
+};
+
 #endif /* _LIBFDT_INTERNAL_H */
@@ -18,8 +18,99 @@
  *                                                                   USA
  */
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
+
 #include "dtc.h"
 
+/*
+ * Tree allocation
+ *
+ * The objects making up a tree (nodes, properties, labels, markers,
+ * reserve entries and their names) are allocated from an arena, which
+ * build_dt_info() hands to the tree's dt_info, so that free_dt_info()
+ * can release the whole tree at once.  Allocations go to the arena of
+ * the tree most recently started with new_tree_arena().
+ */
+
+static struct arena *tree_arena;
+
+void new_tree_arena(void)
+{
+	tree_arena = xmalloc(sizeof(*tree_arena));
+	memset(tree_arena, 0, sizeof(*tree_arena));
+}
+
+void *tree_alloc(size_t len)
+{
+	if (!tree_arena)
+		new_tree_arena();
+
+	return arena_alloc(tree_arena, len);
+}
+
+char *tree_strdup(const char *s)
+{
+	if (!tree_arena)
+		new_tree_arena();
+
+	return arena_strdup(tree_arena, s);
+}
+
+/*
+ * Files which the tree's property values refer to in place (see
+ * data_map_file()) are mapped for as long as the tree, and unmapped by
+ * free_dt_info().
+ */
+struct tree_mapping {
+	void *addr;
+	size_t len;
+	struct tree_mapping *next;
+};
+
+static struct tree_mapping *tree_mappings;
+
+/*
+ * Maps up to maxlen bytes of f from its current position, setting *len
+ * to the number mapped.  Returns NULL if f can't be mapped, e.g. because
+ * it is a pipe, or if there is nothing left to read.
+ */
+char *tree_map_file(FILE *f, size_t maxlen, size_t *len)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	struct tree_mapping *m;
+	struct stat st;
+	off_t offset, start;
+	void *addr;
+
+	offset = ftello(f);
+	if ((offset < 0) || fstat(fileno(f), &st) || !S_ISREG(st.st_mode)
+	    || (offset >= st.st_size))
+		return NULL;
+
+	*len = st.st_size - offset;
+	if (*len > maxlen)
+		*len = maxlen;
+	if (*len > INT_MAX)
+		return NULL;
+
+	/* The mapping has to start on a page boundary */
+	start = offset - (offset % pagesize);
+	addr = mmap(NULL, *len + (offset - start), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE, fileno(f), start);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	m = tree_alloc(sizeof(*m));
+	m->addr = addr;
+	m->len = *len + (offset - start);
+	m->next = tree_mappings;
+	tree_mappings = m;
+
+	return (char *)addr + (offset - start);
+}
+
 /*
  * Tree building functions
  */
@@ -35,8 +126,7 @@ void add_label(struct label **labels, char *label)
 			return;
 		}
 
-	new = xmalloc(sizeof(*new));
-	memset(new, 0, sizeof(*new));
+	new = tree_alloc(sizeof(*new));
 	new->label = label;
 	new->next = *labels;
 	*labels = new;
@@ -52,9 +142,7 @@ void delete_labels(struct label **labels)
 
 struct property *build_property(char *name, struct data val)
 {
-	struct property *new = xmalloc(sizeof(*new));
-
-	memset(new, 0, sizeof(*new));
+	struct property *new = tree_alloc(sizeof(*new));
 
 	new->name = name;
 	new->val = val;
@@ -64,9 +152,7 @@ struct property *build_property(char *name, struct data val)
 
 struct property *build_property_delete(char *name)
 {
-	struct property *new = xmalloc(sizeof(*new));
-
-	memset(new, 0, sizeof(*new));
+	struct property *new = tree_alloc(sizeof(*new));
 
 	new->name = name;
 	new->deleted = 1;
@@ -99,11 +185,9 @@ struct property *reverse_properties(struct property *first)
 
 struct node *build_node(struct property *proplist, struct node *children)
 {
-	struct node *new = xmalloc(sizeof(*new));
+	struct node *new = tree_alloc(sizeof(*new));
 	struct node *child;
 
-	memset(new, 0, sizeof(*new));
-
 	new->proplist = reverse_properties(proplist);
 	new->children = children;
 
@@ -116,9 +200,7 @@ struct node *build_node(struct property *proplist, struct node *children)
 
 struct node *build_node_delete(void)
 {
-	struct node *new = xmalloc(sizeof(*new));
-
-	memset(new, 0, sizeof(*new));
+	struct node *new = tree_alloc(sizeof(*new));
 
 	new->deleted = 1;
 
@@ -134,6 +216,125 @@ struct node *name_node(struct node *node, char *name)
 	return node;
 }
 
+/*
+ * Per-node name lookup.  The list tails are found on demand and then
+ * kept up to date by add_property() and add_child(), so building a node
+ * one entry at a time is linear.  Nodes with many entries which are
+ * searched by name also get a hash of their property and child names;
+ * short lists are cheaper to scan.  Anything which edits a node's
+ * proplist or children other than through these must call
+ * unindex_node() afterwards.
+ */
+#define NODE_INDEX_MIN	16
+
+void unindex_node(struct node *node)
+{
+	node->last_prop = NULL;
+	node->last_child = NULL;
+	node->indexed = false;
+	strmap_free(&node->prop_index);
+	strmap_free(&node->child_index);
+}
+
+static struct property *last_property(struct node *node)
+{
+	struct property *prop = node->last_prop;
+
+	if (!prop)
+		prop = node->proplist;
+	if (!prop)
+		return NULL;
+
+	while (prop->next)
+		prop = prop->next;
+	node->last_prop = prop;
+	return prop;
+}
+
+static struct node *last_child(struct node *node)
+{
+	struct node *child = node->last_child;
+
+	if (!child)
+		child = node->children;
+	if (!child)
+		return NULL;
+
+	while (child->next_sibling)
+		child = child->next_sibling;
+	node->last_child = child;
+	return child;
+}
+
+/* Only the first entry of each name is indexed, as the scans find it */
+static void index_property(struct node *node, struct property *prop)
+{
+	void **slot = strmap_slot(&node->prop_index, prop->name);
+
+	if (!*slot)
+		*slot = prop;
+}
+
+static void index_child(struct node *node, struct node *child)
+{
+	void **slot = strmap_slot(&node->child_index, child->name);
+
+	if (!*slot)
+		*slot = child;
+}
+
+static void index_node(struct node *node)
+{
+	struct property *prop;
+	struct node *child;
+	int n = 0;
+
+	if (node->indexed)
+		return;
+
+	for_each_property_withdel(node, prop)
+		n++;
+	for_each_child_withdel(node, child)
+		n++;
+	if (n < NODE_INDEX_MIN)
+		return;
+
+	for_each_property_withdel(node, prop)
+		index_property(node, prop);
+	for_each_child_withdel(node, child)
+		index_child(node, child);
+	node->indexed = true;
+}
+
+static struct property *find_property_withdel(struct node *node,
+					      const char *name)
+{
+	struct property *prop;
+
+	index_node(node);
+	if (node->indexed)
+		return strmap_get(&node->prop_index, name);
+
+	for_each_property_withdel(node, prop)
+		if (streq(prop->name, name))
+			return prop;
+	return NULL;
+}
+
+static struct node *find_child_withdel(struct node *node, const char *name)
+{
+	struct node *child;
+
+	index_node(node);
+	if (node->indexed)
+		return strmap_get(&node->child_index, name);
+
+	for_each_child_withdel(node, child)
+		if (streq(child->name, name))
+			return child;
+	return NULL;
+}
+
 struct node *merge_nodes(struct node *old_node, struct node *new_node)
 {
 	struct property *new_prop, *old_prop;
@@ -156,28 +357,23 @@ struct node *merge_nodes(struct node *old_node, struct node *new_node)
 
 		if (new_prop->deleted) {
 			delete_property_by_name(old_node, new_prop->name);
-			free(new_prop);
 			continue;
 		}
 
 		/* Look for a collision, set new value if there is */
-		for_each_property_withdel(old_node, old_prop) {
-			if (streq(old_prop->name, new_prop->name)) {
-				/* Add new labels to old property */
-				for_each_label_withdel(new_prop->labels, l)
-					add_label(&old_prop->labels, l->label);
-
-				old_prop->val = new_prop->val;
-				old_prop->deleted = 0;
-				free(new_prop);
-				new_prop = NULL;
-				break;
-			}
-		}
-
-		/* if no collision occurred, add property to the old node. */
-		if (new_prop)
+		old_prop = find_property_withdel(old_node, new_prop->name);
+		if (old_prop) {
+			/* Add new labels to old property */
+			for_each_label_withdel(new_prop->labels, l)
+				add_label(&old_prop->labels, l->label);
+
+			data_free(old_prop->val);
+			old_prop->val = new_prop->val;
+			old_prop->deleted = 0;
+		} else {
+			/* if no collision occurred, add property to the old node. */
 			add_property(old_node, new_prop);
+		}
 	}
 
 	/* Move the override child nodes into the primary node.  If
@@ -191,28 +387,21 @@ struct node *merge_nodes(struct node *old_node, struct node *new_node)
 
 		if (new_child->deleted) {
 			delete_node_by_name(old_node, new_child->name);
-			free(new_child);
 			continue;
 		}
 
 		/* Search for a collision.  Merge if there is */
-		for_each_child_withdel(old_node, old_child) {
-			if (streq(old_child->name, new_child->name)) {
-				merge_nodes(old_child, new_child);
-				new_child = NULL;
-				break;
-			}
-		}
-
-		/* if no collision occurred, add child to the old node. */
-		if (new_child)
+		old_child = find_child_withdel(old_node, new_child->name);
+		if (old_child)
+			merge_nodes(old_child, new_child);
+		else
+			/* if no collision occurred, add child to the old node. */
 			add_child(old_node, new_child);
 	}
+	unindex_node(new_node);
 
-	/* The new node contents are now merged into the old node.  Free
-	 * the new node. */
-	free(new_node);
-
+	/* The new node contents are now merged into the old node; the
+	 * new node itself stays in the arena until the tree is freed. */
 	return old_node;
 }
 
@@ -226,28 +415,26 @@ struct node *chain_node(struct node *first, struct node *list)
 
 void add_property(struct node *node, struct property *prop)
 {
-	struct property **p;
+	struct property *last = last_property(node);
 
 	prop->next = NULL;
 
-	p = &node->proplist;
-	while (*p)
-		p = &((*p)->next);
+	if (last)
+		last->next = prop;
+	else
+		node->proplist = prop;
+	node->last_prop = prop;
 
-	*p = prop;
+	if (node->indexed)
+		index_property(node, prop);
 }
 
 void delete_property_by_name(struct node *node, char *name)
 {
-	struct property *prop = node->proplist;
+	struct property *prop = find_property_withdel(node, name);
 
-	while (prop) {
-		if (streq(prop->name, name)) {
-			delete_property(prop);
-			return;
-		}
-		prop = prop->next;
-	}
+	if (prop)
+		delete_property(prop);
 }
 
 void delete_property(struct property *prop)
@@ -258,29 +445,27 @@ void delete_property(struct property *prop)
 
 void add_child(struct node *parent, struct node *child)
 {
-	struct node **p;
+	struct node *last = last_child(parent);
 
 	child->next_sibling = NULL;
 	child->parent = parent;
 
-	p = &parent->children;
-	while (*p)
-		p = &((*p)->next_sibling);
+	if (last)
+		last->next_sibling = child;
+	else
+		parent->children = child;
+	parent->last_child = child;
 
-	*p = child;
+	if (parent->indexed)
+		index_child(parent, child);
 }
 
 void delete_node_by_name(struct node *parent, char *name)
 {
-	struct node *node = parent->children;
+	struct node *node = find_child_withdel(parent, name);
 
-	while (node) {
-		if (streq(node->name, name)) {
-			delete_node(node);
-			return;
-		}
-		node = node->next_sibling;
-	}
+	if (node)
+		delete_node(node);
 }
 
 void delete_node(struct node *node)
@@ -315,9 +500,7 @@ void append_to_property(struct node *node,
 
 struct reserve_info *build_reserve_entry(uint64_t address, uint64_t size)
 {
-	struct reserve_info *new = xmalloc(sizeof(*new));
-
-	memset(new, 0, sizeof(*new));
+	struct reserve_info *new = tree_alloc(sizeof(*new));
 
 	new->address = address;
 	new->size = size;
@@ -359,14 +542,71 @@ struct dt_info *build_dt_info(unsigned int dtsflags,
 	struct dt_info *dti;
 
 	dti = xmalloc(sizeof(*dti));
+	if (!tree_arena)
+		new_tree_arena();
+	dti->arena = tree_arena;
 	dti->dtsflags = dtsflags;
 	dti->reservelist = reservelist;
 	dti->dt = tree;
 	dti->boot_cpuid_phys = boot_cpuid_phys;
+	dti->mappings = tree_mappings;
+	tree_mappings = NULL;
+	dti->blob = NULL;
+	dti->blob_size = 0;
+	dti->blob_mapped = false;
+	dti->used_phandles = NULL;
+	dti->num_used_phandles = 0;
+	dti->next_used_phandle = 0;
+	dti->next_phandle = 0;
+	dti->have_symbols = false;
+	memset(&dti->labels, 0, sizeof(dti->labels));
+	memset(&dti->paths, 0, sizeof(dti->paths));
 
 	return dti;
 }
 
+static void free_node_data(struct node *node)
+{
+	struct property *prop;
+	struct node *child;
+
+	for_each_property_withdel(node, prop)
+		data_free(prop->val);
+
+	for_each_child_withdel(node, child)
+		free_node_data(child);
+
+	unindex_node(node);
+	free(node->fullpath);
+}
+
+void free_dt_info(struct dt_info *dti)
+{
+	struct tree_mapping *m;
+
+	/* Property values, full paths, mapped files and the input blob
+	 * are the only parts outside the arena */
+	free_node_data(dti->dt);
+
+	for (m = dti->mappings; m; m = m->next)
+		munmap(m->addr, m->len);
+
+	if (dti->blob_mapped)
+		munmap(dti->blob, dti->blob_size);
+	else
+		free(dti->blob);
+
+	free(dti->used_phandles);
+	strmap_free(&dti->labels);
+	strmap_free(&dti->paths);
+
+	if (tree_arena == dti->arena)
+		tree_arena = NULL;
+	arena_free(dti->arena);
+	free(dti->arena);
+	free(dti);
+}
+
 /*
  * Tree accessor functions
  */
@@ -539,15 +779,76 @@ struct node *get_node_by_ref(struct node *tree, const char *ref)
 		return get_node_by_label(tree, ref);
 }
 
-cell_t get_node_phandle(struct node *root, struct node *node)
+static void collect_phandles(struct dt_info *dti, struct node *node)
 {
-	static cell_t phandle = 1; /* FIXME: ick, static local */
+	struct node *child;
+
+	if ((node->phandle != 0) && (node->phandle != -1))
+		dti->used_phandles[dti->num_used_phandles++] = node->phandle;
+
+	for_each_child(node, child)
+		collect_phandles(dti, child);
+}
+
+static int count_nodes(struct node *node)
+{
+	struct node *child;
+	int n = 1;
+
+	for_each_child(node, child)
+		n += count_nodes(child);
+
+	return n;
+}
+
+static int cmp_phandle(const void *ax, const void *bx)
+{
+	cell_t a = *(const cell_t *)ax, b = *(const cell_t *)bx;
+
+	return (a > b) - (a < b);
+}
+
+/*
+ * Allocate the lowest phandle not already used in the tree.  The
+ * explicit phandles are collected and sorted on the first call, so
+ * every phandle in the source must have been assigned by then (the
+ * explicit_phandles check does this); after that each allocation just
+ * steps past the used values.
+ */
+static cell_t alloc_phandle(struct dt_info *dti)
+{
+	if (!dti->next_phandle) {
+		dti->used_phandles = xmalloc(count_nodes(dti->dt)
+					     * sizeof(cell_t));
+		collect_phandles(dti, dti->dt);
+		qsort(dti->used_phandles, dti->num_used_phandles,
+		      sizeof(cell_t), cmp_phandle);
+		dti->next_phandle = 1;
+	}
+
+	while ((dti->next_used_phandle < dti->num_used_phandles)
+	       && (dti->used_phandles[dti->next_used_phandle]
+		   <= dti->next_phandle)) {
+		if (dti->used_phandles[dti->next_used_phandle]
+		    == dti->next_phandle)
+			dti->next_phandle++;
+		dti->next_used_phandle++;
+	}
+
+	if (dti->next_phandle == (cell_t)-1)
+		die("Too many phandles\n");
+
+	return dti->next_phandle++;
+}
+
+cell_t get_node_phandle(struct dt_info *dti, struct node *node)
+{
+	cell_t phandle;
 
 	if ((node->phandle != 0) && (node->phandle != -1))
 		return node->phandle;
 
-	while (get_node_by_phandle(root, phandle))
-		phandle++;
+	phandle = alloc_phandle(dti);
 
 	node->phandle = phandle;
 
@@ -570,6 +871,117 @@ cell_t get_node_phandle(struct node *root, struct node *node)
 	return node->phandle;
 }
 
+/*
+ * Symbol tables
+ *
+ * The label and path tables are built in one walk of the tree on the
+ * first lookup, after the tree has been parsed and its full paths
+ * filled in.  They give the same answers as get_node_by_label(),
+ * get_property_by_label(), get_marker_label() and get_node_by_path() on
+ * the tree as it was then; later additions of labelled nodes aren't
+ * seen, but nothing adds labels after parsing.
+ */
+
+static void add_label_target(struct dt_info *dti, const char *label,
+			     struct node *node, struct property *prop,
+			     struct marker *marker)
+{
+	struct label_target **slot, *t;
+	int rank = (prop != NULL) + (marker != NULL);
+
+	/* Node labels win over property labels, which win over value
+	 * labels; otherwise the first in tree order wins */
+	slot = (struct label_target **)strmap_slot(&dti->labels, label);
+	t = *slot;
+	if (t && ((t->prop != NULL) + (t->marker != NULL) <= rank))
+		return;
+
+	if (!t)
+		*slot = t = tree_alloc(sizeof(*t));
+	t->node = node;
+	t->prop = prop;
+	t->marker = marker;
+}
+
+static void collect_symbols(struct dt_info *dti, struct node *node)
+{
+	struct node *child;
+	struct property *prop;
+	struct label *l;
+	void **slot;
+
+	assert(node->fullpath);
+	slot = strmap_slot(&dti->paths, node->fullpath);
+	if (!*slot)
+		*slot = node;
+
+	for_each_label(node->labels, l)
+		add_label_target(dti, l->label, node, NULL, NULL);
+
+	for_each_property(node, prop) {
+		struct marker *m = prop->val.markers;
+
+		for_each_label(prop->labels, l)
+			add_label_target(dti, l->label, node, prop, NULL);
+
+		for_each_marker_of_type(m, LABEL)
+			add_label_target(dti, m->ref, node, prop, m);
+	}
+
+	for_each_child(node, child)
+		collect_symbols(dti, child);
+}
+
+void dti_build_symbols(struct dt_info *dti)
+{
+	if (dti->have_symbols)
+		return;
+
+	collect_symbols(dti, dti->dt);
+	dti->have_symbols = true;
+}
+
+struct label_target *dti_get_label(struct dt_info *dti, const char *label)
+{
+	dti_build_symbols(dti);
+	return strmap_get(&dti->labels, label);
+}
+
+struct node *dti_get_node_by_path(struct dt_info *dti, const char *path)
+{
+	struct node *node;
+
+	dti_build_symbols(dti);
+	node = strmap_get(&dti->paths, path);
+	if (node)
+		return node;
+
+	/* Not a canonical path, or a node added since */
+	return get_node_by_path(dti->dt, path);
+}
+
+struct node *dti_get_node_by_label(struct dt_info *dti, const char *label)
+{
+	struct label_target *t;
+
+	assert(label && (strlen(label) > 0));
+
+	t = dti_get_label(dti, label);
+	if (t && !t->prop)
+		return t->node;
+	return NULL;
+}
+
+struct node *dti_get_node_by_ref(struct dt_info *dti, const char *ref)
+{
+	if (streq(ref, "/"))
+		return dti->dt;
+	else if (ref[0] == '/')
+		return dti_get_node_by_path(dti, ref);
+	else
+		return dti_get_node_by_label(dti, ref);
+}
+
 uint32_t guess_boot_cpuid(struct node *tree)
 {
 	struct node *cpus, *bootcpu;
@@ -720,6 +1132,7 @@ static void sort_node(struct node *node)
 
 	sort_properties(node);
 	sort_subnodes(node);
+	unindex_node(node);
 	for_each_child_withdel(node, c)
 		sort_node(c);
 }
@@ -736,7 +1149,7 @@ static struct node *build_and_name_child_node(struct node *parent, char *name)
 	struct node *node;
 
 	node = build_node(NULL, NULL);
-	name_node(node, xstrdup(name));
+	name_node(node, tree_strdup(name));
 	add_child(parent, node);
 
 	return node;
@@ -774,7 +1187,6 @@ static void generate_label_tree_internal(struct dt_info *dti,
 					 struct node *an, struct node *node,
 					 bool allocph)
 {
-	struct node *dt = dti->dt;
 	struct node *c;
 	struct property *p;
 	struct label *l;
@@ -803,7 +1215,7 @@ static void generate_label_tree_internal(struct dt_info *dti,
 
 		/* force allocation of a phandle for this node */
 		if (allocph)
-			(void)get_node_phandle(dt, node);
+			(void)get_node_phandle(dti, node);
 	}
 
 	for_each_child(node, c)
@@ -819,7 +1231,7 @@ static bool any_fixup_tree(struct dt_info *dti, struct node *node)
 	for_each_property(node, prop) {
 		m = prop->val.markers;
 		for_each_marker_of_type(m, REF_PHANDLE) {
-			if (!get_node_by_ref(dti->dt, m->ref))
+			if (!dti_get_node_by_ref(dti, m->ref))
 				return true;
 		}
 	}
@@ -856,7 +1268,6 @@ static void generate_fixups_tree_internal(struct dt_info *dti,
 					  struct node *fn,
 					  struct node *node)
 {
-	struct node *dt = dti->dt;
 	struct node *c;
 	struct property *prop;
 	struct marker *m;
@@ -865,7 +1276,7 @@ static void generate_fixups_tree_internal(struct dt_info *dti,
 	for_each_property(node, prop) {
 		m = prop->val.markers;
 		for_each_marker_of_type(m, REF_PHANDLE) {
-			refnode = get_node_by_ref(dt, m->ref);
+			refnode = dti_get_node_by_ref(dti, m->ref);
 			if (!refnode)
 				add_fixup_entry(dti, fn, node, prop, m);
 		}
@@ -884,7 +1295,7 @@ static bool any_local_fixup_tree(struct dt_info *dti, struct node *node)
 	for_each_property(node, prop) {
 		m = prop->val.markers;
 		for_each_marker_of_type(m, REF_PHANDLE) {
-			if (get_node_by_ref(dti->dt, m->ref))
+			if (dti_get_node_by_ref(dti, m->ref))
 				return true;
 		}
 	}
@@ -937,7 +1348,6 @@ static void generate_local_fixups_tree_internal(struct dt_info *dti,
 						struct node *lfn,
 						struct node *node)
 {
-	struct node *dt = dti->dt;
 	struct node *c;
 	struct property *prop;
 	struct marker *m;
@@ -946,7 +1356,7 @@ static void generate_local_fixups_tree_internal(struct dt_info *dti,
 	for_each_property(node, prop) {
 		m = prop->val.markers;
 		for_each_marker_of_type(m, REF_PHANDLE) {
-			refnode = get_node_by_ref(dt, m->ref);
+			refnode = dti_get_node_by_ref(dti, m->ref);
 			if (refnode)
 				add_local_fixup_entry(dti, lfn, node, prop, m, refnode);
 		}
@@ -52,6 +52,10 @@ static char *get_dirname(const char *path)
 FILE *depfile; /* = NULL */
 struct srcfile_state *current_srcfile; /* = NULL */
 
+/* Every file opened by srcfile_relative_open(), in order */
+static char **opened_names;
+static int num_opened;
+
 /* Detect infinite include recursion. */
 #define MAX_SRCFILE_DEPTH     (100)
 static int srcfile_depth; /* = 0 */
@@ -132,6 +136,10 @@ FILE *srcfile_relative_open(const char *fname, char **fullnamep)
 	if (depfile)
 		fprintf(depfile, " %s", fullname);
 
+	opened_names = xrealloc(opened_names,
+				(num_opened + 1) * sizeof(*opened_names));
+	opened_names[num_opened++] = xstrdup(fullname);
+
 	if (fullnamep)
 		*fullnamep = fullname;
 	else
@@ -140,7 +148,7 @@ FILE *srcfile_relative_open(const char *fname, char **fullnamep)
 	return f;
 }
 
-void srcfile_push(const char *fname)
+void srcfile_push_file(FILE *f, char *fullname)
 {
 	struct srcfile_state *srcfile;
 
@@ -149,7 +157,8 @@ void srcfile_push(const char *fname)
 
 	srcfile = xmalloc(sizeof(*srcfile));
 
-	srcfile->f = srcfile_relative_open(fname, &srcfile->name);
+	srcfile->f = f;
+	srcfile->name = fullname;
 	srcfile->dir = get_dirname(srcfile->name);
 	srcfile->prev = current_srcfile;
 
@@ -159,6 +168,15 @@ void srcfile_push(const char *fname)
 	current_srcfile = srcfile;
 }
 
+void srcfile_push(const char *fname)
+{
+	FILE *f;
+	char *fullname;
+
+	f = srcfile_relative_open(fname, &fullname);
+	srcfile_push_file(f, fullname);
+}
+
 bool srcfile_pop(void)
 {
 	struct srcfile_state *srcfile = current_srcfile;
@@ -197,6 +215,26 @@ void srcfile_add_search_path(const char *dirname)
 	search_path_tail = &node->next;
 }
 
+int srcfile_num_opened(void)
+{
+	return num_opened;
+}
+
+const char *srcfile_opened_name(int i)
+{
+	assert(i < num_opened);
+	return opened_names[i];
+}
+
+uint64_t srcfile_hash_search_path(uint64_t h)
+{
+	struct search_path *node;
+
+	for (node = search_path_head; node; node = node->next)
+		h = memhash(h, node->dirname, strlen(node->dirname) + 1);
+	return h;
+}
+
 /*
  * The empty source position.
  */
@@ -57,8 +57,14 @@ extern struct srcfile_state *current_srcfile; /* = NULL */
 FILE *srcfile_relative_open(const char *fname, char **fullnamep);
 
 void srcfile_push(const char *fname);
+/* Like srcfile_push(), for a file already opened by srcfile_relative_open() */
+void srcfile_push_file(FILE *f, char *fullname);
 bool srcfile_pop(void);
 
+/* The files opened so far by srcfile_relative_open(), in order */
+int srcfile_num_opened(void);
+const char *srcfile_opened_name(int i);
+
 /**
  * Add a new directory to the search path for input files
  *
@@ -68,6 +74,9 @@ bool srcfile_pop(void);
  */
 void srcfile_add_search_path(const char *dirname);
 
+/* Continues a memhash() of the search path, which decides what includes find */
+uint64_t srcfile_hash_search_path(uint64_t h);
+
 struct srcpos {
     int first_line;
     int first_column;
@@ -0,0 +1,184 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for fdt_getprop_by_stroff() and friends
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+#define MAX_PROPS	16
+
+static void check_node(const void *fdt, int node)
+{
+	int stroffsets[MAX_PROPS + 1], lens[MAX_PROPS + 1];
+	const void *vals[MAX_PROPS + 1];
+	const void *val, *expval;
+	const char *name;
+	int offset, n = 0, i, len, explen, stroff, found;
+
+	fdt_for_each_property_offset(offset, fdt, node) {
+		expval = fdt_getprop_by_offset(fdt, offset, &name, &explen);
+		stroff = fdt_string_offset(fdt, name);
+		if (stroff == -FDT_ERR_EXISTS) {
+			verbose_printf("\"%s\" is stored more than once\n",
+				       name);
+			continue;
+		}
+		if (stroff < 0)
+			FAIL("fdt_string_offset(\"%s\"): %s", name,
+			     fdt_strerror(stroff));
+		if (strcmp(fdt_string(fdt, stroff), name) != 0)
+			FAIL("fdt_string_offset(\"%s\") gave offset of \"%s\"",
+			     name, fdt_string(fdt, stroff));
+
+		val = fdt_getprop_by_stroff(fdt, node, stroff, &len);
+		if ((val != expval) || (len != explen))
+			FAIL("fdt_getprop_by_stroff(%d, \"%s\") mismatch",
+			     node, name);
+
+		if (n < MAX_PROPS)
+			stroffsets[n++] = stroff;
+	}
+
+	/* Batch lookup, with one offset matching nothing */
+	stroffsets[n] = -FDT_ERR_NOTFOUND;
+	found = fdt_getprops_by_stroff(fdt, node, n + 1, stroffsets,
+				       vals, lens);
+	if (found != n)
+		FAIL("fdt_getprops_by_stroff(%d) found %d of %d properties",
+		     node, found, n);
+	for (i = 0; i < n; i++) {
+		expval = fdt_getprop_by_stroff(fdt, node, stroffsets[i],
+					       &explen);
+		if ((vals[i] != expval) || (lens[i] != explen))
+			FAIL("fdt_getprops_by_stroff(%d) mismatch for \"%s\"",
+			     node, fdt_string(fdt, stroffsets[i]));
+	}
+	if (vals[n] || (lens[n] != -FDT_ERR_NOTFOUND))
+		FAIL("fdt_getprops_by_stroff(%d) found a missing property",
+		     node);
+}
+
+#define SPACE	4096
+
+#define CHECK(code) \
+	{ \
+		err = (code); \
+		if (err) \
+			FAIL(#code ": %s", fdt_strerror(err)); \
+	}
+
+static void check_stroff(const void *fdt, const char *name, uint32_t val)
+{
+	const fdt32_t *p;
+	int stroff, len;
+
+	stroff = fdt_string_offset(fdt, name);
+	if (stroff < 0)
+		FAIL("fdt_string_offset(\"%s\"): %s", name,
+		     fdt_strerror(stroff));
+
+	p = fdt_getprop_by_stroff(fdt, 0, stroff, &len);
+	if (!p || (len != sizeof(*p)) || (fdt32_to_cpu(*p) != val))
+		FAIL("Bad \"%s\" value from fdt_getprop_by_stroff()", name);
+}
+
+/* Names stored as the tail of a longer one, as dtc and libfdt share them */
+static void check_tail_aliases(void)
+{
+	char rw[SPACE], sw[SPACE];
+	int stroff, err;
+
+	CHECK(fdt_create_empty_tree(rw, SPACE));
+	/* "gpios" reuses the tail of "reset-gpios" */
+	CHECK(fdt_setprop_u32(rw, 0, "reset-gpios", 1));
+	CHECK(fdt_setprop_u32(rw, 0, "gpios", 2));
+	/* "dma-ranges" adds a second, unused, copy of "ranges" */
+	CHECK(fdt_setprop_u32(rw, 0, "ranges", 3));
+	CHECK(fdt_setprop_u32(rw, 0, "dma-ranges", 4));
+
+	check_stroff(rw, "reset-gpios", 1);
+	check_stroff(rw, "gpios", 2);
+	check_stroff(rw, "ranges", 3);
+	check_stroff(rw, "dma-ranges", 4);
+
+	/*
+	 * Sequential write stores later names first, so "clocks"
+	 * follows "assigned-clocks" in full as well as its tail
+	 */
+	CHECK(fdt_create(sw, SPACE));
+	CHECK(fdt_finish_reservemap(sw));
+	CHECK(fdt_begin_node(sw, ""));
+	CHECK(fdt_property_u32(sw, "clocks", 5));
+	CHECK(fdt_property_u32(sw, "assigned-clocks", 6));
+	CHECK(fdt_end_node(sw));
+	CHECK(fdt_finish(sw));
+
+	check_stroff(sw, "assigned-clocks", 6);
+	stroff = fdt_string_offset(sw, "clocks");
+	if (stroff != -FDT_ERR_EXISTS)
+		FAIL("fdt_string_offset(\"clocks\") gave %d for a name "
+		     "stored twice", stroff);
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt;
+	int node, stroff;
+	const fdt32_t *val;
+	int len;
+
+	test_init(argc, argv);
+	fdt = load_blob_arg(argc, argv);
+
+	if (fdt_magic(fdt) != FDT_MAGIC) {
+		stroff = fdt_string_offset(fdt, "prop-int");
+		if (stroff != -FDT_ERR_BADSTATE)
+			FAIL("fdt_string_offset() on unfinished tree gave %d",
+			     stroff);
+		PASS();
+	}
+
+	stroff = fdt_string_offset(fdt, "prop-int");
+	if (stroff >= 0) {
+		val = fdt_getprop_by_stroff(fdt, 0, stroff, &len);
+		if (!val || (len != sizeof(*val))
+		    || (fdt32_to_cpu(*val) != TEST_VALUE_1))
+			FAIL("Bad \"prop-int\" value from fdt_getprop_by_stroff()");
+	} else if (stroff != -FDT_ERR_EXISTS) {
+		FAIL("fdt_string_offset(\"prop-int\"): %s",
+		     fdt_strerror(stroff));
+	}
+
+	stroff = fdt_string_offset(fdt, "no-such-property");
+	if (stroff != -FDT_ERR_NOTFOUND)
+		FAIL("fdt_string_offset() found a missing name: %d", stroff);
+
+	for (node = fdt_next_node(fdt, -1, NULL); node >= 0;
+	     node = fdt_next_node(fdt, node, NULL))
+		check_node(fdt, node);
+
+	check_tail_aliases();
+
+	PASS();
+}
@@ -0,0 +1,148 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for the fdt_index_*() lookup functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+#define PATH_MAX_LEN	256
+
+static void check_node(void *fdt, void *idx, int offset)
+{
+	char path[PATH_MAX_LEN], ipath[PATH_MAX_LEN];
+	int depth, idepth, d, sub, isub, end, iend;
+	int err;
+
+	err = fdt_get_path(fdt, offset, path, sizeof(path));
+	if (err)
+		FAIL("fdt_get_path(%d): %s", offset, fdt_strerror(err));
+	err = fdt_index_get_path(fdt, idx, offset, ipath, sizeof(ipath));
+	if (err)
+		FAIL("fdt_index_get_path(%d): %s", offset, fdt_strerror(err));
+	if (!streq(path, ipath))
+		FAIL("fdt_index_get_path(%d) gives \"%s\" instead of \"%s\"",
+		     offset, ipath, path);
+
+	verbose_printf("Node %d: \"%s\"\n", offset, path);
+
+	if (fdt_index_path_offset(fdt, idx, path) != offset)
+		FAIL("fdt_index_path_offset(\"%s\") gives %d instead of %d",
+		     path, fdt_index_path_offset(fdt, idx, path), offset);
+
+	depth = fdt_node_depth(fdt, offset);
+	idepth = fdt_index_node_depth(fdt, idx, offset);
+	if (idepth != depth)
+		FAIL("fdt_index_node_depth(\"%s\") gives %d instead of %d",
+		     path, idepth, depth);
+
+	if (fdt_index_parent_offset(fdt, idx, offset)
+	    != fdt_parent_offset(fdt, offset))
+		FAIL("fdt_index_parent_offset(\"%s\") gives %d instead of %d",
+		     path, fdt_index_parent_offset(fdt, idx, offset),
+		     fdt_parent_offset(fdt, offset));
+
+	for (d = -1; d <= depth + 1; d++) {
+		int s, is;
+
+		s = fdt_supernode_atdepth_offset(fdt, offset, d, NULL);
+		is = fdt_index_supernode_atdepth_offset(fdt, idx, offset, d,
+							&idepth);
+		if (s != is)
+			FAIL("fdt_index_supernode_atdepth_offset(\"%s\", %d) "
+			     "gives %d instead of %d", path, d, is, s);
+	}
+
+	/* Subnodes must come back in the same order... */
+	sub = fdt_first_subnode(fdt, offset);
+	isub = fdt_index_first_subnode(fdt, idx, offset);
+	while ((sub >= 0) || (isub >= 0)) {
+		const char *name;
+
+		if (sub != isub)
+			FAIL("Subnode of \"%s\" is %d with index, %d without",
+			     path, isub, sub);
+
+		/* ...and be found by name */
+		name = fdt_get_name(fdt, sub, NULL);
+		if (fdt_index_subnode_offset(fdt, idx, offset, name) != sub)
+			FAIL("fdt_index_subnode_offset(\"%s\", \"%s\") gives "
+			     "%d instead of %d", path, name,
+			     fdt_index_subnode_offset(fdt, idx, offset, name),
+			     sub);
+
+		sub = fdt_next_subnode(fdt, sub);
+		isub = fdt_index_next_subnode(fdt, idx, isub);
+	}
+	if (sub != isub)
+		FAIL("Subnode iteration of \"%s\" ends with %d instead of %d",
+		     path, isub, sub);
+
+	if (fdt_index_subnode_offset(fdt, idx, offset, "no-such-node")
+	    != -FDT_ERR_NOTFOUND)
+		FAIL("fdt_index_subnode_offset() found a nonexistent node");
+
+	end = fdt_index_node_end_offset(fdt, NULL, offset);
+	iend = fdt_index_node_end_offset(fdt, idx, offset);
+	if ((end < 0) || (end != iend))
+		FAIL("fdt_index_node_end_offset(\"%s\") gives %d instead of %d",
+		     path, iend, end);
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt, *idx;
+	int size, offset, err;
+	char path[PATH_MAX_LEN];
+
+	test_init(argc, argv);
+	fdt = load_blob_arg(argc, argv);
+
+	size = fdt_index_size(fdt);
+	if (size < 0)
+		FAIL("fdt_index_size(): %s", fdt_strerror(size));
+	idx = xmalloc(size);
+
+	err = fdt_index_build(fdt, idx, size - 1);
+	if (err != -FDT_ERR_NOSPACE)
+		FAIL("fdt_index_build() with short buffer gives %d", err);
+
+	err = fdt_index_build(fdt, idx, size);
+	if (err)
+		FAIL("fdt_index_build(): %s", fdt_strerror(err));
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(fdt, offset, NULL))
+		check_node(fdt, idx, offset);
+	if (offset != -FDT_ERR_NOTFOUND)
+		FAIL("fdt_next_node(): %s", fdt_strerror(offset));
+
+	err = fdt_index_parent_offset(fdt, idx, 4);
+	if (err != -FDT_ERR_BADOFFSET)
+		FAIL("fdt_index_parent_offset() of bad offset gives %d", err);
+
+	if (fdt_index_get_path(fdt, idx, 0, path, 1) != -FDT_ERR_NOSPACE)
+		FAIL("fdt_index_get_path() with short buffer succeeded");
+
+	free(idx);
+	PASS();
+}
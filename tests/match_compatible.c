@@ -0,0 +1,156 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for fdt_match_compatible() and the compatible index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+static const char *const table[] = {
+	"subsubnode",
+	"nothing",
+	"subnode1",
+	NULL,
+	"subsubnode2",
+	"test_tree1",
+	"subsubnode",
+};
+
+#define MAX_MATCHES	32
+
+/* Work out what fdt_match_compatible() should say the slow way */
+static int expected_matches(void *fdt, struct fdt_compatible_match *m)
+{
+	int offset, priority, i, n = 0;
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(fdt, offset, NULL)) {
+		int count = fdt_stringlist_count(fdt, offset, "compatible");
+
+		for (priority = 0; priority < count; priority++) {
+			const char *s = fdt_stringlist_get(fdt, offset,
+							   "compatible",
+							   priority, NULL);
+
+			for (i = 0; i < ARRAY_SIZE(table); i++) {
+				if (!table[i] || !streq(s, table[i]))
+					continue;
+				if (n >= MAX_MATCHES)
+					TEST_BUG("too many matches");
+				m[n].nodeoffset = offset;
+				m[n].entry = i;
+				m[n].priority = priority;
+				n++;
+			}
+		}
+	}
+
+	return n;
+}
+
+static void check_index(void *fdt, void *cidx, const char *compat)
+{
+	int offset, ioffset;
+
+	offset = fdt_node_offset_by_compatible(fdt, -1, compat);
+	ioffset = fdt_compat_index_node_offset(fdt, cidx, -1, compat);
+	while ((offset >= 0) || (ioffset >= 0)) {
+		if (offset != ioffset)
+			FAIL("fdt_compat_index_node_offset(\"%s\") gives %d "
+			     "instead of %d", compat, ioffset, offset);
+		offset = fdt_node_offset_by_compatible(fdt, offset, compat);
+		ioffset = fdt_compat_index_node_offset(fdt, cidx, ioffset,
+						       compat);
+	}
+	if (offset != ioffset)
+		FAIL("fdt_compat_index_node_offset(\"%s\") ends with %d "
+		     "instead of %d", compat, ioffset, offset);
+}
+
+int main(int argc, char *argv[])
+{
+	struct fdt_compatible_match expect[MAX_MATCHES], got[MAX_MATCHES];
+	void *fdt, *cidx, *ws;
+	int n, count, i, size, wssize, err;
+
+	test_init(argc, argv);
+	fdt = load_blob_arg(argc, argv);
+
+	n = expected_matches(fdt, expect);
+	if (n == 0)
+		TEST_BUG("no matches in test tree");
+
+	wssize = fdt_match_compatible_size(ARRAY_SIZE(table));
+	if (wssize < 0)
+		FAIL("fdt_match_compatible_size(): %s", fdt_strerror(wssize));
+	ws = xmalloc(wssize);
+
+	count = fdt_match_compatible(fdt, table, ARRAY_SIZE(table),
+				     ws, wssize - 1, NULL, 0);
+	if (count != -FDT_ERR_NOSPACE)
+		FAIL("fdt_match_compatible() accepts a short workspace");
+
+	count = fdt_match_compatible(fdt, table, ARRAY_SIZE(table),
+				     ws, wssize, NULL, 0);
+	if (count != n)
+		FAIL("fdt_match_compatible() counts %d matches instead of %d",
+		     count, n);
+
+	/* A short array gets the first matches only */
+	memset(got, 0xff, sizeof(got));
+	count = fdt_match_compatible(fdt, table, ARRAY_SIZE(table),
+				     ws, wssize, got, 2);
+	if ((count != n) || (got[2].nodeoffset != -1))
+		FAIL("fdt_match_compatible() overran its array");
+
+	count = fdt_match_compatible(fdt, table, ARRAY_SIZE(table),
+				     ws, wssize, got, MAX_MATCHES);
+	if (count != n)
+		FAIL("fdt_match_compatible() returns %d instead of %d",
+		     count, n);
+	for (i = 0; i < n; i++)
+		if ((got[i].nodeoffset != expect[i].nodeoffset)
+		    || (got[i].entry != expect[i].entry)
+		    || (got[i].priority != expect[i].priority))
+			FAIL("Match %d is (%d, %d, %d) instead of (%d, %d, %d)",
+			     i, got[i].nodeoffset, got[i].entry,
+			     got[i].priority, expect[i].nodeoffset,
+			     expect[i].entry, expect[i].priority);
+
+	size = fdt_compat_index_size(fdt);
+	if (size < 0)
+		FAIL("fdt_compat_index_size(): %s", fdt_strerror(size));
+	cidx = xmalloc(size);
+	err = fdt_compat_index_build(fdt, cidx, size);
+	if (err)
+		FAIL("fdt_compat_index_build(): %s", fdt_strerror(err));
+
+	for (i = 0; i < ARRAY_SIZE(table); i++)
+		if (table[i])
+			check_index(fdt, cidx, table[i]);
+	check_index(fdt, cidx, "subsubnode1");
+	check_index(fdt, cidx, "zzz");
+
+	free(cidx);
+	free(ws);
+	PASS();
+}
@@ -0,0 +1,151 @@
+/* autogenerated by dtc, do not edit */
+
+	.globl	dt_blob_start
+dt_blob_start:
+_dt_blob_start:
+	.globl	dt_header
+dt_header:
+_dt_header:
+	/* magic */
+	.byte 0xd0; .byte 0x0d; .byte 0xfe; .byte 0xed
+	/* totalsize */
+	.byte	((_dt_blob_abs_end - _dt_blob_start) >> 24) & 0xff
+	.byte	((_dt_blob_abs_end - _dt_blob_start) >> 16) & 0xff
+	.byte	((_dt_blob_abs_end - _dt_blob_start) >> 8) & 0xff
+	.byte	(_dt_blob_abs_end - _dt_blob_start) & 0xff
+	/* off_dt_struct */
+	.byte	((_dt_struct_start - _dt_blob_start) >> 24) & 0xff
+	.byte	((_dt_struct_start - _dt_blob_start) >> 16) & 0xff
+	.byte	((_dt_struct_start - _dt_blob_start) >> 8) & 0xff
+	.byte	(_dt_struct_start - _dt_blob_start) & 0xff
+	/* off_dt_strings */
+	.byte	((_dt_strings_start - _dt_blob_start) >> 24) & 0xff
+	.byte	((_dt_strings_start - _dt_blob_start) >> 16) & 0xff
+	.byte	((_dt_strings_start - _dt_blob_start) >> 8) & 0xff
+	.byte	(_dt_strings_start - _dt_blob_start) & 0xff
+	/* off_mem_rsvmap */
+	.byte	((_dt_reserve_map - _dt_blob_start) >> 24) & 0xff
+	.byte	((_dt_reserve_map - _dt_blob_start) >> 16) & 0xff
+	.byte	((_dt_reserve_map - _dt_blob_start) >> 8) & 0xff
+	.byte	(_dt_reserve_map - _dt_blob_start) & 0xff
+	/* version */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x11
+	/* last_comp_version */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x10
+	/* boot_cpuid_phys */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x00
+	/* size_dt_strings */
+	.byte	((_dt_strings_end - _dt_strings_start) >> 24) & 0xff
+	.byte	((_dt_strings_end - _dt_strings_start) >> 16) & 0xff
+	.byte	((_dt_strings_end - _dt_strings_start) >> 8) & 0xff
+	.byte	(_dt_strings_end - _dt_strings_start) & 0xff
+	/* size_dt_struct */
+	.byte	((_dt_struct_end - _dt_struct_start) >> 24) & 0xff
+	.byte	((_dt_struct_end - _dt_struct_start) >> 16) & 0xff
+	.byte	((_dt_struct_end - _dt_struct_start) >> 8) & 0xff
+	.byte	(_dt_struct_end - _dt_struct_start) & 0xff
+	.balign	8, 0
+	.globl	dt_reserve_map
+dt_reserve_map:
+_dt_reserve_map:
+/* Memory reserve map from source file */
+	.long	0, 0
+	.long	0, 0
+	.globl	dt_struct_start
+dt_struct_start:
+_dt_struct_start:
+	/* FDT_BEGIN_NODE */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x01
+	.string	""
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x15
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x3a
+	.byte 0x74; .byte 0x65; .byte 0x73; .byte 0x74
+	.byte 0x2d; .byte 0x73; .byte 0x74; .byte 0x72
+	.byte 0x69; .byte 0x6e; .byte 0x67; .byte 0x2d
+	.byte 0x73; .byte 0x75; .byte 0x66; .byte 0x66
+	.byte 0x69; .byte 0x78; .byte 0x65; .byte 0x73
+	.byte	0x0
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x00
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x01
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x0f
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x00
+	.balign	4, 0
+	/* FDT_BEGIN_NODE */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x01
+	.string	"node@0"
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x1f
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x00
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x1b
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x01
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x28
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x02
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x23
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x05
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x33
+	.byte 0x6e; .byte 0x6f; .byte 0x64; .byte 0x65
+	.byte	0x0
+	.balign	4, 0
+	/* FDT_PROP */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x03
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x04
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x45
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x00
+	.balign	4, 0
+	/* FDT_END_NODE */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x02
+	/* FDT_END_NODE */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x02
+	/* FDT_END */
+	.byte 0x00; .byte 0x00; .byte 0x00; .byte 0x09
+	.globl	dt_struct_end
+dt_struct_end:
+_dt_struct_end:
+	.globl	dt_strings_start
+dt_strings_start:
+_dt_strings_start:
+	.string "#address-cells"
+	.string "#size-cells"
+	.string "phy-reg"
+	.string "pcie-interrupts"
+	.string "vendor,compatible"
+	.string "vendor,size-cells"
+	.globl	dt_strings_end
+dt_strings_end:
+_dt_strings_end:
+	.globl	dt_blob_end
+dt_blob_end:
+_dt_blob_end:
+	.globl	dt_blob_abs_end
+dt_blob_abs_end:
+_dt_blob_abs_end:
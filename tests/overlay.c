@@ -20,6 +20,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include <libfdt.h>
 
@@ -152,6 +153,11 @@ static int fdt_overlay_local_phandle(void *fdt)
 					 1, &val));
 	CHECK(val != local_phandle);
 
+	/* Only set by some of the overlays */
+	if (!fdt_getprop_u32_by_poffset(fdt, "/test-node",
+					"test-extra-phandle", 0, &val))
+		CHECK(val != local_phandle);
+
 	return 0;
 }
 
@@ -199,9 +205,33 @@ static void *open_dt(char *path)
 	return copy;
 }
 
+static void check_overlay_applied(void *fdt)
+{
+	fdt_overlay_change_int_property(fdt);
+	fdt_overlay_change_str_property(fdt);
+	fdt_overlay_add_str_property(fdt);
+	fdt_overlay_add_node(fdt);
+	fdt_overlay_add_subnode_property(fdt);
+
+	/*
+	 * If the base tree has a __symbols__ node, do the tests that
+	 * are only successful with a proper phandle support, and thus
+	 * dtc -@
+	 */
+	if (fdt_path_offset(fdt, "/__symbols__") >= 0) {
+		fdt_overlay_local_phandle(fdt);
+		fdt_overlay_local_phandles(fdt);
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	void *fdt_base, *fdt_overlay;
+	void *fdt_base_idx, *fdt_overlay_idx, *idx;
+	void *fdt_base_into, *fdt_overlay_into, *fdt_merged;
+	const void *fdt_overlay_many;
+	void *fdt_merged_many, *ws;
+	int idxsize, wssize;
 
 	test_init(argc, argv);
 	if (argc != 3)
@@ -209,25 +239,59 @@ int main(int argc, char *argv[])
 
 	fdt_base = open_dt(argv[1]);
 	fdt_overlay = open_dt(argv[2]);
+	fdt_base_idx = open_dt(argv[1]);
+	fdt_overlay_idx = open_dt(argv[2]);
+	fdt_base_into = open_dt(argv[1]);
+	fdt_overlay_into = open_dt(argv[2]);
+	fdt_merged = xmalloc(FDT_COPY_SIZE);
+	fdt_merged_many = xmalloc(FDT_COPY_SIZE);
 
 	/* Apply the overlay */
 	CHECK(fdt_overlay_apply(fdt_base, fdt_overlay));
 
-	fdt_overlay_change_int_property(fdt_base);
-	fdt_overlay_change_str_property(fdt_base);
-	fdt_overlay_add_str_property(fdt_base);
-	fdt_overlay_add_node(fdt_base);
-	fdt_overlay_add_subnode_property(fdt_base);
+	/* Applying it with an index must leave the same tree */
+	idxsize = fdt_overlay_index_size(fdt_base_idx, fdt_overlay_idx);
+	CHECK(idxsize < 0);
+	idx = xmalloc(idxsize);
+	CHECK(fdt_overlay_apply_indexed(fdt_base_idx, fdt_overlay_idx,
+					idx, idxsize - 1) != -FDT_ERR_NOSPACE);
+	CHECK(fdt_overlay_apply_indexed(fdt_base_idx, fdt_overlay_idx,
+					idx, idxsize));
+	if (memcmp(fdt_base, fdt_base_idx, FDT_COPY_SIZE) != 0)
+		FAIL("Indexed overlay application gave a different tree");
+
+	check_overlay_applied(fdt_base);
 
 	/*
-	 * If the base tree has a __symbols__ node, do the tests that
-	 * are only successful with a proper phandle support, and thus
-	 * dtc -@
+	 * Writing the merge out to a new buffer must leave both the base
+	 * and the overlay as they were
 	 */
-	if (fdt_path_offset(fdt_base, "/__symbols__") >= 0) {
-		fdt_overlay_local_phandle(fdt_base);
-		fdt_overlay_local_phandles(fdt_base);
-	}
+	CHECK(fdt_overlay_apply_into(fdt_base_into, fdt_overlay_into,
+				     idx, idxsize, fdt_merged, FDT_COPY_SIZE));
+	if (memcmp(fdt_base_into, open_dt(argv[1]), FDT_COPY_SIZE) != 0)
+		FAIL("Rebuilding overlay application changed the base tree");
+	if (memcmp(fdt_overlay_into, open_dt(argv[2]), FDT_COPY_SIZE) != 0)
+		FAIL("Rebuilding overlay application changed the overlay");
+	check_overlay_applied(fdt_merged);
+
+	/*
+	 * A batch of one overlay must write out the same tree, from the
+	 * overlay already applied
+	 */
+	fdt_overlay_many = fdt_overlay_into;
+	wssize = fdt_overlay_apply_many_size(fdt_base_into, &fdt_overlay_many,
+					     1);
+	CHECK(wssize < 0);
+	ws = xmalloc(wssize);
+	CHECK(fdt_overlay_apply_many(fdt_base_into, &fdt_overlay_many, 1,
+				     ws, wssize - 1, fdt_merged_many,
+				     FDT_COPY_SIZE, NULL) != -FDT_ERR_NOSPACE);
+	CHECK(fdt_overlay_apply_many(fdt_base_into, &fdt_overlay_many, 1,
+				     ws, wssize, fdt_merged_many,
+				     FDT_COPY_SIZE, NULL));
+	CHECK(fdt_pack(fdt_merged));
+	if (memcmp(fdt_merged, fdt_merged_many, fdt_totalsize(fdt_merged)))
+		FAIL("Batch overlay application gave a different tree");
 
 	PASS();
 }
@@ -53,8 +53,8 @@ static void *open_dt(char *path)
 
 int main(int argc, char *argv[])
 {
-	void *fdt_base, *fdt_overlay;
-	int err;
+	void *fdt_base, *fdt_overlay, *idx;
+	int err, idxsize;
 
 	test_init(argc, argv);
 	if (argc != 3)
@@ -66,5 +66,16 @@ int main(int argc, char *argv[])
 	/* Apply the overlay */
 	CHECK(fdt_overlay_apply(fdt_base, fdt_overlay), -FDT_ERR_BADOVERLAY);
 
+	/* And again through an index, on fresh copies */
+	fdt_base = open_dt(argv[1]);
+	fdt_overlay = open_dt(argv[2]);
+
+	idxsize = fdt_overlay_index_size(fdt_base, fdt_overlay);
+	if (idxsize < 0)
+		FAIL("fdt_overlay_index_size(): %s", fdt_strerror(idxsize));
+	idx = xmalloc(idxsize);
+	CHECK(fdt_overlay_apply_indexed(fdt_base, fdt_overlay, idx, idxsize),
+	      -FDT_ERR_BADOVERLAY);
+
 	PASS();
 }
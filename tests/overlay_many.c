@@ -0,0 +1,147 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for applying a batch of DT overlays at once
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+
+#define CHECK(code) \
+	{ \
+		int err = (code); \
+		if (err) \
+			FAIL(#code ": %s", fdt_strerror(err)); \
+	}
+
+#define BAD_OVERLAY_SIZE	1024
+
+/* An overlay whose target is missing from any base tree */
+static void *build_bad_overlay(void)
+{
+	void *fdt = xmalloc(BAD_OVERLAY_SIZE);
+
+	CHECK(fdt_create(fdt, BAD_OVERLAY_SIZE));
+	CHECK(fdt_finish_reservemap(fdt));
+	CHECK(fdt_begin_node(fdt, ""));
+	CHECK(fdt_begin_node(fdt, "fragment@0"));
+	CHECK(fdt_property_string(fdt, "target-path", "/no-such-node"));
+	CHECK(fdt_begin_node(fdt, "__overlay__"));
+	CHECK(fdt_property_u32(fdt, "never-applied", 1));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_finish(fdt));
+
+	return fdt;
+}
+
+int main(int argc, char *argv[])
+{
+	const void **fdtos;
+	void *fdt, *merged, *buf, *idx, *ws, *bad;
+	const char *path, *name;
+	int count, size, idxsize, wssize, prop, len, i, failed, ret;
+
+	test_init(argc, argv);
+	if (argc < 3)
+		CONFIG("Usage: %s <base dtb> <overlay dtb>...", argv[0]);
+
+	fdt = load_blob(argv[1]);
+	count = argc - 2;
+	fdtos = xmalloc((count + 1) * sizeof(*fdtos));
+	for (i = 0; i < count; i++)
+		fdtos[i] = load_blob(argv[i + 2]);
+
+	size = fdt_overlay_merged_size(fdt, fdtos, count);
+	if (size < 0)
+		FAIL("fdt_overlay_merged_size(): %s", fdt_strerror(size));
+
+	/* Apply the overlays one at a time, for comparison */
+	merged = fdt;
+	for (i = 0; i < count; i++) {
+		idxsize = fdt_overlay_index_size(merged, fdtos[i]);
+		if (idxsize < 0)
+			FAIL("fdt_overlay_index_size(): %s",
+			     fdt_strerror(idxsize));
+		idx = xmalloc(idxsize);
+		buf = xmalloc(size);
+		CHECK(fdt_overlay_apply_into(merged, fdtos[i], idx, idxsize,
+					     buf, size));
+		free(idx);
+		if (merged != fdt)
+			free(merged);
+		merged = buf;
+	}
+	CHECK(fdt_pack(merged));
+
+	/*
+	 * The batch must fit the workspace and buffer it asks for, even
+	 * though the symbols' paths grow
+	 */
+	wssize = fdt_overlay_apply_many_size(fdt, fdtos, count);
+	if (wssize < 0)
+		FAIL("fdt_overlay_apply_many_size(): %s",
+		     fdt_strerror(wssize));
+	ws = xmalloc(wssize);
+	buf = xmalloc(size);
+	if (fdt_overlay_apply_many(fdt, fdtos, count, ws, wssize - 1,
+				   buf, size, NULL) != -FDT_ERR_NOSPACE)
+		FAIL("fdt_overlay_apply_many() accepted a short workspace");
+	CHECK(fdt_overlay_apply_many(fdt, fdtos, count, ws, wssize,
+				     buf, size, NULL));
+
+	if ((fdt_totalsize(buf) != fdt_totalsize(merged))
+	    || (memcmp(buf, merged, fdt_totalsize(merged)) != 0))
+		FAIL("Batch overlay application gave a different tree");
+
+	/* Every symbol must name a node of the merged tree */
+	fdt_for_each_property_offset(prop, buf,
+				     fdt_path_offset(buf, "/__symbols__")) {
+		path = fdt_getprop_by_offset(buf, prop, &name, &len);
+		if (!path || (fdt_path_offset(buf, path) < 0))
+			FAIL("Symbol \"%s\" does not resolve", name);
+	}
+
+	/* A failure must be pinned on the overlay which caused it */
+	fdtos[count] = bad = build_bad_overlay();
+	free(ws);
+	wssize = fdt_overlay_apply_many_size(fdt, fdtos, count + 1);
+	if (wssize < 0)
+		FAIL("fdt_overlay_apply_many_size(): %s",
+		     fdt_strerror(wssize));
+	ws = xmalloc(wssize);
+	ret = fdt_overlay_apply_many(fdt, fdtos, count + 1, ws, wssize,
+				     buf, size, &failed);
+	if (ret != -FDT_ERR_NOTFOUND)
+		FAIL("Applying a bad overlay returned \"%s\"",
+		     fdt_strerror(ret));
+	if (failed != count)
+		FAIL("Failure blamed on overlay %d instead of %d",
+		     failed, count);
+
+	free(bad);
+	free(buf);
+	free(ws);
+	free(merged);
+	free(fdtos);
+	PASS();
+}
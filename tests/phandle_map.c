@@ -0,0 +1,158 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for the fdt_phandle_map_*() functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+#define PHANDLE_3	0x3000
+#define SPACE		4096
+
+static void check_search(void *fdt, void *map, uint32_t phandle, int target)
+{
+	int offset;
+
+	offset = fdt_phandle_map_node_offset(fdt, map, phandle);
+	if (offset != target)
+		FAIL("fdt_phandle_map_node_offset(0x%x) returns %d "
+		     "instead of %d", phandle, offset, target);
+}
+
+/* Every node's phandle must map back to it */
+static void check_map(void *fdt, void *map)
+{
+	uint32_t max;
+	int offset;
+
+	for (offset = 0; offset >= 0; offset = fdt_next_node(fdt, offset, NULL)) {
+		uint32_t phandle = fdt_get_phandle(fdt, offset);
+
+		if (phandle)
+			check_search(fdt, map, phandle, offset);
+	}
+
+	max = fdt_phandle_map_get_max_phandle(fdt, map);
+	if (max != fdt_get_max_phandle(fdt))
+		FAIL("fdt_phandle_map_get_max_phandle() returns 0x%x "
+		     "instead of 0x%x", max, fdt_get_max_phandle(fdt));
+}
+
+static void *build_map(void *fdt, int extra)
+{
+	void *map;
+	int size, err;
+
+	size = fdt_phandle_map_size(fdt, extra);
+	if (size < 0)
+		FAIL("fdt_phandle_map_size(): %s", fdt_strerror(size));
+	map = xmalloc(size);
+	err = fdt_phandle_map_build(fdt, map, size);
+	if (err)
+		FAIL("fdt_phandle_map_build(): %s", fdt_strerror(err));
+
+	return map;
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt, *buf, *map;
+	int subnode1_offset, subnode2_offset, subsubnode2_offset;
+	int old, len, err;
+
+	test_init(argc, argv);
+	fdt = load_blob_arg(argc, argv);
+
+	map = build_map(fdt, 0);
+
+	subnode2_offset = fdt_path_offset(fdt, "/subnode@2");
+	subsubnode2_offset = fdt_path_offset(fdt, "/subnode@2/subsubnode@0");
+	if ((subnode2_offset < 0) || (subsubnode2_offset < 0))
+		FAIL("Can't find required nodes");
+
+	check_search(fdt, map, PHANDLE_1, subnode2_offset);
+	check_search(fdt, map, PHANDLE_2, subsubnode2_offset);
+	check_search(fdt, map, ~PHANDLE_1, -FDT_ERR_NOTFOUND);
+	check_search(fdt, map, 0, -FDT_ERR_BADPHANDLE);
+	check_search(fdt, map, -1, -FDT_ERR_BADPHANDLE);
+	check_search(fdt, NULL, PHANDLE_2, subsubnode2_offset);
+	check_map(fdt, map);
+
+	err = fdt_phandle_map_build(fdt, map, 16);
+	if (err != -FDT_ERR_NOSPACE)
+		FAIL("fdt_phandle_map_build() with short buffer returns %d",
+		     err);
+	free(map);
+
+	/* Now keep the map up to date while editing the tree */
+	len = fdt_totalsize(fdt) + SPACE;
+	buf = xmalloc(len);
+	err = fdt_open_into(fdt, buf, len);
+	if (err)
+		FAIL("fdt_open_into(): %s", fdt_strerror(err));
+	fdt = buf;
+	map = build_map(fdt, 1);
+
+	/* Grow the root node, which moves everything else */
+	old = fdt_size_dt_struct(fdt);
+	err = fdt_setprop_string(fdt, 0, "padding", TEST_STRING_1);
+	if (err)
+		FAIL("fdt_setprop_string(): %s", fdt_strerror(err));
+	err = fdt_phandle_map_shift(map, 0, fdt_size_dt_struct(fdt) - old);
+	if (err)
+		FAIL("fdt_phandle_map_shift(): %s", fdt_strerror(err));
+	check_map(fdt, map);
+
+	/* Give another node a phandle */
+	subnode1_offset = fdt_path_offset(fdt, "/subnode@1");
+	old = fdt_size_dt_struct(fdt);
+	err = fdt_setprop_u32(fdt, subnode1_offset, "phandle", PHANDLE_3);
+	if (err)
+		FAIL("fdt_setprop_u32(): %s", fdt_strerror(err));
+	err = fdt_phandle_map_shift(map, subnode1_offset,
+				    fdt_size_dt_struct(fdt) - old);
+	if (err)
+		FAIL("fdt_phandle_map_shift(): %s", fdt_strerror(err));
+	err = fdt_phandle_map_set(map, PHANDLE_3, subnode1_offset);
+	if (err)
+		FAIL("fdt_phandle_map_set(): %s", fdt_strerror(err));
+	check_search(fdt, map, PHANDLE_3, subnode1_offset);
+	check_map(fdt, map);
+
+	/* Delete the subtree containing both original phandles */
+	subnode2_offset = fdt_path_offset(fdt, "/subnode@2");
+	len = fdt_index_node_end_offset(fdt, NULL, subnode2_offset)
+		- subnode2_offset;
+	err = fdt_del_node(fdt, subnode2_offset);
+	if (err)
+		FAIL("fdt_del_node(): %s", fdt_strerror(err));
+	err = fdt_phandle_map_del_node(map, subnode2_offset, len);
+	if (err)
+		FAIL("fdt_phandle_map_del_node(): %s", fdt_strerror(err));
+	check_search(fdt, map, PHANDLE_1, -FDT_ERR_NOTFOUND);
+	check_search(fdt, map, PHANDLE_2, -FDT_ERR_NOTFOUND);
+	check_map(fdt, map);
+
+	free(map);
+	PASS();
+}
@@ -117,6 +117,11 @@ int main(int argc, char *argv[])
 	if ((h5 == h4) || (h5 == h2) || (h5 == h1))
 		FAIL("/node5 has duplicate phandle, 0x%x", h5);
 
+	/* Implicit phandles are allocated from the lowest unused value */
+	if ((fdt_get_phandle(fdt, 0) != 0x2) || (h4 != 0x3) || (h5 != 0x4))
+		FAIL("Implicit phandles 0x%x, 0x%x, 0x%x instead of 0x2, 0x3, 0x4",
+		     fdt_get_phandle(fdt, 0), h4, h5);
+
 	check_ref(fdt, n1, h2);
 	check_ref(fdt, n2, h1);
 	check_ref(fdt, n3, h4);
@@ -205,6 +205,10 @@ libfdt_overlay_tests () {
 
     run_test overlay overlay_base_manual_symbols.test.dtb overlay_overlay_manual_fixups.test.dtb
 
+    # Local fixups need not be laid out in tree order
+    run_dtc_test -I dts -O dtb -o overlay_overlay_local_fixups_unordered.test.dtb overlay_overlay_local_fixups_unordered.dts
+    run_test overlay overlay_base_manual_symbols.test.dtb overlay_overlay_local_fixups_unordered.test.dtb
+
     # Bad fixup tests
     for test in $BAD_FIXUP_TREES; do
 	tree="overlay_bad_fixup_$test"
@@ -228,6 +232,12 @@ dtc_overlay_tests () {
 
     run_test overlay overlay_base.test.dtb overlay_overlay.test.dtb
 
+    # Apply a batch of overlays, adding symbols below a deep node
+    run_dtc_test -@ -I dts -O dtb -o overlay_many_base.test.dtb overlay_many_base.dts
+    run_dtc_test -@ -I dts -O dtb -o overlay_many_deep.test.dtb overlay_many_deep.dts
+    run_dtc_test -@ -I dts -O dtb -o overlay_many_trivial.test.dtb overlay_many_trivial.dts
+    run_test overlay_many overlay_many_base.test.dtb overlay_many_deep.test.dtb overlay_many_trivial.test.dtb
+
     # test plugin source to dtb and back
     run_dtc_test -I dtb -O dts -o overlay_overlay_decompile.test.dts overlay_overlay.test.dtb
     run_dtc_test -I dts -O dtb -o overlay_overlay_decompile.test.dtb overlay_overlay_decompile.test.dts
@@ -252,6 +262,7 @@ tree1_tests () {
     run_test path_offset $TREE
     run_test get_name $TREE
     run_test getprop $TREE
+    run_test getprop_by_stroff $TREE
     run_test get_phandle $TREE
     run_test get_path $TREE
     run_test supernode_atdepth_offset $TREE
@@ -260,7 +271,9 @@ tree1_tests () {
     run_test node_offset_by_phandle $TREE
     run_test node_check_compatible $TREE
     run_test node_offset_by_compatible $TREE
+    run_test match_compatible $TREE
     run_test notfound $TREE
+    run_test index_lookup $TREE
 
     # Write-in-place tests
     run_test setprop_inplace $TREE
@@ -276,6 +289,8 @@ tree1_tests_rw () {
     run_test setprop $TREE
     run_test del_property $TREE
     run_test del_node $TREE
+    run_test phandle_map $TREE
+    run_test txn_edit $TREE
 }
 
 check_tests () {
@@ -371,6 +386,7 @@ libfdt_tests () {
 
     # Tests for behaviour on various sorts of corrupted trees
     run_test truncated_property
+    run_test trusted_walk
 
     # Check aliases support in fdt_path_offset
     run_dtc_test -I dts -O dtb -o aliases.dtb aliases.dts
@@ -447,6 +463,29 @@ dtc_tests () {
     run_dtc_test -I dts -O dtb -o includes.test.dtb include0.dts
     run_test dtbs_equal_ordered includes.test.dtb test_tree1.dtb
 
+    # Check that includes replayed from the include cache give the same tree
+    rm -rf tmp.include_cache
+    for n in 1 2; do
+	run_dtc_test -C tmp.include_cache -I dts -O dtb -o includes.$n.test.dtb include0.dts
+	run_test dtbs_equal_ordered includes.$n.test.dtb test_tree1.dtb
+	run_dtc_test -C tmp.include_cache -d tmp.include_cache.$n.d -I dts -O dtb -o include_cache.test.dtb include_cache.dts
+	run_wrap_test cp include_cache.test.dtb include_cache.$n.test.dtb
+    done
+    run_dtc_test -d tmp.include_cache.0.d -I dts -O dtb -o include_cache.test.dtb include_cache.dts
+    run_wrap_test cmp include_cache.test.dtb include_cache.1.test.dtb
+    run_wrap_test cmp include_cache.test.dtb include_cache.2.test.dtb
+    run_wrap_test cmp tmp.include_cache.0.d tmp.include_cache.1.d
+    run_wrap_test cmp tmp.include_cache.0.d tmp.include_cache.2.d
+    printf "%s\n" "/dts-v1/;" "/include/ \"tmp.include_cache_a.dtsi\"" > tmp.include_cache.dts
+    printf "%s\n" "/ { a = \"a\"; };" "/include/ \"tmp.include_cache_b.dtsi\"" > tmp.include_cache_a.dtsi
+    printf "%s\n" "/ { b = \"1\"; };" > tmp.include_cache_b.dtsi
+    run_dtc_test -C tmp.include_cache -I dts -O dts -o tmp.include_cache.1.dts tmp.include_cache.dts
+    printf "%s\n" "/ { b = \"2\"; };" > tmp.include_cache_b.dtsi
+    run_dtc_test -C tmp.include_cache -I dts -O dts -o tmp.include_cache.2.dts tmp.include_cache.dts
+    run_dtc_test -I dts -O dts -o tmp.include_cache.3.dts tmp.include_cache.dts
+    run_wrap_test cmp tmp.include_cache.2.dts tmp.include_cache.3.dts
+    rm -rf tmp.include_cache
+
     # Check /incbin/ directive
     run_dtc_test -I dts -O dtb -o incbin.test.dtb incbin.dts
     run_test incbin incbin.test.dtb
@@ -484,6 +523,16 @@ dtc_tests () {
 	run_wrap_test cmp oasm_$tree.test.dtb $tree.test.dtb
     done
 
+    run_dtc_test -I dts -O dtb -o string_suffixes.test.dtb string_suffixes.dts
+    run_dtc_test -T -I dts -O dtb -o string_suffixes_shared.test.dtb string_suffixes.dts
+    run_test dtbs_equal_ordered string_suffixes.test.dtb string_suffixes_shared.test.dtb
+    run_wrap_test sh -c 'test $(wc -c < string_suffixes_shared.test.dtb) -lt $(wc -c < string_suffixes.test.dtb)'
+
+    run_dtc_test -T -I dts -O asm -o oasm_string_suffixes.test.s string_suffixes.dts
+    asm_to_so_test oasm_string_suffixes
+    run_test asm_tree_dump ./oasm_string_suffixes.test.so oasm_string_suffixes.test.dtb
+    run_wrap_test cmp oasm_string_suffixes.test.dtb string_suffixes_shared.test.dtb
+
     run_test value-labels ./oasm_value-labels.dts.test.so
 
     # Check -Odts mode preserve all dtb information
@@ -528,6 +577,9 @@ dtc_tests () {
     run_dtc_test -I dts -O dts -o delete_reinstate_multilabel.dts.test.dts delete_reinstate_multilabel.dts
     run_wrap_test cmp delete_reinstate_multilabel.dts.test.dts delete_reinstate_multilabel_ref.dts
 
+    run_dtc_test -I dts -O dts -o merge_many.test.dts merge_many.dts
+    run_wrap_test cmp merge_many.test.dts merge_many_ref.dts
+
     # Check some checks
     check_tests dup-nodename.dts duplicate_node_names
     check_tests dup-propname.dts duplicate_property_names
@@ -576,6 +628,30 @@ dtc_tests () {
     run_sh_test dtc-fails.sh -n test-negation-4.test.dtb -Esize_cells_is_cell -Eno_size_cells_is_cell -I dts -O dtb bad-ncells.dts
     run_sh_test dtc-checkfails.sh size_cells_is_cell -- -Esize_cells_is_cell -Eno_size_cells_is_cell -I dts -O dtb bad-ncells.dts
 
+    # Check that running the checks in parallel changes nothing
+    run_dtc_test -j4 -I dts -O dtb -o dtc_tree1_j4.test.dtb test_tree1.dts
+    run_wrap_test cmp dtc_tree1_j4.test.dtb dtc_tree1.test.dtb
+    for tree in bad-ncells.dts overlay_overlay_manual_fixups.dts; do
+	run_wrap_test sh -c "$DTC -I dts -O dtb -o /dev/null $tree 2> tmp.$tree.j1.log; \
+	    $DTC -j4 -I dts -O dtb -o /dev/null $tree 2> tmp.$tree.j4.log; \
+	    cmp tmp.$tree.j1.log tmp.$tree.j4.log"
+    done
+
+    # Check that batch compiles match single ones
+    printf "%s\n" "# input output" "" \
+	"test_tree1.dts tmp.batch.tree1.dtb" \
+	"references.dts	tmp.batch.references.dtb" \
+	"test_tree1.dts tmp.batch.tree1.dts" > tmp.batch.manifest
+    run_dtc_test -j2 -B tmp.batch.manifest
+    run_wrap_test cmp tmp.batch.tree1.dtb dtc_tree1.test.dtb
+    run_wrap_test cmp tmp.batch.references.dtb dtc_references.test.dtb
+    run_dtc_test -I dts -O dts -o batch_tree1.test.dts test_tree1.dts
+    run_wrap_test cmp tmp.batch.tree1.dts batch_tree1.test.dts
+    printf "%s\n" "test_tree1.dts tmp.batch.tree1.dtb" \
+	"nonexist.dts tmp.batch.nonexist.dtb" > tmp.batch_fail.manifest
+    run_wrap_error_test $DTC -B tmp.batch_fail.manifest
+    run_wrap_error_test $DTC -B tmp.batch.manifest -o tmp.batch.dtb
+
     # Check for proper behaviour reading from stdin
     run_dtc_test -I dts -O dtb -o stdin_dtc_tree1.test.dtb - < test_tree1.dts
     run_wrap_test cmp stdin_dtc_tree1.test.dtb dtc_tree1.test.dtb
@@ -806,6 +882,22 @@ fdtoverlay_tests() {
 
     # test that baz correctly inserted the property
     run_fdtoverlay_test baz "/foonode/barnode/baznode" "baz-property" "-ts" ${stacked_basedtb} ${stacked_targetdtb} ${stacked_bardtb} ${stacked_bazdtb}
+
+    many_basedtb=overlay_many_base.fdtoverlay.test.dtb
+    many_deepdtb=overlay_many_deep.fdtoverlay.test.dtb
+    many_trivialdtb=overlay_many_trivial.fdtoverlay.test.dtb
+    many_targetdtb=overlay_many_target.fdtoverlay.test.dtb
+    many_node=""
+    for level in first second third fourth fifth sixth seventh eighth; do
+	many_node="$many_node/$level-level-node-with-a-long-name"
+    done
+
+    run_dtc_test -@ -I dts -O dtb -o $many_basedtb overlay_many_base.dts
+    run_dtc_test -@ -I dts -O dtb -o $many_deepdtb overlay_many_deep.dts
+    run_dtc_test -@ -I dts -O dtb -o $many_trivialdtb overlay_many_trivial.dts
+
+    # test that the merged tree has room for symbols below a deep node
+    run_fdtoverlay_test present "$many_node/child-23" "second-overlay-property" "-ts" ${many_basedtb} ${many_targetdtb} ${many_deepdtb} ${many_trivialdtb}
 }
 
 pylibfdt_tests () {
@@ -0,0 +1,252 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for fdt_check_full() and the *_trusted() functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+#define SPACE		(4 * 1024 * 1024)
+#define NUM_CHILDREN	64
+#define NUM_GRANDCHILDREN	64
+#define BENCH_LOOPS	20
+
+#define CHECK(code) \
+	{ \
+		err = (code); \
+		if (err) \
+			FAIL(#code ": %s", fdt_strerror(err)); \
+	}
+
+static void *build_big_tree(void)
+{
+	char name[32];
+	void *fdt;
+	int i, j, err;
+
+	fdt = xmalloc(SPACE);
+	CHECK(fdt_create(fdt, SPACE));
+	CHECK(fdt_finish_reservemap(fdt));
+	CHECK(fdt_begin_node(fdt, ""));
+	CHECK(fdt_property_string(fdt, "compatible", "test-trusted-walk"));
+	for (i = 0; i < NUM_CHILDREN; i++) {
+		snprintf(name, sizeof(name), "bus-with-a-long-name@%x", i);
+		CHECK(fdt_begin_node(fdt, name));
+		CHECK(fdt_property_u32(fdt, "#address-cells", 1));
+		CHECK(fdt_property_u32(fdt, "#size-cells", 0));
+		for (j = 0; j < NUM_GRANDCHILDREN; j++) {
+			snprintf(name, sizeof(name), "device-node@%x", j);
+			CHECK(fdt_begin_node(fdt, name));
+			CHECK(fdt_property_u32(fdt, "reg", j));
+			CHECK(fdt_property_string(fdt, "status", "okay"));
+			CHECK(fdt_property_string(fdt, "compatible",
+						  "vendor,device"));
+			CHECK(fdt_end_node(fdt));
+		}
+		CHECK(fdt_end_node(fdt));
+	}
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_finish(fdt));
+
+	return fdt;
+}
+
+static void check_tags(const void *fdt)
+{
+	int offset = 0, next, tnext;
+	uint32_t tag, ttag;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		ttag = fdt_next_tag_trusted(fdt, offset, &tnext);
+		if ((tag != ttag) || (next != tnext))
+			FAIL("Tag mismatch at %d: %u/%d vs. trusted %u/%d",
+			     offset, tag, next, ttag, tnext);
+		offset = next;
+	} while (tag != FDT_END);
+}
+
+static void check_node(const void *fdt, int node)
+{
+	const char *name, *pname;
+	const void *val, *tval;
+	int sub, tsub, len, tlen, off;
+
+	/* Subnode iteration and lookup by name */
+	sub = fdt_first_subnode(fdt, node);
+	tsub = fdt_first_subnode_trusted(fdt, node);
+	while (sub >= 0) {
+		if (sub != tsub)
+			FAIL("Subnode mismatch under %d: %d vs. trusted %d",
+			     node, sub, tsub);
+		name = fdt_get_name(fdt, sub, &len);
+		tsub = fdt_subnode_offset_namelen_trusted(fdt, node, name,
+							  len);
+		if (tsub != fdt_subnode_offset_namelen(fdt, node, name, len))
+			FAIL("fdt_subnode_offset_namelen_trusted(%d, \"%s\")"
+			     " gave %d", node, name, tsub);
+
+		sub = fdt_next_subnode(fdt, sub);
+		tsub = fdt_next_subnode_trusted(fdt, tsub);
+	}
+	if (tsub != sub)
+		FAIL("Trusted subnode iteration under %d ended with %d",
+		     node, tsub);
+
+	tsub = fdt_subnode_offset_trusted(fdt, node, "no-such-node");
+	if (tsub != -FDT_ERR_NOTFOUND)
+		FAIL("fdt_subnode_offset_trusted() found missing node at %d",
+		     tsub);
+
+	/* Property lookup by name */
+	fdt_for_each_property_offset(off, fdt, node) {
+		val = fdt_getprop_by_offset(fdt, off, &pname, &len);
+		tval = fdt_getprop_trusted(fdt, node, pname, &tlen);
+		if ((tval != val) || (tlen != len))
+			FAIL("fdt_getprop_trusted(%d, \"%s\") mismatch",
+			     node, pname);
+	}
+
+	tval = fdt_getprop_trusted(fdt, node, "no-such-prop", &tlen);
+	if (tval || (tlen != -FDT_ERR_NOTFOUND))
+		FAIL("fdt_getprop_trusted() found missing property");
+}
+
+static void check_walk(const void *fdt)
+{
+	int node, tnode, depth = 0, tdepth = 0;
+	int err;
+
+	CHECK(fdt_check_full(fdt, fdt_totalsize(fdt)));
+
+	check_tags(fdt);
+
+	node = fdt_next_node(fdt, -1, &depth);
+	tnode = fdt_next_node_trusted(fdt, -1, &tdepth);
+	while (node >= 0) {
+		if ((node != tnode) || (depth != tdepth))
+			FAIL("Node mismatch: %d/%d vs. trusted %d/%d",
+			     node, depth, tnode, tdepth);
+		check_node(fdt, node);
+		node = fdt_next_node(fdt, node, &depth);
+		tnode = fdt_next_node_trusted(fdt, tnode, &tdepth);
+	}
+	if (tnode != node)
+		FAIL("Trusted node walk ended with %d instead of %d",
+		     tnode, node);
+}
+
+static void check_bad(const void *fdt, size_t bufsize, int experr)
+{
+	int err = fdt_check_full(fdt, bufsize);
+
+	if (err != experr)
+		FAIL("fdt_check_full() returned \"%s\" instead of \"%s\"",
+		     fdt_strerror(err), fdt_strerror(experr));
+}
+
+static double elapsed(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void bench(const void *fdt)
+{
+	clock_t start;
+	int i, offset, count = 0;
+	const char *name = "bus-with-a-long-name@3f";
+
+	start = clock();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		for (offset = fdt_next_node(fdt, -1, NULL); offset >= 0;
+		     offset = fdt_next_node(fdt, offset, NULL))
+			count++;
+	verbose_printf("fdt_next_node() walk:         %.3fs\n",
+		       elapsed(start));
+
+	start = clock();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		for (offset = fdt_next_node_trusted(fdt, -1, NULL);
+		     offset >= 0;
+		     offset = fdt_next_node_trusted(fdt, offset, NULL))
+			count--;
+	verbose_printf("fdt_next_node_trusted() walk: %.3fs\n",
+		       elapsed(start));
+
+	start = clock();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		count += fdt_subnode_offset(fdt, 0, name) > 0;
+	verbose_printf("fdt_subnode_offset():         %.3fs\n",
+		       elapsed(start));
+
+	start = clock();
+	for (i = 0; i < BENCH_LOOPS; i++)
+		count -= fdt_subnode_offset_trusted(fdt, 0, name) > 0;
+	verbose_printf("fdt_subnode_offset_trusted(): %.3fs\n",
+		       elapsed(start));
+
+	if (count != 0)
+		FAIL("Checked and trusted benchmark walks disagree");
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt, *big;
+	struct fdt_property *prop;
+	int offset, err;
+
+	test_init(argc, argv);
+
+	check_walk(&_test_tree1);
+
+	big = build_big_tree();
+	check_walk(big);
+	bench(big);
+
+	/* The blob must fit in the buffer */
+	check_bad(big, fdt_totalsize(big) - 1, -FDT_ERR_TRUNCATED);
+
+	/* A property name outside the strings block */
+	fdt = xmalloc(fdt_totalsize(&_test_tree1));
+	memcpy(fdt, &_test_tree1, fdt_totalsize(&_test_tree1));
+	offset = fdt_first_property_offset(fdt, 0);
+	if (offset < 0)
+		FAIL("fdt_first_property_offset(): %s", fdt_strerror(offset));
+	prop = fdt_offset_ptr_w(fdt, offset, sizeof(*prop));
+	prop->nameoff = cpu_to_fdt32(fdt_size_dt_strings(fdt));
+	check_bad(fdt, fdt_totalsize(fdt), -FDT_ERR_BADSTRUCTURE);
+
+	/* Property data running off the end of the structure block */
+	check_bad(&_truncated_property, fdt_totalsize(&_truncated_property),
+		  -FDT_ERR_BADSTRUCTURE);
+
+	/* An unfinished sequential-write tree */
+	CHECK(fdt_create(big, SPACE));
+	CHECK(fdt_finish_reservemap(big));
+	check_bad(big, SPACE, -FDT_ERR_BADSTATE);
+
+	free(fdt);
+	free(big);
+	PASS();
+}
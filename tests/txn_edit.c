@@ -0,0 +1,417 @@
+/*
+ * libfdt - Flat Device Tree manipulation
+ *	Testcase for the fdt_txn_*() transactional editing functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <libfdt.h>
+
+#include "tests.h"
+#include "testdata.h"
+
+#define SPACE		65536
+#define TXN_SPACE	4096
+
+#define CHECK(code) \
+	{ \
+		err = (code); \
+		if (err < 0) \
+			FAIL(#code ": %s", fdt_strerror(err)); \
+	}
+
+#define CHECK_ERR(code, experr) \
+	{ \
+		err = (code); \
+		if (err != -(experr)) \
+			FAIL(#code " returned %d instead of %s", err, \
+			     fdt_strerror(-(experr))); \
+	}
+
+static void *base, *rw, *txn;
+
+static int path(const void *fdt, const char *p)
+{
+	int offset = fdt_path_offset(fdt, p);
+
+	if (offset < 0)
+		FAIL("fdt_path_offset(\"%s\"): %s", p, fdt_strerror(offset));
+	return offset;
+}
+
+/* Compare two trees, ignoring the layout of their strings blocks */
+static void compare_trees(const void *a, const void *b)
+{
+	int offa = 0, offb = 0, nexta, nextb;
+	uint64_t addra, sizea, addrb, sizeb;
+	uint32_t taga, tagb;
+	const void *vala, *valb;
+	const char *namea, *nameb;
+	int lena, lenb, i;
+
+	if (fdt_num_mem_rsv(a) != fdt_num_mem_rsv(b))
+		FAIL("Reserve map sizes differ");
+	for (i = 0; i < fdt_num_mem_rsv(a); i++) {
+		fdt_get_mem_rsv(a, i, &addra, &sizea);
+		fdt_get_mem_rsv(b, i, &addrb, &sizeb);
+		if ((addra != addrb) || (sizea != sizeb))
+			FAIL("Reserve map entry %d differs", i);
+	}
+
+	do {
+		do {
+			taga = fdt_next_tag(a, offa, &nexta);
+			if (taga == FDT_NOP)
+				offa = nexta;
+		} while (taga == FDT_NOP);
+		do {
+			tagb = fdt_next_tag(b, offb, &nextb);
+			if (tagb == FDT_NOP)
+				offb = nextb;
+		} while (tagb == FDT_NOP);
+
+		if (taga != tagb)
+			FAIL("Tag %u at %d differs from %u at %d",
+			     taga, offa, tagb, offb);
+
+		if (taga == FDT_BEGIN_NODE) {
+			namea = fdt_get_name(a, offa, NULL);
+			nameb = fdt_get_name(b, offb, NULL);
+			if (strcmp(namea, nameb) != 0)
+				FAIL("Node \"%s\" at %d differs from \"%s\" at %d",
+				     namea, offa, nameb, offb);
+		} else if (taga == FDT_PROP) {
+			vala = fdt_getprop_by_offset(a, offa, &namea, &lena);
+			valb = fdt_getprop_by_offset(b, offb, &nameb, &lenb);
+			if (strcmp(namea, nameb) != 0)
+				FAIL("Property \"%s\" at %d differs from \"%s\" at %d",
+				     namea, offa, nameb, offb);
+			if ((lena != lenb) || (memcmp(vala, valb, lena) != 0))
+				FAIL("Value of \"%s\" differs", namea);
+		}
+
+		offa = nexta;
+		offb = nextb;
+	} while (taga != FDT_END);
+}
+
+static void check_rollback(void)
+{
+	void *out = xmalloc(SPACE);
+	int err;
+
+	CHECK(fdt_txn_init(base, txn, TXN_SPACE));
+	CHECK(fdt_txn_setprop(base, txn, 0, "rolled-back", "x", 2));
+	CHECK(fdt_txn_del_node(base, txn, path(base, "/subnode@1")));
+	CHECK(fdt_txn_rollback(txn));
+	CHECK(fdt_txn_commit(base, txn, out, SPACE));
+	compare_trees(base, out);
+
+	/* A committed transaction is closed */
+	CHECK_ERR(fdt_txn_setprop(base, txn, 0, "late", "", 0),
+		  FDT_ERR_BADVALUE);
+
+	free(out);
+}
+
+/* Enough edits to one node that the journal's index has long chains */
+#define MANY_PROPS	400
+
+static void check_many_edits(void)
+{
+	void *bigtxn = xmalloc(SPACE), *out = xmalloc(SPACE);
+	char name[16];
+	int node, rwnode, i, err;
+
+	CHECK(fdt_open_into(base, rw, SPACE));
+	CHECK(fdt_txn_init(base, bigtxn, SPACE));
+
+	CHECK(rwnode = fdt_add_subnode(rw, 0, "many"));
+	CHECK(node = fdt_txn_add_subnode(base, bigtxn, 0, "many"));
+	for (i = 0; i < MANY_PROPS; i++) {
+		snprintf(name, sizeof(name), "prop%d", i);
+		CHECK(fdt_txn_setprop(base, bigtxn, node, name, &i,
+				      sizeof(i)));
+		CHECK(fdt_setprop(rw, rwnode, name, &i, sizeof(i)));
+	}
+	for (i = 0; i < MANY_PROPS; i += 2) {
+		snprintf(name, sizeof(name), "prop%d", i);
+		CHECK(fdt_delprop(rw, rwnode, name));
+		CHECK(fdt_txn_delprop(base, bigtxn, node, name));
+		CHECK_ERR(fdt_txn_delprop(base, bigtxn, node, name),
+			  FDT_ERR_NOTFOUND);
+	}
+	CHECK_ERR(fdt_txn_add_subnode(base, bigtxn, 0, "many"),
+		  FDT_ERR_EXISTS);
+
+	CHECK(fdt_txn_commit(base, bigtxn, out, SPACE));
+	compare_trees(rw, out);
+
+	free(out);
+	free(bigtxn);
+}
+
+/*
+ * A tree big enough for the cost of the commit to show: many nodes,
+ * sharing property names from a strings block of a few kilobytes.
+ */
+#define BIG_SPACE	(1024 * 1024)
+#define BIG_NODES	500
+#define BIG_NAMES	150
+#define BENCH_PROPS	2000
+
+static void big_prop_name(char *name, int size, int i, int j)
+{
+	snprintf(name, size, "vendor,some-property-name-%d",
+		 (i * 10 + j) % BIG_NAMES);
+}
+
+static void *build_big_tree(void)
+{
+	char name[40];
+	void *fdt = xmalloc(BIG_SPACE);
+	int i, j, err;
+
+	CHECK(fdt_create(fdt, BIG_SPACE));
+	CHECK(fdt_finish_reservemap(fdt));
+	CHECK(fdt_begin_node(fdt, ""));
+	for (i = 0; i < BIG_NODES; i++) {
+		snprintf(name, sizeof(name), "node@%x", i);
+		CHECK(fdt_begin_node(fdt, name));
+		for (j = 0; j < 10; j++) {
+			big_prop_name(name, sizeof(name), i, j);
+			CHECK(fdt_property_u32(fdt, name, j));
+		}
+		CHECK(fdt_end_node(fdt));
+	}
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_finish(fdt));
+	CHECK(fdt_open_into(fdt, fdt, BIG_SPACE));
+
+	return fdt;
+}
+
+static double elapsed(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*
+ * Many properties added to the root and to one node, and others
+ * changed throughout the tree: the commit should cost about a copy of
+ * the tree, where each direct edit moves the rest of the tree along,
+ * and it should intern no more strings than the direct edits do.
+ */
+static void check_bench(void)
+{
+	void *big = build_big_tree(), *bigrw = xmalloc(BIG_SPACE);
+	void *bigtxn = xmalloc(BIG_SPACE), *out = xmalloc(BIG_SPACE);
+	char name[40];
+	clock_t start;
+	int node, parent, i, err;
+
+	memcpy(bigrw, big, BIG_SPACE);
+
+	start = clock();
+	for (i = 0; i < BENCH_PROPS; i++) {
+		snprintf(name, sizeof(name), "new-prop-%d", i);
+		parent = (i & 1) ? path(bigrw, "/node@11") : 0;
+		CHECK(fdt_setprop_u32(bigrw, parent, name, i));
+	}
+	i = 0;
+	fdt_for_each_subnode(node, bigrw, 0) {
+		big_prop_name(name, sizeof(name), i++, 5);
+		CHECK(fdt_setprop_string(bigrw, node, name, "changed"));
+	}
+	verbose_printf("Direct edits:        %.3fs\n", elapsed(start));
+
+	start = clock();
+	node = path(big, "/node@11");
+	CHECK(fdt_txn_init(big, bigtxn, BIG_SPACE));
+	for (i = 0; i < BENCH_PROPS; i++) {
+		fdt32_t val = cpu_to_fdt32(i);
+
+		snprintf(name, sizeof(name), "new-prop-%d", i);
+		parent = (i & 1) ? node : 0;
+		CHECK(fdt_txn_setprop(big, bigtxn, parent, name,
+				      &val, sizeof(val)));
+	}
+	i = 0;
+	fdt_for_each_subnode(node, big, 0) {
+		big_prop_name(name, sizeof(name), i++, 5);
+		CHECK(fdt_txn_setprop(big, bigtxn, node, name, "changed",
+				      sizeof("changed")));
+	}
+	CHECK(fdt_txn_commit(big, bigtxn, out, BIG_SPACE));
+	verbose_printf("Transaction edits:   %.3fs\n", elapsed(start));
+
+	compare_trees(bigrw, out);
+	if (fdt_size_dt_strings(out) > fdt_size_dt_strings(bigrw))
+		FAIL("Committed strings block is larger than with direct "
+		     "edits (%u > %u)", fdt_size_dt_strings(out),
+		     fdt_size_dt_strings(bigrw));
+
+	free(out);
+	free(bigtxn);
+	free(bigrw);
+	free(big);
+}
+
+static void check_errors(void)
+{
+	char small[64];
+	int err;
+
+	CHECK(fdt_txn_init(base, txn, TXN_SPACE));
+
+	CHECK_ERR(fdt_txn_add_subnode(base, txn, 0, "subnode@1"),
+		  FDT_ERR_EXISTS);
+	CHECK_ERR(fdt_txn_delprop(base, txn, 0, "no-such-prop"),
+		  FDT_ERR_NOTFOUND);
+	CHECK_ERR(fdt_txn_setprop(base, txn, 4, "x", "", 0),
+		  FDT_ERR_BADOFFSET);
+	CHECK_ERR(fdt_txn_setprop(base, txn, fdt_totalsize(base) + 64,
+				  "x", "", 0),
+		  FDT_ERR_BADOFFSET);
+
+	/* A full journal */
+	CHECK(fdt_txn_init(base, small, sizeof(small)));
+	CHECK_ERR(fdt_txn_setprop(base, small, 0, "too-long", small,
+				  sizeof(small)),
+		  FDT_ERR_NOSPACE);
+
+	/* A tree modified behind the journal's back */
+	CHECK(fdt_txn_init(rw, small, sizeof(small)));
+	CHECK(fdt_setprop_string(rw, 0, "behind-its-back", "x"));
+	CHECK_ERR(fdt_txn_setprop(rw, small, 0, "x", "", 0),
+		  FDT_ERR_BADVALUE);
+}
+
+int main(int argc, char *argv[])
+{
+	void *fdt, *out;
+	const fdt32_t *cell;
+	const char *str;
+	fdt32_t val = cpu_to_fdt32(42);
+	int node, child, added, err, len;
+
+	test_init(argc, argv);
+	fdt = load_blob_arg(argc, argv);
+
+	base = xmalloc(SPACE);
+	rw = xmalloc(SPACE);
+	out = xmalloc(SPACE);
+	txn = xmalloc(TXN_SPACE);
+	CHECK(fdt_open_into(fdt, base, SPACE));
+	CHECK(fdt_open_into(fdt, rw, SPACE));
+
+	check_rollback();
+	check_many_edits();
+	check_bench();
+	check_errors();
+
+	/* check_errors() edits rw */
+	CHECK(fdt_open_into(fdt, rw, SPACE));
+
+	/*
+	 * Make the same edits directly on rw and through a transaction
+	 * on base.
+	 */
+	CHECK(fdt_txn_init(base, txn, TXN_SPACE));
+
+	CHECK(fdt_setprop_string(rw, 0, "txn-new", "one"));
+	CHECK(fdt_txn_setprop(base, txn, 0, "txn-new", "one", 4));
+
+	CHECK(fdt_setprop(rw, 0, "prop-int", &val, sizeof(val)));
+	CHECK(fdt_txn_setprop(base, txn, 0, "prop-int", &val, sizeof(val)));
+
+	CHECK(fdt_delprop(rw, 0, "prop-str"));
+	CHECK(fdt_txn_delprop(base, txn, 0, "prop-str"));
+	CHECK_ERR(fdt_txn_delprop(base, txn, 0, "prop-str"),
+		  FDT_ERR_NOTFOUND);
+
+	CHECK(node = fdt_add_subnode(rw, 0, "txn-node"));
+	CHECK(fdt_setprop_string(rw, node, "a", "aaa"));
+	CHECK(child = fdt_add_subnode(rw, node, "child"));
+	CHECK(fdt_setprop_string(rw, child, "b", "bbb"));
+	CHECK(node = fdt_txn_add_subnode(base, txn, 0, "txn-node"));
+	CHECK(fdt_txn_setprop(base, txn, node, "a", "aaa", 4));
+	CHECK(child = fdt_txn_add_subnode(base, txn, node, "child"));
+	CHECK(fdt_txn_setprop(base, txn, child, "b", "bbb", 4));
+	CHECK_ERR(fdt_txn_add_subnode(base, txn, node, "child"),
+		  FDT_ERR_EXISTS);
+
+	/* Deleting and recreating a property moves it to the front */
+	CHECK(fdt_delprop(rw, path(rw, "/subnode@1"), "compatible"));
+	CHECK(fdt_setprop_string(rw, path(rw, "/subnode@1"), "compatible",
+				 "again"));
+	CHECK(fdt_txn_delprop(base, txn, path(base, "/subnode@1"),
+			      "compatible"));
+	CHECK(fdt_txn_setprop(base, txn, path(base, "/subnode@1"),
+			      "compatible", "again", 6));
+
+	/* Deleting a node, then adding one of the same name */
+	CHECK(fdt_del_node(rw, path(rw, "/subnode@2")));
+	CHECK(fdt_add_subnode(rw, 0, "subnode@2"));
+	CHECK(fdt_txn_setprop(base, txn, path(base, "/subnode@2/ss2"),
+			      "discarded", "", 0));
+	CHECK(fdt_txn_del_node(base, txn, path(base, "/subnode@2")));
+	CHECK_ERR(fdt_txn_del_node(base, txn, path(base, "/subnode@2")),
+		  FDT_ERR_NOTFOUND);
+	CHECK(fdt_txn_add_subnode(base, txn, 0, "subnode@2"));
+
+	/* A node which is added then deleted again */
+	CHECK(added = fdt_txn_add_subnode(base, txn, path(base, "/subnode@1"),
+					  "added"));
+	CHECK(fdt_txn_setprop(base, txn, added, "c", "ccc", 4));
+	CHECK(fdt_txn_del_node(base, txn, added));
+
+	CHECK(fdt_setprop(rw, path(rw, "/subnode@1/subsubnode"), "prop-int",
+			  &val, sizeof(val)));
+	CHECK(fdt_del_node(rw, path(rw, "/subnode@1/ss1")));
+	CHECK(fdt_txn_setprop(base, txn, path(base, "/subnode@1/subsubnode"),
+			      "prop-int", &val, sizeof(val)));
+	CHECK(fdt_txn_del_node(base, txn, path(base, "/subnode@1/ss1")));
+
+	/* Changing a property added in the transaction */
+	CHECK(fdt_setprop_string(rw, 0, "txn-new", "two"));
+	CHECK(fdt_txn_setprop(base, txn, 0, "txn-new", "two", 4));
+
+	/* Reads still see the tree as it was */
+	str = fdt_getprop(base, 0, "prop-str", &len);
+	if (!str || (strcmp(str, TEST_STRING_1) != 0))
+		FAIL("prop-str changed before commit");
+	cell = fdt_getprop(base, path(base, "/subnode@2"), "prop-int", &len);
+	if (!cell || (fdt32_to_cpu(*cell) != TEST_VALUE_2))
+		FAIL("/subnode@2 changed before commit");
+
+	/* Too small a buffer leaves the transaction open */
+	CHECK_ERR(fdt_txn_commit(base, txn, out, 256), FDT_ERR_NOSPACE);
+	CHECK(fdt_txn_setprop(base, txn, added, "after-retry", "", 0));
+
+	CHECK(fdt_txn_commit(base, txn, out, SPACE));
+	compare_trees(rw, out);
+
+	free(txn);
+	free(out);
+	free(rw);
+	free(base);
+	PASS();
+}
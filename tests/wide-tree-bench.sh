@@ -0,0 +1,47 @@
+#! /bin/bash
+
+# Time dtc on a synthetic tree with very wide nodes: one node with
+# <count> children, each with a handful of properties, and one node
+# with <count> properties.  This is the shape of generated trees with
+# large numbers of memory banks, PCI functions or thermal trips, and
+# shows up anything which is quadratic in the number of siblings.
+#
+# usage: wide-tree-bench.sh [count]
+#
+# Set DTC to time a different dtc binary, e.g. to compare two builds.
+
+COUNT=${1:-20000}
+DTC=${DTC:-../dtc}
+
+SRC=tmp.wide-tree.$$.dts
+trap "rm -f $SRC" 0
+
+awk -v n="$COUNT" 'BEGIN {
+	print "/dts-v1/;"
+	print "/ {"
+	print "\t#address-cells = <1>;"
+	print "\t#size-cells = <1>;"
+	print "\tprops {"
+	for (i = 0; i < n; i++)
+		printf "\t\tprop-%d = <%d>;\n", i, i
+	print "\t};"
+	print "\tbanks: banks {"
+	print "\t\t#address-cells = <1>;"
+	print "\t\t#size-cells = <1>;"
+	print "\t};"
+	print "};"
+	# Split the children up, a single block of them overflows the parser stack
+	for (i = 0; i < n; i++) {
+		if (i % 5000 == 0)
+			print "&banks {"
+		printf "\tbank@%x {\n", i * 4096
+		printf "\t\treg = <0x%x 0x1000>;\n", i * 4096
+		printf "\t\tlabel = \"bank%d\";\n", i
+		print "\t};"
+		if (i % 5000 == 4999 || i == n - 1)
+			print "};"
+	}
+}' > $SRC
+
+echo "$DTC: $COUNT children and $COUNT properties"
+time "$DTC" -q -I dts -O dtb -o /dev/null $SRC
@@ -32,6 +32,7 @@ struct dt_info *dt_from_source(const char *fname)
 {
 	parser_output = NULL;
 	treesource_error = false;
+	new_tree_arena();
 
 	srcfile_push(fname);
 	yyin = current_srcfile->f;
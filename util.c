@@ -100,6 +100,142 @@ char *join_path(const char *path, const char *name)
 	return str;
 }
 
+unsigned int strhash(const char *str)
+{
+	unsigned int h = 2166136261u;	/* FNV-1a */
+
+	while (*str)
+		h = (h ^ (unsigned char)*str++) * 16777619u;
+	return h;
+}
+
+uint64_t memhash(uint64_t h, const void *mem, size_t len)
+{
+	const unsigned char *p = mem;
+
+	while (len--)
+		h = (h ^ *p++) * 1099511628211ull;	/* 64-bit FNV-1a */
+	return h;
+}
+
+static struct strmap_entry *strmap_find(const struct strmap *map,
+					const char *key)
+{
+	unsigned int i = strhash(key) & map->mask;
+
+	while (map->slots[i].key && strcmp(map->slots[i].key, key) != 0)
+		i = (i + 1) & map->mask;
+	return &map->slots[i];
+}
+
+void *strmap_get(const struct strmap *map, const char *key)
+{
+	if (!map->slots)
+		return NULL;
+	return strmap_find(map, key)->val;
+}
+
+static void strmap_grow(struct strmap *map)
+{
+	struct strmap old = *map;
+	unsigned int i;
+
+	map->mask = old.slots ? (2 * old.mask + 1) : 63;
+	map->slots = xmalloc((map->mask + 1) * sizeof(*map->slots));
+	memset(map->slots, 0, (map->mask + 1) * sizeof(*map->slots));
+
+	for (i = 0; old.slots && (i <= old.mask); i++)
+		if (old.slots[i].key)
+			*strmap_find(map, old.slots[i].key) = old.slots[i];
+	free(old.slots);
+}
+
+void **strmap_slot(struct strmap *map, const char *key)
+{
+	struct strmap_entry *e;
+
+	if (!map->slots || (4 * (map->count + 1) > 3 * (map->mask + 1)))
+		strmap_grow(map);
+
+	e = strmap_find(map, key);
+	if (!e->key) {
+		e->key = key;
+		e->val = NULL;
+		map->count++;
+	}
+	return &e->val;
+}
+
+void strmap_free(struct strmap *map)
+{
+	free(map->slots);
+	memset(map, 0, sizeof(*map));
+}
+
+#define ARENA_CHUNK_SIZE	(64 * 1024)
+#define ARENA_ALIGN		16
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size, used;
+};
+
+#define ARENA_CHUNK_HDR \
+	((sizeof(struct arena_chunk) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+void *arena_alloc(struct arena *arena, size_t len)
+{
+	struct arena_chunk *chunk = arena->chunks;
+	size_t size;
+	void *p;
+
+	len = (len + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+	if (!chunk || (chunk->size - chunk->used < len)) {
+		size = ARENA_CHUNK_SIZE;
+		if (len > size - ARENA_CHUNK_HDR)
+			size = len + ARENA_CHUNK_HDR;
+
+		chunk = xmalloc(size);
+		chunk->size = size;
+		chunk->used = ARENA_CHUNK_HDR;
+
+		/* Keep filling the current chunk after an oversized one */
+		if (arena->chunks && (size != ARENA_CHUNK_SIZE)) {
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		} else {
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+		}
+	}
+
+	p = (char *)chunk + chunk->used;
+	chunk->used += len;
+	arena->allocated += len;
+
+	memset(p, 0, len);
+	return p;
+}
+
+char *arena_strdup(struct arena *arena, const char *s)
+{
+	size_t len = strlen(s) + 1;
+
+	return memcpy(arena_alloc(arena, len), s, len);
+}
+
+void arena_free(struct arena *arena)
+{
+	struct arena_chunk *chunk, *next;
+
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	memset(arena, 0, sizeof(*arena));
+}
+
 bool util_is_printable_string(const void *data, int len)
 {
 	const char *s = data;
@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <getopt.h>
 
 /*
@@ -71,6 +72,47 @@ extern char *xstrdup(const char *s);
 extern int PRINTF(2, 3) xasprintf(char **strp, const char *fmt, ...);
 extern char *join_path(const char *path, const char *name);
 
+/*
+ * A simple open-addressed hash table mapping strings to pointers.  Keys
+ * are not copied, so they must outlive the table.  A zeroed struct
+ * strmap is a valid empty table.
+ */
+struct strmap_entry {
+	const char *key;
+	void *val;
+};
+
+struct strmap {
+	struct strmap_entry *slots;
+	unsigned int mask;		/* number of slots - 1 */
+	unsigned int count;
+};
+
+extern unsigned int strhash(const char *str);
+/* Continues a 64-bit hash of a byte stream, starting from MEMHASH_INIT */
+#define MEMHASH_INIT	14695981039346656037ull
+extern uint64_t memhash(uint64_t h, const void *mem, size_t len);
+extern void *strmap_get(const struct strmap *map, const char *key);
+/* Returns the value slot for key, inserting it with a NULL value if absent */
+extern void **strmap_slot(struct strmap *map, const char *key);
+extern void strmap_free(struct strmap *map);
+
+/*
+ * A simple bump allocator: everything allocated from an arena is freed
+ * at once by arena_free().  A zeroed struct arena is a valid empty one.
+ */
+struct arena_chunk;
+
+struct arena {
+	struct arena_chunk *chunks;
+	size_t allocated;		/* total bytes handed out */
+};
+
+/* Returns zeroed memory */
+extern void *arena_alloc(struct arena *arena, size_t len);
+extern char *arena_strdup(struct arena *arena, const char *s);
+extern void arena_free(struct arena *arena);
+
 /**
  * Check a property of a given length to see if it is all printable and
  * has a valid terminator. The property can contain either a single string,
@@ -0,0 +1 @@
+#define DTC_VERSION "DTC 1.4.4-gffa5656d-dirty"